@@ -0,0 +1,50 @@
+#ifndef EBT_BENCH_H
+#define EBT_BENCH_H
+
+#include "ebt/timer.h"
+#include <iostream>
+#include <string>
+
+// Helpers shared by the benchmarks.  Each case is timed over a number of
+// runs with accu_timer and reported as microseconds per run, next to the
+// speedup over a baseline where there is one.
+
+namespace bench {
+
+    // Makes v look used, so that the work producing it is not removed.
+    template <class T>
+    void keep(T const& v)
+    {
+        asm volatile("" : : "r"(&v) : "memory");
+    }
+
+    template <class F>
+    double time_us(size_t runs, F f)
+    {
+        auto before = ebt::accu_timer<0>::msecs;
+
+        {
+            ebt::accu_timer<0> t;
+
+            for (size_t i = 0; i < runs; ++i) {
+                f();
+            }
+        }
+
+        return double((ebt::accu_timer<0>::msecs - before).count()) / runs;
+    }
+
+    inline void report(std::string const& name, double us)
+    {
+        std::cout << "  " << name << ": " << us << " us" << std::endl;
+    }
+
+    inline void report(std::string const& name, double us, double baseline_us)
+    {
+        std::cout << "  " << name << ": " << us << " us ("
+            << baseline_us / us << "x)" << std::endl;
+    }
+
+}
+
+#endif
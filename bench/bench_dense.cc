@@ -0,0 +1,94 @@
+#include "bench.h"
+#include "ebt/dense.h"
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+// The dense kernels against the scalar loops they replaced, on arrays
+// that fit in cache and on arrays that do not.
+
+template <class T>
+double scalar_dot(T const* x, T const* y, size_t n)
+{
+    double sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += x[i] * y[i];
+    }
+    return sum;
+}
+
+template <class T>
+void scalar_axpy(T a, T const* x, T* y, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        y[i] += a * x[i];
+    }
+}
+
+template <class T>
+double scalar_norm2(T const* x, size_t n)
+{
+    double sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += x[i] * x[i];
+    }
+    return std::sqrt(sum);
+}
+
+template <class T>
+void run(std::string const& type, size_t n, size_t runs)
+{
+    std::mt19937 gen { 1 };
+    std::uniform_real_distribution<T> d { -1, 1 };
+
+    std::vector<T> x(n);
+    std::vector<T> y(n);
+    for (size_t i = 0; i < n; ++i) {
+        x[i] = d(gen);
+        y[i] = d(gen);
+    }
+
+    std::cout << n << " " << type << "s, " << runs << " runs" << std::endl;
+
+    double base = bench::time_us(runs, [&]() {
+        bench::keep(scalar_dot(x.data(), y.data(), n));
+    });
+    bench::report("dot, scalar", base);
+    bench::report("dot", bench::time_us(runs, [&]() {
+        bench::keep(ebt::dense::dot(x.data(), y.data(), n));
+    }), base);
+
+    // a alternates in sign so that y stays bounded over the runs.
+    T a = T(1e-3);
+
+    base = bench::time_us(runs, [&]() {
+        scalar_axpy(a, x.data(), y.data(), n);
+        a = -a;
+        bench::keep(y);
+    });
+    bench::report("axpy, scalar", base);
+    bench::report("axpy", bench::time_us(runs, [&]() {
+        ebt::dense::axpy(a, x.data(), y.data(), n);
+        a = -a;
+        bench::keep(y);
+    }), base);
+
+    base = bench::time_us(runs, [&]() {
+        bench::keep(scalar_norm2(x.data(), n));
+    });
+    bench::report("norm2, scalar", base);
+    bench::report("norm2", bench::time_us(runs, [&]() {
+        bench::keep(ebt::dense::norm2(x.data(), n));
+    }), base);
+}
+
+int main()
+{
+    run<float>("float", 1000, 200000);
+    run<double>("double", 1000, 200000);
+    run<float>("float", 1 << 22, 50);
+    run<double>("double", 1 << 22, 50);
+
+    return 0;
+}
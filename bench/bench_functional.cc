@@ -0,0 +1,90 @@
+#include "bench.h"
+#include "ebt/functional.h"
+#include <list>
+#include <random>
+#include <tuple>
+#include <vector>
+
+// The cost of composing range adaptors, against the loops they stand for.
+
+int main()
+{
+    std::mt19937 gen { 1 };
+    std::uniform_real_distribution<double> d { 0, 1 };
+
+    std::vector<double> a(1 << 20);
+    std::vector<double> b(1 << 20);
+    for (size_t i = 0; i < a.size(); ++i) {
+        a[i] = d(gen);
+        b[i] = d(gen);
+    }
+
+    size_t runs = 50;
+
+    std::cout << "sum of a[i] * b[i] over a[i] > 0.5, 1M doubles, "
+        << runs << " runs" << std::endl;
+
+    double base = bench::time_us(runs, [&]() {
+        double sum = 0;
+        for (size_t i = 0; i < a.size(); ++i) {
+            if (a[i] > 0.5) {
+                sum += a[i] * b[i];
+            }
+        }
+        bench::keep(sum);
+    });
+    bench::report("loop", base);
+
+    using pair = std::tuple<double const&, double const&>;
+
+    auto pipeline = ebt::map(
+        ebt::filter(ebt::zip(a, b), [](pair const& t) { return std::get<0>(t) > 0.5; }),
+        [](pair const& t) { return std::get<0>(t) * std::get<1>(t); });
+
+    bench::report("map . filter . zip, for_each", bench::time_us(runs, [&]() {
+        double sum = 0;
+        ebt::for_each(pipeline, [&](double v) { sum += v; });
+        bench::keep(sum);
+    }), base);
+
+    bench::report("map . filter . zip, range for", bench::time_us(runs, [&]() {
+        auto r = pipeline;
+        double sum = 0;
+        for (double v: r) {
+            sum += v;
+        }
+        bench::keep(sum);
+    }), base);
+
+    // Lists of 1000 ints, where reaching the k-th element from the front
+    // of a list is linear in k.
+    std::vector<std::list<int>> lists(1000);
+    for (size_t i = 0; i < lists.size(); ++i) {
+        for (int k = 0; k < 1000; ++k) {
+            lists[i].push_back(k);
+        }
+    }
+
+    std::cout << "sum over 1000 lists of 1000 ints, " << runs << " runs" << std::endl;
+
+    base = bench::time_us(runs, [&]() {
+        long sum = 0;
+        for (auto& l: lists) {
+            for (int v: l) {
+                sum += v;
+            }
+        }
+        bench::keep(sum);
+    });
+    bench::report("loop", base);
+
+    bench::report("chain, range for", bench::time_us(runs, [&]() {
+        long sum = 0;
+        for (int v: ebt::chain(lists)) {
+            sum += v;
+        }
+        bench::keep(sum);
+    }), base);
+
+    return 0;
+}
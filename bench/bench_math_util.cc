@@ -0,0 +1,110 @@
+#include "bench.h"
+#include "ebt/math_util.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+// log_sum_exp and the batched log_add against folds of ebt::log_add, for
+// speed and for the largest error against a long double reference.
+
+long double reference_log_sum_exp(std::vector<double> const& x)
+{
+    long double m = *std::max_element(x.begin(), x.end());
+    long double sum = 0;
+    for (auto v: x) {
+        sum += std::exp((long double) v - m);
+    }
+    return m + std::log(sum);
+}
+
+double fold_log_add(std::vector<double> const& x)
+{
+    double result = x[0];
+    for (size_t i = 1; i < x.size(); ++i) {
+        result = ebt::log_add(result, x[i]);
+    }
+    return result;
+}
+
+int main()
+{
+    std::mt19937 gen { 1 };
+    std::uniform_real_distribution<double> d { -30, 10 };
+
+    size_t rows = 1000;
+    size_t n = 1000;
+
+    std::vector<std::vector<double>> xs(rows);
+    for (auto& x: xs) {
+        for (size_t i = 0; i < n; ++i) {
+            x.push_back(d(gen));
+        }
+    }
+
+    double fold_error = 0;
+    double lse_error = 0;
+    for (auto& x: xs) {
+        long double expected = reference_log_sum_exp(x);
+        fold_error = std::max<double>(fold_error, std::fabs(fold_log_add(x) - expected));
+        lse_error = std::max<double>(lse_error, std::fabs(ebt::log_sum_exp(x) - expected));
+    }
+
+    size_t runs = 5;
+
+    std::cout << rows << " vectors of " << n << ", " << runs << " runs" << std::endl;
+    std::cout << "  largest error, fold of log_add: " << fold_error << std::endl;
+    std::cout << "  largest error, log_sum_exp: " << lse_error << std::endl;
+
+    double base = bench::time_us(runs, [&]() {
+        for (auto& x: xs) {
+            bench::keep(fold_log_add(x));
+        }
+    });
+    bench::report("fold of log_add", base);
+    bench::report("log_sum_exp", bench::time_us(runs, [&]() {
+        for (auto& x: xs) {
+            bench::keep(ebt::log_sum_exp(x));
+        }
+    }), base);
+
+    // Elementwise log_add of two rows, as in a forward pass.
+    std::vector<double> out(n);
+
+    double loop_error = 0;
+    double add_error = 0;
+    for (size_t r = 0; r + 1 < rows; ++r) {
+        ebt::log_add(xs[r], xs[r + 1], out);
+        for (size_t i = 0; i < n; ++i) {
+            long double a = xs[r][i];
+            long double b = xs[r + 1][i];
+            long double m = std::max(a, b);
+            long double expected = m + std::log(std::exp(a - m) + std::exp(b - m));
+            loop_error = std::max<double>(loop_error,
+                std::fabs(ebt::log_add(xs[r][i], xs[r + 1][i]) - expected));
+            add_error = std::max<double>(add_error, std::fabs(out[i] - expected));
+        }
+    }
+
+    std::cout << rows - 1 << " pairs of vectors of " << n << ", " << runs << " runs" << std::endl;
+    std::cout << "  largest error, loop of log_add: " << loop_error << std::endl;
+    std::cout << "  largest error, batched log_add: " << add_error << std::endl;
+
+    base = bench::time_us(runs, [&]() {
+        for (size_t r = 0; r + 1 < rows; ++r) {
+            for (size_t i = 0; i < n; ++i) {
+                out[i] = ebt::log_add(xs[r][i], xs[r + 1][i]);
+            }
+            bench::keep(out);
+        }
+    });
+    bench::report("loop of log_add", base);
+    bench::report("batched log_add", bench::time_us(runs, [&]() {
+        for (size_t r = 0; r + 1 < rows; ++r) {
+            ebt::log_add(xs[r], xs[r + 1], out);
+            bench::keep(out);
+        }
+    }), base);
+
+    return 0;
+}
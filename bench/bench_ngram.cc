@@ -0,0 +1,69 @@
+#include "bench.h"
+#include "ebt/ngram.h"
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// Trigrams over a million token ids, walked with the list-based ngram and
+// with ngram_view, and hashed by rehashing each window against the
+// rolling hash of hashed_ngram_view.
+
+int main()
+{
+    std::mt19937 gen { 1 };
+    std::uniform_int_distribution<uint32_t> id { 0, 50000 };
+
+    std::vector<uint32_t> seq;
+    for (int i = 0; i < 1000000; ++i) {
+        seq.push_back(id(gen));
+    }
+
+    size_t const n = 3;
+    size_t runs = 10;
+
+    std::cout << "trigrams of 1M ids, " << runs << " runs" << std::endl;
+
+    double base = bench::time_us(runs, [&]() {
+        uint64_t sum = 0;
+        for (auto& g: ebt::ngram(seq, n)) {
+            for (auto& t: g) {
+                sum += t;
+            }
+        }
+        bench::keep(sum);
+    });
+    bench::report("walk, ngram", base);
+
+    bench::report("walk, ngram_view", bench::time_us(runs, [&]() {
+        uint64_t sum = 0;
+        for (auto& g: ebt::ngram_view(seq, n)) {
+            for (auto& t: g) {
+                sum += t;
+            }
+        }
+        bench::keep(sum);
+    }), base);
+
+    base = bench::time_us(runs, [&]() {
+        uint64_t sum = 0;
+        for (auto& g: ebt::ngram(seq, n)) {
+            uint64_t h = 0;
+            for (auto& t: g) {
+                h = h * ebt::ngram_detail::base + ebt::ngram_detail::code(t);
+            }
+            sum += h;
+        }
+        bench::keep(sum);
+    });
+    bench::report("hash, ngram", base);
+
+    bench::report("hash, hashed_ngram_view", bench::time_us(runs, [&]() {
+        uint64_t sum = 0;
+        for (auto& g: ebt::hashed_ngram_view(seq, n)) {
+            sum += g.hash;
+        }
+        bench::keep(sum);
+    }), base);
+
+    return 0;
+}
@@ -0,0 +1,169 @@
+#include "bench.h"
+#include "ebt/string.h"
+#include <cctype>
+#include <random>
+#include <string>
+#include <vector>
+
+// The byte-at-a-time versions the vectorized primitives replaced.  The
+// old split_utf8_chars glued ASCII bytes onto the preceding character, so
+// its loop is given the current rule, a new character at every
+// non-continuation byte, to do the same work.
+
+std::string scalar_upper(std::string const& s)
+{
+    std::string result;
+    for (auto& c: s) {
+        result += std::toupper(c);
+    }
+    return result;
+}
+
+std::string scalar_lower(std::string const& s)
+{
+    std::string result;
+    for (auto& c: s) {
+        result += std::tolower(c);
+    }
+    return result;
+}
+
+std::string scalar_strip(std::string const& str, std::string const& chars)
+{
+    int s = 0;
+    for (int i = 0; i < int(str.size()); ++i) {
+        if (chars.find(str[i]) == std::string::npos) {
+            break;
+        }
+        ++s;
+    }
+
+    int b = str.size();
+    for (int i = int(str.size()) - 1; i >= 0; --i) {
+        if (chars.find(str[i]) == std::string::npos) {
+            break;
+        }
+        --b;
+    }
+
+    return str.substr(s, b - s);
+}
+
+std::string scalar_escapeseq(std::string const& s)
+{
+    std::string result;
+
+    for (auto c: s) {
+        if (c == '\\') {
+            result += '\\';
+            result += '\\';
+        } else if (c == '"') {
+            result += '\\';
+            result += '\"';
+        } else {
+            result += c;
+        }
+    }
+
+    return result;
+}
+
+std::vector<std::string> scalar_split_utf8_chars(std::string const& s)
+{
+    std::vector<std::string> result;
+    std::string tmp;
+    for (auto& c: s) {
+        if ((c & 0xC0) != 0x80 && !tmp.empty()) {
+            result.push_back(tmp);
+            tmp.clear();
+        }
+        tmp += c;
+    }
+    if (!tmp.empty()) {
+        result.push_back(tmp);
+    }
+    return result;
+}
+
+// Mixed-case ASCII words with the odd quote and backslash, about 1 MB.
+std::string make_text(size_t size)
+{
+    std::mt19937 gen { 1 };
+    std::uniform_int_distribution<int> letter { 0, 51 };
+    std::uniform_int_distribution<int> len { 1, 12 };
+
+    std::string result;
+    while (result.size() < size) {
+        int n = len(gen);
+        for (int i = 0; i < n; ++i) {
+            int c = letter(gen);
+            result += char(c < 26 ? 'a' + c : 'A' + c - 26);
+        }
+        result += (n == 7 ? "\" " : n == 11 ? "\\ " : " ");
+    }
+
+    return result;
+}
+
+int main()
+{
+    std::string text = make_text(1 << 20);
+    size_t runs = 50;
+
+    std::cout << "1 MB of text, " << runs << " runs" << std::endl;
+
+    double base = bench::time_us(runs, [&]() { bench::keep(scalar_upper(text)); });
+    bench::report("upper, scalar", base);
+    bench::report("upper", bench::time_us(runs, [&]() {
+        bench::keep(ebt::upper(text));
+    }), base);
+
+    std::string buf = text;
+    bench::report("upper_inplace", bench::time_us(runs, [&]() {
+        ebt::upper_inplace(buf);
+        bench::keep(buf);
+    }), base);
+
+    base = bench::time_us(runs, [&]() { bench::keep(scalar_lower(text)); });
+    bench::report("lower, scalar", base);
+    bench::report("lower", bench::time_us(runs, [&]() {
+        bench::keep(ebt::lower(text));
+    }), base);
+
+    base = bench::time_us(runs, [&]() { bench::keep(scalar_escapeseq(text)); });
+    bench::report("escapeseq, scalar", base);
+    bench::report("escapeseq", bench::time_us(runs, [&]() {
+        bench::keep(ebt::escapeseq(text));
+    }), base);
+
+    std::string utf8;
+    for (size_t i = 0; i < text.size(); i += 64) {
+        utf8 += text.substr(i, 60) + "\xc3\xa9\xe4\xb8\xad";
+    }
+
+    base = bench::time_us(runs / 5, [&]() { bench::keep(scalar_split_utf8_chars(utf8)); });
+    bench::report("split_utf8_chars, scalar", base);
+    bench::report("split_utf8_chars", bench::time_us(runs / 5, [&]() {
+        bench::keep(ebt::split_utf8_chars(utf8));
+    }), base);
+
+    // Tokens padded with whitespace on both sides, as read from a file.
+    std::vector<std::string> tokens;
+    for (size_t i = 0; i + 40 < text.size() && tokens.size() < 10000; i += 40) {
+        tokens.push_back(" \t  " + text.substr(i, 32) + " \n\t ");
+    }
+
+    base = bench::time_us(runs, [&]() {
+        for (auto& t: tokens) {
+            bench::keep(scalar_strip(t, " \t\n"));
+        }
+    });
+    bench::report("strip 10k tokens, scalar", base);
+    bench::report("strip 10k tokens", bench::time_us(runs, [&]() {
+        for (auto& t: tokens) {
+            bench::keep(ebt::strip(t));
+        }
+    }), base);
+
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include "bench.h"
+#include "ebt/functional.h"
+#include "ebt/string.h"
+#include "ebt/thread_pool.h"
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// How the parallel algorithms scale with the number of threads, from one
+// up to the cores of the machine or 64, whichever is fewer.  Each case is
+// compared with the same work done by a single thread outside the pool.
+
+std::vector<std::string> make_lines(size_t count)
+{
+    std::mt19937 gen { 1 };
+    std::uniform_int_distribution<int> letter { 0, 25 };
+    std::uniform_int_distribution<int> len { 1, 10 };
+    std::uniform_int_distribution<int> words { 5, 40 };
+
+    std::vector<std::string> result;
+    for (size_t i = 0; i < count; ++i) {
+        std::string line;
+        int n = words(gen);
+        for (int j = 0; j < n; ++j) {
+            int k = len(gen);
+            for (int c = 0; c < k; ++c) {
+                line += char('a' + letter(gen));
+            }
+            line += ' ';
+        }
+        result.push_back(line);
+    }
+
+    return result;
+}
+
+size_t count_tokens(std::string const& line)
+{
+    ebt::split_range r { line };
+    return std::distance(r.begin(), r.end());
+}
+
+int main()
+{
+    int max_threads = std::min(64, std::max(1, int(std::thread::hardware_concurrency())));
+
+    std::vector<int> threads;
+    for (int t = 1; t < max_threads; t *= 2) {
+        threads.push_back(t);
+    }
+    threads.push_back(max_threads);
+
+    std::vector<double> a(1 << 22);
+    std::vector<double> b(1 << 22);
+    for (size_t i = 0; i < a.size(); ++i) {
+        a[i] = double(i % 13) / 13;
+        b[i] = double(i % 7) / 7;
+    }
+
+    size_t runs = 20;
+
+    std::cout << "dot product of 4M doubles, " << runs << " runs" << std::endl;
+
+    double base = bench::time_us(runs, [&]() {
+        double sum = 0;
+        for (size_t i = 0; i < a.size(); ++i) {
+            sum += a[i] * b[i];
+        }
+        bench::keep(sum);
+    });
+    bench::report("loop", base);
+
+    for (int t: threads) {
+        ebt::thread_pool pool { t };
+
+        bench::report("parallel_reduce, " + std::to_string(t) + " threads",
+            bench::time_us(runs, [&]() {
+                bench::keep(ebt::parallel_reduce(pool, ebt::zip(a, b), 0.0,
+                    [](double acc, std::tuple<double const&, double const&> const& p) {
+                        return acc + std::get<0>(p) * std::get<1>(p);
+                    },
+                    [](double x, double y) { return x + y; }));
+            }), base);
+    }
+
+    std::vector<std::string> lines = make_lines(100000);
+
+    std::cout << "tokenizing 100k lines, " << runs << " runs" << std::endl;
+
+    base = bench::time_us(runs, [&]() {
+        std::vector<size_t> counts;
+        for (auto& line: lines) {
+            counts.push_back(count_tokens(line));
+        }
+        bench::keep(counts);
+    });
+    bench::report("loop", base);
+
+    for (int t: threads) {
+        ebt::thread_pool pool { t };
+
+        bench::report("parallel_map, " + std::to_string(t) + " threads",
+            bench::time_us(runs, [&]() {
+                bench::keep(ebt::parallel_map(pool, lines, count_tokens));
+            }), base);
+    }
+
+    return 0;
+}
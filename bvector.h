@@ -1,6 +1,8 @@
 #ifndef EBT_BVECTOR_H
 #define EBT_BVECTOR_H
 
+#include "ebt/dense.h"
+#include <algorithm>
 #include <vector>
 #include <unordered_map>
 #include <tuple>
@@ -21,22 +23,37 @@ namespace ebt {
     template <class T>
     struct dot_op;
 
+    // The dot product of the first n elements, vectorized for float and
+    // double.
+    template <class T>
+    double dense_dot(T const* v1, T const* v2, size_t n)
+    {
+        double sum = 0;
+
+        for (size_t i = 0; i < n; ++i) {
+            sum += v1[i] * v2[i];
+        }
+
+        return sum;
+    }
+
+    inline double dense_dot(float const* v1, float const* v2, size_t n)
+    {
+        return dense::dot(v1, v2, n);
+    }
+
+    inline double dense_dot(double const* v1, double const* v2, size_t n)
+    {
+        return dense::dot(v1, v2, n);
+    }
+
     template <class T>
     struct dot_op<std::vector<T>> {
         double operator()(bvector<std::vector<T>> const& v1,
             bvector<std::vector<T>> const& v2)
         {
-            if (v1.size() > v2.size()) {
-                return (*this)(v2, v1);
-            }
-
-            double sum = 0;
-
-            for (int i = 0; i < v1.data.size(); ++i) {
-                sum += v1.data[i] * v2.data[i];
-            }
-
-            return sum;
+            return dense_dot(v1.data.data(), v2.data.data(),
+                std::min(v1.data.size(), v2.data.size()));
         }
     };
 
@@ -45,13 +62,8 @@ namespace ebt {
         double operator()(bvector<std::vector<T> const&> const& v1,
             bvector<std::vector<T> const&> const& v2)
         {
-            double sum = 0;
-
-            for (int i = 0; i < v1.data.size(); ++i) {
-                sum += v1.data[i] * v2.data[i];
-            }
-
-            return sum;
+            return dense_dot(v1.data.data(), v2.data.data(),
+                std::min(v1.data.size(), v2.data.size()));
         }
     };
 
@@ -105,15 +117,10 @@ namespace ebt {
             double sum = 0;
 
             for (auto& p: v1.data) {
-                auto& u1 = v1.data.at(p.first);
+                auto& u1 = p.second;
                 auto& u2 = v2.data.at(p.first);
 
-                if (u1.size() == 0 || u2.size() == 0) {
-                    continue;
-                }
-                for (int i = 0; i < u1.size(); ++i) {
-                    sum += u1[i] * u2[i];
-                }
+                sum += dense_dot(u1.data(), u2.data(), std::min(u1.size(), u2.size()));
             }
 
             return sum;
@@ -132,15 +139,10 @@ namespace ebt {
             double sum = 0;
 
             for (auto& p: v1.data) {
-                auto& u1 = v1.data.at(p.first);
+                auto& u1 = p.second;
                 auto& u2 = v2.data.at(p.first);
 
-                if (u1.size() == 0 || u2.size() == 0) {
-                    continue;
-                }
-                for (int i = 0; i < u1.size(); ++i) {
-                    sum += u1[i] * u2[i];
-                }
+                sum += dense_dot(u1.data(), u2.data(), std::min(u1.size(), u2.size()));
             }
 
             return sum;
@@ -158,12 +160,11 @@ namespace ebt {
     };
 
     template <class... Args>
-    struct dot_op_each<1, Args...> {
+    struct dot_op_each<0, Args...> {
         double operator()(bvector<std::tuple<Args...>> const& v1,
             bvector<std::tuple<Args...>> const& v2)
         {
-            return dot(make_bvector(std::get<0>(v1.data)), make_bvector(std::get<1>(v2.data)))
-                + dot(make_bvector(std::get<1>(v1.data)), make_bvector(std::get<1>(v2.data)));
+            return dot(make_bvector(std::get<0>(v1.data)), make_bvector(std::get<0>(v2.data)));
         }
     };
 
@@ -0,0 +1,563 @@
+#include "ebt/dense.h"
+#include "ebt/simd.h"
+#include <cmath>
+
+#if EBT_SSE2
+#include <emmintrin.h>
+#endif
+
+#if EBT_AVX2_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace ebt {
+
+    namespace dense {
+
+        namespace {
+
+            enum class binary_op { add, sub, mul };
+
+#if EBT_SSE2
+            double hsum_sse2(__m128d v)
+            {
+                double t[2];
+                _mm_storeu_pd(t, v);
+                return t[0] + t[1];
+            }
+
+            // Each kernel handles a prefix of the input, adds any partial
+            // result to its last argument and returns the length of the prefix.
+
+            size_t dot_sse2(double const* x, double const* y, size_t n, double& sum)
+            {
+                __m128d s0 = _mm_setzero_pd();
+                __m128d s1 = _mm_setzero_pd();
+                __m128d s2 = _mm_setzero_pd();
+                __m128d s3 = _mm_setzero_pd();
+
+                size_t i = 0;
+                for (; i + 8 <= n; i += 8) {
+                    s0 = _mm_add_pd(s0, _mm_mul_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+                    s1 = _mm_add_pd(s1, _mm_mul_pd(_mm_loadu_pd(x + i + 2), _mm_loadu_pd(y + i + 2)));
+                    s2 = _mm_add_pd(s2, _mm_mul_pd(_mm_loadu_pd(x + i + 4), _mm_loadu_pd(y + i + 4)));
+                    s3 = _mm_add_pd(s3, _mm_mul_pd(_mm_loadu_pd(x + i + 6), _mm_loadu_pd(y + i + 6)));
+                }
+
+                sum += hsum_sse2(_mm_add_pd(_mm_add_pd(s0, s1), _mm_add_pd(s2, s3)));
+
+                return i;
+            }
+
+            size_t dot_sse2(float const* x, float const* y, size_t n, double& sum)
+            {
+                __m128d s0 = _mm_setzero_pd();
+                __m128d s1 = _mm_setzero_pd();
+                __m128d s2 = _mm_setzero_pd();
+                __m128d s3 = _mm_setzero_pd();
+
+                size_t i = 0;
+                for (; i + 8 <= n; i += 8) {
+                    __m128 a = _mm_loadu_ps(x + i);
+                    __m128 b = _mm_loadu_ps(y + i);
+                    __m128 c = _mm_loadu_ps(x + i + 4);
+                    __m128 d = _mm_loadu_ps(y + i + 4);
+
+                    s0 = _mm_add_pd(s0, _mm_mul_pd(_mm_cvtps_pd(a), _mm_cvtps_pd(b)));
+                    s1 = _mm_add_pd(s1, _mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(a, a)),
+                        _mm_cvtps_pd(_mm_movehl_ps(b, b))));
+                    s2 = _mm_add_pd(s2, _mm_mul_pd(_mm_cvtps_pd(c), _mm_cvtps_pd(d)));
+                    s3 = _mm_add_pd(s3, _mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(c, c)),
+                        _mm_cvtps_pd(_mm_movehl_ps(d, d))));
+                }
+
+                sum += hsum_sse2(_mm_add_pd(_mm_add_pd(s0, s1), _mm_add_pd(s2, s3)));
+
+                return i;
+            }
+
+            size_t norm1_sse2(double const* x, size_t n, double& sum)
+            {
+                __m128d const sign = _mm_set1_pd(-0.0);
+                __m128d s0 = _mm_setzero_pd();
+                __m128d s1 = _mm_setzero_pd();
+
+                size_t i = 0;
+                for (; i + 4 <= n; i += 4) {
+                    s0 = _mm_add_pd(s0, _mm_andnot_pd(sign, _mm_loadu_pd(x + i)));
+                    s1 = _mm_add_pd(s1, _mm_andnot_pd(sign, _mm_loadu_pd(x + i + 2)));
+                }
+
+                sum += hsum_sse2(_mm_add_pd(s0, s1));
+
+                return i;
+            }
+
+            size_t norm1_sse2(float const* x, size_t n, double& sum)
+            {
+                __m128 const sign = _mm_set1_ps(-0.0f);
+                __m128d s0 = _mm_setzero_pd();
+                __m128d s1 = _mm_setzero_pd();
+
+                size_t i = 0;
+                for (; i + 4 <= n; i += 4) {
+                    __m128 a = _mm_andnot_ps(sign, _mm_loadu_ps(x + i));
+                    s0 = _mm_add_pd(s0, _mm_cvtps_pd(a));
+                    s1 = _mm_add_pd(s1, _mm_cvtps_pd(_mm_movehl_ps(a, a)));
+                }
+
+                sum += hsum_sse2(_mm_add_pd(s0, s1));
+
+                return i;
+            }
+
+            size_t axpy_sse2(double a, double const* x, double* y, size_t n)
+            {
+                __m128d va = _mm_set1_pd(a);
+
+                size_t i = 0;
+                for (; i + 2 <= n; i += 2) {
+                    _mm_storeu_pd(y + i, _mm_add_pd(_mm_loadu_pd(y + i),
+                        _mm_mul_pd(va, _mm_loadu_pd(x + i))));
+                }
+
+                return i;
+            }
+
+            size_t axpy_sse2(float a, float const* x, float* y, size_t n)
+            {
+                __m128 va = _mm_set1_ps(a);
+
+                size_t i = 0;
+                for (; i + 4 <= n; i += 4) {
+                    _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i),
+                        _mm_mul_ps(va, _mm_loadu_ps(x + i))));
+                }
+
+                return i;
+            }
+
+            size_t scale_sse2(double a, double* x, size_t n)
+            {
+                __m128d va = _mm_set1_pd(a);
+
+                size_t i = 0;
+                for (; i + 2 <= n; i += 2) {
+                    _mm_storeu_pd(x + i, _mm_mul_pd(va, _mm_loadu_pd(x + i)));
+                }
+
+                return i;
+            }
+
+            size_t scale_sse2(float a, float* x, size_t n)
+            {
+                __m128 va = _mm_set1_ps(a);
+
+                size_t i = 0;
+                for (; i + 4 <= n; i += 4) {
+                    _mm_storeu_ps(x + i, _mm_mul_ps(va, _mm_loadu_ps(x + i)));
+                }
+
+                return i;
+            }
+
+            template <binary_op op>
+            size_t binary_sse2(double const* x, double const* y, double* out, size_t n)
+            {
+                size_t i = 0;
+                for (; i + 2 <= n; i += 2) {
+                    __m128d a = _mm_loadu_pd(x + i);
+                    __m128d b = _mm_loadu_pd(y + i);
+                    _mm_storeu_pd(out + i, op == binary_op::add ? _mm_add_pd(a, b)
+                        : op == binary_op::sub ? _mm_sub_pd(a, b) : _mm_mul_pd(a, b));
+                }
+
+                return i;
+            }
+
+            template <binary_op op>
+            size_t binary_sse2(float const* x, float const* y, float* out, size_t n)
+            {
+                size_t i = 0;
+                for (; i + 4 <= n; i += 4) {
+                    __m128 a = _mm_loadu_ps(x + i);
+                    __m128 b = _mm_loadu_ps(y + i);
+                    _mm_storeu_ps(out + i, op == binary_op::add ? _mm_add_ps(a, b)
+                        : op == binary_op::sub ? _mm_sub_ps(a, b) : _mm_mul_ps(a, b));
+                }
+
+                return i;
+            }
+#endif
+
+#if EBT_AVX2_DISPATCH
+            EBT_TARGET_AVX2_FMA
+            double hsum_avx2(__m256d v)
+            {
+                __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+                return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+            }
+
+            EBT_TARGET_AVX2_FMA
+            size_t dot_avx2(double const* x, double const* y, size_t n, double& sum)
+            {
+                __m256d s0 = _mm256_setzero_pd();
+                __m256d s1 = _mm256_setzero_pd();
+                __m256d s2 = _mm256_setzero_pd();
+                __m256d s3 = _mm256_setzero_pd();
+
+                size_t i = 0;
+                for (; i + 16 <= n; i += 16) {
+                    s0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), s0);
+                    s1 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4), s1);
+                    s2 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 8), _mm256_loadu_pd(y + i + 8), s2);
+                    s3 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 12), _mm256_loadu_pd(y + i + 12), s3);
+                }
+
+                sum += hsum_avx2(_mm256_add_pd(_mm256_add_pd(s0, s1), _mm256_add_pd(s2, s3)));
+
+                return i;
+            }
+
+            EBT_TARGET_AVX2_FMA
+            size_t dot_avx2(float const* x, float const* y, size_t n, double& sum)
+            {
+                __m256d s0 = _mm256_setzero_pd();
+                __m256d s1 = _mm256_setzero_pd();
+                __m256d s2 = _mm256_setzero_pd();
+                __m256d s3 = _mm256_setzero_pd();
+
+                size_t i = 0;
+                for (; i + 16 <= n; i += 16) {
+                    s0 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm_loadu_ps(x + i)),
+                        _mm256_cvtps_pd(_mm_loadu_ps(y + i)), s0);
+                    s1 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm_loadu_ps(x + i + 4)),
+                        _mm256_cvtps_pd(_mm_loadu_ps(y + i + 4)), s1);
+                    s2 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm_loadu_ps(x + i + 8)),
+                        _mm256_cvtps_pd(_mm_loadu_ps(y + i + 8)), s2);
+                    s3 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm_loadu_ps(x + i + 12)),
+                        _mm256_cvtps_pd(_mm_loadu_ps(y + i + 12)), s3);
+                }
+
+                sum += hsum_avx2(_mm256_add_pd(_mm256_add_pd(s0, s1), _mm256_add_pd(s2, s3)));
+
+                return i;
+            }
+
+            EBT_TARGET_AVX2_FMA
+            size_t norm1_avx2(double const* x, size_t n, double& sum)
+            {
+                __m256d const sign = _mm256_set1_pd(-0.0);
+                __m256d s0 = _mm256_setzero_pd();
+                __m256d s1 = _mm256_setzero_pd();
+
+                size_t i = 0;
+                for (; i + 8 <= n; i += 8) {
+                    s0 = _mm256_add_pd(s0, _mm256_andnot_pd(sign, _mm256_loadu_pd(x + i)));
+                    s1 = _mm256_add_pd(s1, _mm256_andnot_pd(sign, _mm256_loadu_pd(x + i + 4)));
+                }
+
+                sum += hsum_avx2(_mm256_add_pd(s0, s1));
+
+                return i;
+            }
+
+            EBT_TARGET_AVX2_FMA
+            size_t norm1_avx2(float const* x, size_t n, double& sum)
+            {
+                __m128 const sign = _mm_set1_ps(-0.0f);
+                __m256d s0 = _mm256_setzero_pd();
+                __m256d s1 = _mm256_setzero_pd();
+
+                size_t i = 0;
+                for (; i + 8 <= n; i += 8) {
+                    s0 = _mm256_add_pd(s0, _mm256_cvtps_pd(_mm_andnot_ps(sign, _mm_loadu_ps(x + i))));
+                    s1 = _mm256_add_pd(s1, _mm256_cvtps_pd(_mm_andnot_ps(sign, _mm_loadu_ps(x + i + 4))));
+                }
+
+                sum += hsum_avx2(_mm256_add_pd(s0, s1));
+
+                return i;
+            }
+
+            EBT_TARGET_AVX2_FMA
+            size_t axpy_avx2(double a, double const* x, double* y, size_t n)
+            {
+                __m256d va = _mm256_set1_pd(a);
+
+                size_t i = 0;
+                for (; i + 8 <= n; i += 8) {
+                    _mm256_storeu_pd(y + i, _mm256_fmadd_pd(va, _mm256_loadu_pd(x + i),
+                        _mm256_loadu_pd(y + i)));
+                    _mm256_storeu_pd(y + i + 4, _mm256_fmadd_pd(va, _mm256_loadu_pd(x + i + 4),
+                        _mm256_loadu_pd(y + i + 4)));
+                }
+
+                return i;
+            }
+
+            EBT_TARGET_AVX2_FMA
+            size_t axpy_avx2(float a, float const* x, float* y, size_t n)
+            {
+                __m256 va = _mm256_set1_ps(a);
+
+                size_t i = 0;
+                for (; i + 16 <= n; i += 16) {
+                    _mm256_storeu_ps(y + i, _mm256_fmadd_ps(va, _mm256_loadu_ps(x + i),
+                        _mm256_loadu_ps(y + i)));
+                    _mm256_storeu_ps(y + i + 8, _mm256_fmadd_ps(va, _mm256_loadu_ps(x + i + 8),
+                        _mm256_loadu_ps(y + i + 8)));
+                }
+
+                return i;
+            }
+
+            EBT_TARGET_AVX2_FMA
+            size_t scale_avx2(double a, double* x, size_t n)
+            {
+                __m256d va = _mm256_set1_pd(a);
+
+                size_t i = 0;
+                for (; i + 4 <= n; i += 4) {
+                    _mm256_storeu_pd(x + i, _mm256_mul_pd(va, _mm256_loadu_pd(x + i)));
+                }
+
+                return i;
+            }
+
+            EBT_TARGET_AVX2_FMA
+            size_t scale_avx2(float a, float* x, size_t n)
+            {
+                __m256 va = _mm256_set1_ps(a);
+
+                size_t i = 0;
+                for (; i + 8 <= n; i += 8) {
+                    _mm256_storeu_ps(x + i, _mm256_mul_ps(va, _mm256_loadu_ps(x + i)));
+                }
+
+                return i;
+            }
+
+            template <binary_op op>
+            EBT_TARGET_AVX2_FMA
+            size_t binary_avx2(double const* x, double const* y, double* out, size_t n)
+            {
+                size_t i = 0;
+                for (; i + 4 <= n; i += 4) {
+                    __m256d a = _mm256_loadu_pd(x + i);
+                    __m256d b = _mm256_loadu_pd(y + i);
+                    _mm256_storeu_pd(out + i, op == binary_op::add ? _mm256_add_pd(a, b)
+                        : op == binary_op::sub ? _mm256_sub_pd(a, b) : _mm256_mul_pd(a, b));
+                }
+
+                return i;
+            }
+
+            template <binary_op op>
+            EBT_TARGET_AVX2_FMA
+            size_t binary_avx2(float const* x, float const* y, float* out, size_t n)
+            {
+                size_t i = 0;
+                for (; i + 8 <= n; i += 8) {
+                    __m256 a = _mm256_loadu_ps(x + i);
+                    __m256 b = _mm256_loadu_ps(y + i);
+                    _mm256_storeu_ps(out + i, op == binary_op::add ? _mm256_add_ps(a, b)
+                        : op == binary_op::sub ? _mm256_sub_ps(a, b) : _mm256_mul_ps(a, b));
+                }
+
+                return i;
+            }
+#endif
+
+            template <class T>
+            double dot_impl(T const* x, T const* y, size_t n)
+            {
+                double sum = 0;
+                size_t i = 0;
+
+#if EBT_AVX2_DISPATCH
+                if (cpu_has_fma()) {
+                    i = dot_avx2(x, y, n, sum);
+                }
+#endif
+
+#if EBT_SSE2
+                i += dot_sse2(x + i, y + i, n - i, sum);
+#endif
+
+                for (; i < n; ++i) {
+                    sum += double(x[i]) * y[i];
+                }
+
+                return sum;
+            }
+
+            template <class T>
+            double norm1_impl(T const* x, size_t n)
+            {
+                double sum = 0;
+                size_t i = 0;
+
+#if EBT_AVX2_DISPATCH
+                if (cpu_has_fma()) {
+                    i = norm1_avx2(x, n, sum);
+                }
+#endif
+
+#if EBT_SSE2
+                i += norm1_sse2(x + i, n - i, sum);
+#endif
+
+                for (; i < n; ++i) {
+                    sum += std::fabs(double(x[i]));
+                }
+
+                return sum;
+            }
+
+            template <class T>
+            void axpy_impl(T a, T const* x, T* y, size_t n)
+            {
+                size_t i = 0;
+
+#if EBT_AVX2_DISPATCH
+                if (cpu_has_fma()) {
+                    i = axpy_avx2(a, x, y, n);
+                }
+#endif
+
+#if EBT_SSE2
+                i += axpy_sse2(a, x + i, y + i, n - i);
+#endif
+
+                for (; i < n; ++i) {
+                    y[i] += a * x[i];
+                }
+            }
+
+            template <class T>
+            void scale_impl(T a, T* x, size_t n)
+            {
+                size_t i = 0;
+
+#if EBT_AVX2_DISPATCH
+                if (cpu_has_fma()) {
+                    i = scale_avx2(a, x, n);
+                }
+#endif
+
+#if EBT_SSE2
+                i += scale_sse2(a, x + i, n - i);
+#endif
+
+                for (; i < n; ++i) {
+                    x[i] *= a;
+                }
+            }
+
+            template <binary_op op, class T>
+            void binary_impl(T const* x, T const* y, T* out, size_t n)
+            {
+                size_t i = 0;
+
+#if EBT_AVX2_DISPATCH
+                if (cpu_has_fma()) {
+                    i = binary_avx2<op>(x, y, out, n);
+                }
+#endif
+
+#if EBT_SSE2
+                i += binary_sse2<op>(x + i, y + i, out + i, n - i);
+#endif
+
+                for (; i < n; ++i) {
+                    out[i] = op == binary_op::add ? x[i] + y[i]
+                        : op == binary_op::sub ? x[i] - y[i] : x[i] * y[i];
+                }
+            }
+
+        }
+
+        double dot(float const* x, float const* y, size_t n)
+        {
+            return dot_impl(x, y, n);
+        }
+
+        double dot(double const* x, double const* y, size_t n)
+        {
+            return dot_impl(x, y, n);
+        }
+
+        void axpy(float a, float const* x, float* y, size_t n)
+        {
+            axpy_impl(a, x, y, n);
+        }
+
+        void axpy(double a, double const* x, double* y, size_t n)
+        {
+            axpy_impl(a, x, y, n);
+        }
+
+        void scale(float a, float* x, size_t n)
+        {
+            scale_impl(a, x, n);
+        }
+
+        void scale(double a, double* x, size_t n)
+        {
+            scale_impl(a, x, n);
+        }
+
+        double norm1(float const* x, size_t n)
+        {
+            return norm1_impl(x, n);
+        }
+
+        double norm1(double const* x, size_t n)
+        {
+            return norm1_impl(x, n);
+        }
+
+        double norm2(float const* x, size_t n)
+        {
+            return std::sqrt(dot_impl(x, x, n));
+        }
+
+        double norm2(double const* x, size_t n)
+        {
+            return std::sqrt(dot_impl(x, x, n));
+        }
+
+        void add(float const* x, float const* y, float* out, size_t n)
+        {
+            binary_impl<binary_op::add>(x, y, out, n);
+        }
+
+        void add(double const* x, double const* y, double* out, size_t n)
+        {
+            binary_impl<binary_op::add>(x, y, out, n);
+        }
+
+        void sub(float const* x, float const* y, float* out, size_t n)
+        {
+            binary_impl<binary_op::sub>(x, y, out, n);
+        }
+
+        void sub(double const* x, double const* y, double* out, size_t n)
+        {
+            binary_impl<binary_op::sub>(x, y, out, n);
+        }
+
+        void mul(float const* x, float const* y, float* out, size_t n)
+        {
+            binary_impl<binary_op::mul>(x, y, out, n);
+        }
+
+        void mul(double const* x, double const* y, double* out, size_t n)
+        {
+            binary_impl<binary_op::mul>(x, y, out, n);
+        }
+
+    }
+
+}
@@ -0,0 +1,44 @@
+#ifndef EBT_DENSE_H
+#define EBT_DENSE_H
+
+#include <cstddef>
+
+namespace ebt {
+
+    // Kernels over contiguous float and double arrays, vectorized with
+    // SSE2 and, when the CPU has them, AVX2 and FMA.  Reductions keep
+    // several partial sums, so results may differ from a sequential loop
+    // in the last bits.  Float reductions accumulate in double.
+    namespace dense {
+
+        double dot(float const* x, float const* y, size_t n);
+        double dot(double const* x, double const* y, size_t n);
+
+        // y += a * x
+        void axpy(float a, float const* x, float* y, size_t n);
+        void axpy(double a, double const* x, double* y, size_t n);
+
+        // x *= a
+        void scale(float a, float* x, size_t n);
+        void scale(double a, double* x, size_t n);
+
+        double norm1(float const* x, size_t n);
+        double norm1(double const* x, size_t n);
+
+        // The Euclidean norm, without rescaling against overflow.
+        double norm2(float const* x, size_t n);
+        double norm2(double const* x, size_t n);
+
+        // out = x op y, elementwise.  out may be x or y.
+        void add(float const* x, float const* y, float* out, size_t n);
+        void add(double const* x, double const* y, double* out, size_t n);
+        void sub(float const* x, float const* y, float* out, size_t n);
+        void sub(double const* x, double const* y, double* out, size_t n);
+        void mul(float const* x, float const* y, float* out, size_t n);
+        void mul(double const* x, double const* y, double* out, size_t n);
+
+    }
+
+}
+
+#endif
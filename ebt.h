@@ -5,11 +5,17 @@
 #include "ebt/hash.h"
 #include "ebt/either.h"
 #include "ebt/json.h"
+#include "ebt/json_fields.h"
 #include "ebt/max_heap.h"
 #include "ebt/option.h"
 #include "ebt/range.h"
+#include "ebt/span.h"
 #include "ebt/sparse_vector.h"
 #include "ebt/string.h"
+#include "ebt/string_ref.h"
+#include "ebt/replacer.h"
+#include "ebt/utf8.h"
+#include "ebt/edit_distance.h"
 #include "ebt/vector.h"
 #include "ebt/unordered_map.h"
 #include "ebt/unordered_set.h"
@@ -18,9 +24,20 @@
 #include "ebt/pair.h"
 #include "ebt/assert.h"
 #include "ebt/functional.h"
+#include "ebt/memoize.h"
 #include "ebt/exception.h"
 #include "ebt/hashmap.h"
+#include "ebt/symbol_table.h"
+#include "ebt/ngram_counter.h"
 #include "ebt/logger.h"
+#include "ebt/line_reader.h"
+#include "ebt/thread_pool.h"
+#include "ebt/queue.h"
+#include "ebt/pipeline.h"
+#include "ebt/sparse_id_vector.h"
+#include "ebt/dense.h"
+#include "ebt/param_store.h"
+#include "ebt/semiring.h"
 
 // deprecated
 #include "ngram.h"
@@ -0,0 +1,179 @@
+#include "ebt/edit_distance.h"
+#include <limits>
+
+namespace ebt {
+
+    namespace {
+
+        // One column step of Myers' algorithm for a 64-row block, with the
+        // horizontal delta hin entering from above.  Returns the delta
+        // leaving at row high.
+        inline int advance_block(uint64_t& pv, uint64_t& mv, uint64_t eq,
+            uint64_t high, int hin)
+        {
+            uint64_t xv = eq | mv;
+
+            if (hin < 0) {
+                eq |= 1;
+            }
+
+            uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+            uint64_t ph = mv | ~(xh | pv);
+            uint64_t mh = pv & xh;
+
+            int hout = 0;
+            if (ph & high) {
+                hout = 1;
+            } else if (mh & high) {
+                hout = -1;
+            }
+
+            ph <<= 1;
+            mh <<= 1;
+
+            if (hin < 0) {
+                mh |= 1;
+            } else if (hin > 0) {
+                ph |= 1;
+            }
+
+            pv = mh | ~(xv | ph);
+            mv = ph & xv;
+
+            return hout;
+        }
+
+    }
+
+    size_t edit_distance_ids(uint32_t const* a, size_t n,
+        uint32_t const* b, size_t m, uint32_t symbols)
+    {
+        if (n == 0) {
+            return m;
+        }
+
+        size_t blocks = (n + 63) / 64;
+        uint64_t last = uint64_t(1) << ((n - 1) % 64);
+
+        thread_local std::vector<uint64_t> peq;
+        peq.assign(size_t(symbols) * blocks, 0);
+
+        for (size_t i = 0; i < n; ++i) {
+            peq[a[i] * blocks + i / 64] |= uint64_t(1) << (i % 64);
+        }
+
+        size_t score = n;
+
+        if (blocks == 1) {
+            uint64_t pv = ~uint64_t(0);
+            uint64_t mv = 0;
+
+            for (size_t j = 0; j < m; ++j) {
+                score += advance_block(pv, mv, peq[b[j]], last, 1);
+            }
+
+            return score;
+        }
+
+        thread_local std::vector<uint64_t> pv;
+        thread_local std::vector<uint64_t> mv;
+        pv.assign(blocks, ~uint64_t(0));
+        mv.assign(blocks, 0);
+
+        uint64_t const top = uint64_t(1) << 63;
+
+        for (size_t j = 0; j < m; ++j) {
+            uint64_t const* eq = &peq[b[j] * blocks];
+
+            int h = 1;
+            for (size_t k = 0; k + 1 < blocks; ++k) {
+                h = advance_block(pv[k], mv[k], eq[k], top, h);
+            }
+
+            score += advance_block(pv[blocks - 1], mv[blocks - 1],
+                eq[blocks - 1], last, h);
+        }
+
+        return score;
+    }
+
+    alignment align_ids(uint32_t const* a, size_t n,
+        uint32_t const* b, size_t m, size_t band)
+    {
+        size_t diff = (n > m ? n - m : m - n);
+        band = std::max(band, diff);
+
+        // Row i holds the cells j in [i - band, i + band], at offset
+        // j - i + band.
+        size_t width = 2 * band + 1;
+        uint32_t const inf = std::numeric_limits<uint32_t>::max() / 2;
+        std::vector<uint32_t> d((n + 1) * width, inf);
+
+        auto cell = [&](size_t i, size_t j) -> uint32_t& {
+            return d[i * width + (j + band - i)];
+        };
+
+        auto inside = [&](size_t i, size_t j) {
+            return j + band >= i && j <= i + band && j <= m;
+        };
+
+        for (size_t i = 0; i <= n; ++i) {
+            size_t lo = (i > band ? i - band : 0);
+            size_t hi = std::min(m, i + band);
+
+            for (size_t j = lo; j <= hi; ++j) {
+                uint32_t v;
+
+                if (i == 0) {
+                    v = j;
+                } else if (j == 0) {
+                    v = i;
+                } else {
+                    v = cell(i - 1, j - 1) + (a[i - 1] == b[j - 1] ? 0 : 1);
+
+                    if (inside(i - 1, j)) {
+                        v = std::min(v, cell(i - 1, j) + 1);
+                    }
+                    if (j - 1 >= lo) {
+                        v = std::min(v, cell(i, j - 1) + 1);
+                    }
+                }
+
+                cell(i, j) = v;
+            }
+        }
+
+        alignment result;
+        result.distance = cell(n, m);
+
+        size_t i = n;
+        size_t j = m;
+
+        while (i > 0 || j > 0) {
+            uint32_t v = cell(i, j);
+
+            if (i > 0 && j > 0) {
+                bool same = (a[i - 1] == b[j - 1]);
+                if (cell(i - 1, j - 1) + (same ? 0 : 1) == v) {
+                    result.ops.push_back(same ? edit_op::match : edit_op::substitution);
+                    --i;
+                    --j;
+                    continue;
+                }
+            }
+
+            if (i > 0 && inside(i - 1, j) && cell(i - 1, j) + 1 == v) {
+                result.ops.push_back(edit_op::deletion);
+                --i;
+            } else {
+                result.ops.push_back(edit_op::insertion);
+                --j;
+            }
+        }
+
+        std::reverse(result.ops.begin(), result.ops.end());
+
+        return result;
+    }
+
+}
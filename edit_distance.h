@@ -0,0 +1,150 @@
+#ifndef EBT_EDIT_DISTANCE_H
+#define EBT_EDIT_DISTANCE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ebt {
+
+    // Edits that turn a into b, in order.  A deletion consumes an element
+    // of a, an insertion an element of b, and the others one of each.
+    enum class edit_op {
+        match,
+        substitution,
+        insertion,
+        deletion
+    };
+
+    struct alignment {
+        size_t distance;
+        std::vector<edit_op> ops;
+    };
+
+    // Levenshtein distance with unit costs between sequences of dense
+    // symbols in [0, symbols).  Uses Myers' bit-vector algorithm over
+    // 64-row blocks of a, so a should be the shorter sequence.
+    size_t edit_distance_ids(uint32_t const* a, size_t n,
+        uint32_t const* b, size_t m, uint32_t symbols);
+
+    // A minimal alignment by dynamic programming restricted to cells with
+    // |i - j| <= band.  The result is optimal whenever the distance is at
+    // most band.
+    alignment align_ids(uint32_t const* a, size_t n,
+        uint32_t const* b, size_t m, size_t band);
+
+    // Maps the symbols of a to [0, k) and those of b to the same ids, or
+    // to k if they do not occur in a.  Returns k + 1.
+    template <class T>
+    uint32_t remap_symbols(T const* a, size_t n, T const* b, size_t m,
+        std::vector<uint32_t>& ra, std::vector<uint32_t>& rb)
+    {
+        std::vector<T> alphabet(a, a + n);
+        std::sort(alphabet.begin(), alphabet.end());
+        alphabet.erase(std::unique(alphabet.begin(), alphabet.end()),
+            alphabet.end());
+
+        auto id = [&](T const& t) {
+            auto i = std::lower_bound(alphabet.begin(), alphabet.end(), t);
+            return uint32_t(i != alphabet.end() && *i == t ? i - alphabet.begin()
+                : alphabet.size());
+        };
+
+        ra.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            ra[i] = id(a[i]);
+        }
+
+        rb.resize(m);
+        for (size_t i = 0; i < m; ++i) {
+            rb[i] = id(b[i]);
+        }
+
+        return alphabet.size() + 1;
+    }
+
+    // Works on any element type with == and <, such as token ids from a
+    // symbol_table or code points from decode_utf8.
+    template <class T>
+    size_t edit_distance(T const* a, size_t n, T const* b, size_t m)
+    {
+        if (n > m) {
+            std::swap(a, b);
+            std::swap(n, m);
+        }
+
+        std::vector<uint32_t> ra;
+        std::vector<uint32_t> rb;
+        uint32_t symbols = remap_symbols(a, n, b, m, ra, rb);
+
+        return edit_distance_ids(ra.data(), n, rb.data(), m, symbols);
+    }
+
+    template <class T>
+    size_t edit_distance(std::vector<T> const& a, std::vector<T> const& b)
+    {
+        return edit_distance(a.data(), a.size(), b.data(), b.size());
+    }
+
+    // Finds the distance with the bit-vector algorithm first, and then
+    // recovers the edits from a dynamic program banded by it.
+    template <class T>
+    alignment align(T const* a, size_t n, T const* b, size_t m)
+    {
+        std::vector<uint32_t> ra;
+        std::vector<uint32_t> rb;
+        size_t band;
+
+        if (n <= m) {
+            uint32_t symbols = remap_symbols(a, n, b, m, ra, rb);
+            band = edit_distance_ids(ra.data(), n, rb.data(), m, symbols);
+        } else {
+            uint32_t symbols = remap_symbols(b, m, a, n, rb, ra);
+            band = edit_distance_ids(rb.data(), m, ra.data(), n, symbols);
+        }
+
+        return align_ids(ra.data(), n, rb.data(), m, band);
+    }
+
+    template <class T>
+    alignment align(std::vector<T> const& a, std::vector<T> const& b)
+    {
+        return align(a.data(), a.size(), b.data(), b.size());
+    }
+
+    // Scores every pair on the given number of threads.
+    template <class T>
+    std::vector<size_t> edit_distance(
+        std::vector<std::pair<std::vector<T>, std::vector<T>>> const& pairs,
+        int threads)
+    {
+        std::vector<size_t> result(pairs.size());
+        std::atomic<size_t> next(0);
+
+        auto work = [&]() {
+            size_t i;
+            while ((i = next++) < pairs.size()) {
+                result[i] = edit_distance(pairs[i].first, pairs[i].second);
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (int t = 1; t < threads; ++t) {
+            workers.emplace_back(work);
+        }
+
+        work();
+
+        for (auto& t: workers) {
+            t.join();
+        }
+
+        return result;
+    }
+
+}
+
+#endif
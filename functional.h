@@ -2,9 +2,14 @@
 #define EBT_FUNCTIONAL_H
 
 #include "ebt/range.h"
+#include "ebt/span.h"
 #include <tuple>
 #include <functional>
+#include <algorithm>
+#include <iterator>
 #include <memory>
+#include <type_traits>
+#include <vector>
 
 namespace ebt {
 
@@ -40,6 +45,22 @@ namespace ebt {
             return r_.empty();
         }
 
+        template <class m = map_range_impl>
+        typename std::enable_if<is_sized_range<typename m::base_range>::value,
+            size_t>::type
+        size() const
+        {
+            return r_.size();
+        }
+
+        template <class m = map_range_impl>
+        typename std::enable_if<is_random_access_range<typename m::base_range>::value,
+            value_type>::type
+        operator[](size_t n) const
+        {
+            return f_(r_[n]);
+        }
+
         range_iterator<map_range_impl> begin()
         {
             return range_iterator<map_range_impl>(*this);
@@ -50,6 +71,15 @@ namespace ebt {
             return range_iterator<map_range_impl>();
         }
 
+        template <class sink>
+        void for_each(sink&& s) const
+        {
+            func const& f = f_;
+            ebt::for_each(r_, [&](typename range::value_type const& v) { s(f(v)); });
+        }
+
+        using base_range = range;
+
     private:
         range r_;
         func f_;
@@ -74,7 +104,7 @@ namespace ebt {
 
         value_type const& front() const
         {
-            return f_(r_);
+            return f_(r_.front());
         }
 
         bool empty() const
@@ -82,6 +112,22 @@ namespace ebt {
             return r_.empty();
         }
 
+        template <class m = map_range_impl>
+        typename std::enable_if<is_sized_range<typename m::base_range>::value,
+            size_t>::type
+        size() const
+        {
+            return r_.size();
+        }
+
+        template <class m = map_range_impl>
+        typename std::enable_if<is_random_access_range<typename m::base_range>::value,
+            value_type const&>::type
+        operator[](size_t n) const
+        {
+            return f_(r_[n]);
+        }
+
         range_iterator<map_range_impl> begin()
         {
             return range_iterator<map_range_impl>(*this);
@@ -92,6 +138,15 @@ namespace ebt {
             return range_iterator<map_range_impl>();
         }
 
+        template <class sink>
+        void for_each(sink&& s) const
+        {
+            func const& f = f_;
+            ebt::for_each(r_, [&](typename range::value_type const& v) { s(f(v)); });
+        }
+
+        using base_range = range;
+
     private:
         range r_;
         func f_;
@@ -110,43 +165,486 @@ namespace ebt {
         return map_range<range, func>(r, f);
     }
 
-    template <class container, class func>
-    typename std::enable_if<!is_range<container>::value,
-        map_range<range<container>, func>>::type
+    template <class container, class func,
+        class = typename std::enable_if<!is_range<container>::value>::type>
+    map_range<range<container>, func>
     map(container const& con, func f)
     {
         return map(make_range(con), f);
     }
 
+    // The elements of a range for which a predicate holds.
+    template <class range, class pred>
+    class filter_range {
+    public:
+        using value_type = typename range::value_type;
+
+        filter_range(range r, pred p)
+            : r_(std::move(r)), p_(std::move(p))
+        {
+            skip();
+        }
+
+        void pop_front()
+        {
+            r_.pop_front();
+            skip();
+        }
+
+        value_type const& front() const
+        {
+            return r_.front();
+        }
+
+        bool empty() const
+        {
+            return r_.empty();
+        }
+
+        template <class sink>
+        void for_each(sink&& s) const
+        {
+            pred const& p = p_;
+            ebt::for_each(r_, [&](value_type const& v) {
+                if (p(v)) {
+                    s(v);
+                }
+            });
+        }
+
+        range_iterator<filter_range> begin()
+        {
+            return range_iterator<filter_range>(*this);
+        }
+
+        range_iterator<filter_range> end()
+        {
+            return range_iterator<filter_range>();
+        }
+
+    private:
+        range r_;
+        pred p_;
+
+        void skip()
+        {
+            while (!r_.empty() && !p_(r_.front())) {
+                r_.pop_front();
+            }
+        }
+    };
+
+    template <class range, class pred>
+    typename std::enable_if<is_range<range>::value,
+        filter_range<range, pred>>::type
+    filter(range const& r, pred p)
+    {
+        return filter_range<range, pred>(r, p);
+    }
+
+    template <class container, class pred,
+        class = typename std::enable_if<!is_range<container>::value>::type>
+    filter_range<range<container>, pred>
+    filter(container const& con, pred p)
+    {
+        return filter(make_range(con), p);
+    }
+
+    // The elements of one range followed by those of another.
+    template <class range1, class range2>
+    class chain_range {
+    public:
+        using value_type = typename range1::value_type;
+
+        static_assert(std::is_same<value_type, typename range2::value_type>::value,
+            "chained ranges must have the same value type");
+
+        chain_range(range1 r1, range2 r2)
+            : r1_(std::move(r1)), r2_(std::move(r2))
+        {}
+
+        void pop_front()
+        {
+            if (!r1_.empty()) {
+                r1_.pop_front();
+            } else {
+                r2_.pop_front();
+            }
+        }
+
+        value_type const& front() const
+        {
+            return r1_.empty() ? r2_.front() : r1_.front();
+        }
+
+        bool empty() const
+        {
+            return r1_.empty() && r2_.empty();
+        }
+
+        template <class sink>
+        void for_each(sink&& s) const
+        {
+            ebt::for_each(r1_, s);
+            ebt::for_each(r2_, s);
+        }
+
+        range_iterator<chain_range> begin()
+        {
+            return range_iterator<chain_range>(*this);
+        }
+
+        range_iterator<chain_range> end()
+        {
+            return range_iterator<chain_range>();
+        }
+
+    private:
+        range1 r1_;
+        range2 r2_;
+    };
+
     template <class range1, class range2>
+    typename std::enable_if<is_range<range1>::value && is_range<range2>::value,
+        chain_range<range1, range2>>::type
+    chain(range1 const& r1, range2 const& r2)
+    {
+        return chain_range<range1, range2>(r1, r2);
+    }
+
+    template <class container1, class container2,
+        class = typename std::enable_if<!is_range<container1>::value
+            && !is_range<container2>::value>::type>
+    chain_range<range<container1>, range<container2>>
+    chain(container1 const& con1, container2 const& con2)
+    {
+        return chain(make_range(con1), make_range(con2));
+    }
+
+    // The elements of every container in a range of containers, in order.
+    // The position within the current container is kept as an iterator,
+    // so front() takes constant time whatever the container.
+    template <class range>
+    class flatten_range {
+    public:
+        using inner_type = typename std::decay<typename range::value_type>::type;
+        using value_type = typename inner_type::value_type;
+
+        explicit flatten_range(range r)
+            : r_(std::move(r))
+        {
+            start();
+        }
+
+        // The iterators may point into the range copied from, so they are
+        // found again in the copy.
+        flatten_range(flatten_range const& that)
+            : r_(that.r_)
+        {
+            seek(that.k_);
+        }
+
+        flatten_range& operator=(flatten_range const& that)
+        {
+            r_ = that.r_;
+            seek(that.k_);
+            return *this;
+        }
+
+        void pop_front()
+        {
+            ++k_;
+            if (++it_ == end_) {
+                r_.pop_front();
+                start();
+            }
+        }
+
+        value_type const& front() const
+        {
+            return *it_;
+        }
+
+        bool empty() const
+        {
+            return r_.empty();
+        }
+
+        template <class sink>
+        void for_each(sink&& s) const
+        {
+            ebt::for_each(r_, [&](inner_type const& c) {
+                for (auto& v: c) {
+                    s(v);
+                }
+            });
+        }
+
+        range_iterator<flatten_range> begin()
+        {
+            return range_iterator<flatten_range>(*this);
+        }
+
+        range_iterator<flatten_range> end()
+        {
+            return range_iterator<flatten_range>();
+        }
+
+    private:
+        using inner_iterator = typename inner_type::const_iterator;
+
+        range r_;
+        size_t k_;
+        inner_iterator it_;
+        inner_iterator end_;
+
+        // Moves to the first element of the next non-empty container.
+        void start()
+        {
+            k_ = 0;
+
+            for (; !r_.empty(); r_.pop_front()) {
+                inner_type const& c = r_.front();
+                it_ = c.begin();
+                end_ = c.end();
+
+                if (it_ != end_) {
+                    break;
+                }
+            }
+        }
+
+        void seek(size_t k)
+        {
+            k_ = k;
+
+            if (!r_.empty()) {
+                inner_type const& c = r_.front();
+                it_ = std::next(c.begin(), k);
+                end_ = c.end();
+            }
+        }
+    };
+
+    template <class range>
+    typename std::enable_if<is_range<range>::value, flatten_range<range>>::type
+    chain(range const& r)
+    {
+        return flatten_range<range>(r);
+    }
+
+    template <class container,
+        class = typename std::enable_if<!is_range<container>::value>::type>
+    flatten_range<range<container>>
+    chain(container const& con)
+    {
+        return chain(make_range(con));
+    }
+
+    // Groups a range into spans of up to n consecutive elements, so that
+    // the next stage can work on a whole block at once.  The spans point
+    // into the underlying storage when the range is contiguous, and into
+    // a buffer that is refilled for each batch otherwise.  A span is valid
+    // until the next pop_front.
+    template <class range>
+    class batch_range {
+    public:
+        using element_type = typename std::decay<typename range::value_type>::type;
+        using value_type = span<element_type const>;
+
+        batch_range(range r, size_t n)
+            : r_(std::move(r)), n_(std::max<size_t>(n, 1))
+        {
+            fill();
+        }
+
+        // A batch from the buffer is pointed at the copy's own buffer.
+        batch_range(batch_range const& that)
+            : r_(that.r_), n_(that.n_), buf_(that.buf_), batch_(that.batch_)
+        {
+            repoint(that);
+        }
+
+        batch_range& operator=(batch_range const& that)
+        {
+            r_ = that.r_;
+            n_ = that.n_;
+            buf_ = that.buf_;
+            batch_ = that.batch_;
+            repoint(that);
+            return *this;
+        }
+
+        void pop_front()
+        {
+            fill();
+        }
+
+        value_type const& front() const
+        {
+            return batch_;
+        }
+
+        bool empty() const
+        {
+            return batch_.empty();
+        }
+
+        range_iterator<batch_range> begin()
+        {
+            return range_iterator<batch_range>(*this);
+        }
+
+        range_iterator<batch_range> end()
+        {
+            return range_iterator<batch_range>();
+        }
+
+    private:
+        range r_;
+        size_t n_;
+        std::vector<element_type> buf_;
+        value_type batch_;
+
+        void repoint(batch_range const& that)
+        {
+            if (that.batch_.data() == that.buf_.data()) {
+                batch_ = value_type(buf_.data(), buf_.size());
+            }
+        }
+
+        template <class r>
+        static auto contiguous_data(r const& x, int)
+            -> decltype(x.data(), (element_type const*)(nullptr))
+        {
+            return x.data();
+        }
+
+        template <class r>
+        static element_type const* contiguous_data(r const& x, long)
+        {
+            return nullptr;
+        }
+
+        void fill()
+        {
+            element_type const* p = contiguous_data(r_, 0);
+
+            if (p != nullptr) {
+                size_t k = 0;
+                for (; k < n_ && !r_.empty(); ++k) {
+                    r_.pop_front();
+                }
+                batch_ = value_type(p, k);
+                return;
+            }
+
+            buf_.clear();
+            for (; buf_.size() < n_ && !r_.empty(); r_.pop_front()) {
+                buf_.push_back(r_.front());
+            }
+            batch_ = value_type(buf_.data(), buf_.size());
+        }
+    };
+
+    template <class range>
+    typename std::enable_if<is_range<range>::value, batch_range<range>>::type
+    batch(range const& r, size_t n)
+    {
+        return batch_range<range>(r, n);
+    }
+
+    template <class container,
+        class = typename std::enable_if<!is_range<container>::value>::type>
+    batch_range<range<container>>
+    batch(container const& con, size_t n)
+    {
+        return batch(make_range(con), n);
+    }
+
+    template <size_t... i>
+    struct index_list {};
+
+    template <size_t n, size_t... i>
+    struct make_index_list
+        : make_index_list<n - 1, n - 1, i...> {};
+
+    template <size_t... i>
+    struct make_index_list<0, i...> {
+        using type = index_list<i...>;
+    };
+
+    template <bool... b>
+    struct all_true;
+
+    template <>
+    struct all_true<> : std::true_type {};
+
+    template <bool b, bool... rest>
+    struct all_true<b, rest...>
+        : std::integral_constant<bool, b && all_true<rest...>::value> {};
+
+    // The type zip_range holds an element of a range as: a reference, or
+    // a copy for random-access ranges whose operator[] builds elements
+    // by value.
+    template <class range, bool = is_random_access_range<range>::value>
+    struct zip_element {
+        using type = typename range::value_type const&;
+    };
+
+    template <class range>
+    struct zip_element<range, true> {
+        using type = typename std::conditional<
+            std::is_reference<index_result<range>>::value,
+            typename range::value_type const&,
+            typename range::value_type>::type;
+    };
+
+    // Walks any number of ranges in lockstep, stopping at the shortest.
+    // The elements are handed out as a tuple of references, constructed
+    // in place inside the range, so nothing is allocated per element.
+    // If every range is random access, so is the zip, and operator[]
+    // returns a fresh tuple without touching the range.
+    template <class... ranges>
     class zip_range {
     public:
-        using value_type = std::tuple<typename range1::value_type const&,
-            typename range2::value_type const&>;
+        using value_type = std::tuple<typename zip_element<ranges>::type...>;
 
-        zip_range(range1 r1, range2 r2)
-            : r1_(std::move(r1)), r2_(std::move(r2)), dirty_(true), result_(nullptr)
+        zip_range(ranges... rs)
+            : rs_(std::move(rs)...)
         {}
 
         void pop_front()
         {
-            r1_.pop_front();
-            r2_.pop_front();
-            dirty_ = true;
+            pop_front(indices());
+            cache_.clear();
         }
 
         value_type const& front() const
         {
-            if (dirty_) {
-                result_.reset(new value_type(r1_.front(), r2_.front()));
-                dirty_ = false;
+            if (cache_.empty()) {
+                cache_.emplace(front(indices()));
             }
-            return *result_;
+            return cache_.get();
         }
 
         bool empty() const
         {
-            return r1_.empty() || r2_.empty();
+            return empty(indices());
+        }
+
+        template <class z = zip_range>
+        typename std::enable_if<z::random_access, size_t>::type
+        size() const
+        {
+            return size(indices());
+        }
+
+        template <class z = zip_range>
+        typename std::enable_if<z::random_access, value_type>::type
+        operator[](size_t n) const
+        {
+            return at(n, indices());
         }
 
         range_iterator<zip_range> begin()
@@ -159,30 +657,77 @@ namespace ebt {
             return range_iterator<zip_range>();
         }
 
+        static bool const random_access
+            = all_true<is_random_access_range<ranges>::value...>::value;
+
     private:
-        range1 r1_;
-        range2 r2_;
+        using indices = typename make_index_list<sizeof...(ranges)>::type;
 
-        mutable bool dirty_;
-        mutable std::shared_ptr<value_type> result_;
+        std::tuple<ranges...> rs_;
+
+        mutable element_cache<value_type> cache_;
+
+        template <size_t... i>
+        void pop_front(index_list<i...>)
+        {
+            int dummy[] = { (std::get<i>(rs_).pop_front(), 0)... };
+            (void) dummy;
+        }
+
+        template <size_t... i>
+        value_type front(index_list<i...>) const
+        {
+            return value_type(std::get<i>(rs_).front()...);
+        }
+
+        template <size_t... i>
+        bool empty(index_list<i...>) const
+        {
+            bool e[] = { std::get<i>(rs_).empty()... };
+
+            for (bool b: e) {
+                if (b) {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        template <size_t... i>
+        size_t size(index_list<i...>) const
+        {
+            size_t s[] = { size_t(std::get<i>(rs_).size())... };
+
+            size_t result = s[0];
+            for (size_t k: s) {
+                result = std::min(result, k);
+            }
+
+            return result;
+        }
+
+        template <size_t... i>
+        value_type at(size_t n, index_list<i...>) const
+        {
+            return value_type(std::get<i>(rs_)[n]...);
+        }
     };
 
-    template <class range1, class range2>
-    typename std::enable_if<
-        is_range<range1>::value && is_range<range2>::value,
-        zip_range<range1, range2>>::type
-    zip(range1 r1, range2 r2)
+    template <class... ranges>
+    typename std::enable_if<all_true<is_range<ranges>::value...>::value,
+        zip_range<ranges...>>::type
+    zip(ranges... rs)
     {
-        return zip_range<range1, range2>(r1, r2);
+        return zip_range<ranges...>(std::move(rs)...);
     }
 
-    template <class container1, class container2>
-    typename std::enable_if<
-        !is_range<container1>::value && !is_range<container2>::value,
-        zip_range<range<container1>, range<container2>>>::type
-    zip(container1& con1, container2& con2)
+    template <class... containers>
+    typename std::enable_if<all_true<!is_range<containers>::value...>::value,
+        zip_range<range<typename std::remove_const<containers>::type>...>>::type
+    zip(containers&... cons)
     {
-        return zip(make_range(con1), make_range(con2));
+        return zip(make_range(cons)...);
     }
 
 } 
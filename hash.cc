@@ -1,4 +1,6 @@
 #include "ebt/hash.h"
+#include <cstdint>
+#include <cstring>
 
 namespace ebt {
 
@@ -9,5 +11,41 @@ namespace ebt {
         return seed;
     }
 
-}
+    // MurmurHash64A by Austin Appleby, in the public domain.
+    size_t hash_bytes(void const* data, size_t size, size_t seed)
+    {
+        uint64_t const m = 0xc6a4a7935bd1e995ull;
+        int const r = 47;
+
+        unsigned char const* p = static_cast<unsigned char const*>(data);
+        uint64_t h = seed ^ (size * m);
+
+        for (; size >= 8; p += 8, size -= 8) {
+            uint64_t k;
+            std::memcpy(&k, p, 8);
+
+            k *= m;
+            k ^= k >> r;
+            k *= m;
+
+            h ^= k;
+            h *= m;
+        }
 
+        if (size > 0) {
+            uint64_t k = 0;
+            for (size_t i = 0; i < size; ++i) {
+                k |= uint64_t(p[i]) << (8 * i);
+            }
+            h ^= k;
+            h *= m;
+        }
+
+        h ^= h >> r;
+        h *= m;
+        h ^= h >> r;
+
+        return h;
+    }
+
+}
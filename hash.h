@@ -7,6 +7,8 @@ namespace ebt {
 
     size_t & hash_combine(size_t &seed, size_t value);
 
+    size_t hash_bytes(void const* data, size_t size, size_t seed = 0);
+
 }
 
 #endif
@@ -77,7 +77,7 @@ namespace ebt {
             b.index = -1;
             new_map.buckets_.resize(prime_size_scales[size_scale], b);
 
-            for (int i = 0; i < buckets_.size(); ++i) {
+            for (size_t i = 0; i < buckets_.size(); ++i) {
                 if (!buckets_.at(i).empty()) {
                     buckets_.at(i).base = buckets_.at(i).hash % new_map.buckets_.size();
                     new_map.insert_bucket(std::move(buckets_.at(i)));
@@ -105,7 +105,8 @@ namespace ebt {
             downsize_check(hashmap<K, V>& m)
                 : map(m)
             {
-                if (map.size_ < prime_size_scales[map.size_scale_] * 0.33) {
+                if (map.size_scale_ > 0
+                        && map.size_ < prime_size_scales[map.size_scale_] * 0.33) {
                     map.rehash(map.size_scale_ - 1);
                 }
             }
@@ -241,14 +242,14 @@ namespace ebt {
 
             bool done = false;
 
-            for (int i = b.base; !done && i < buckets_.size(); ++i) {
-                int base = b.base;
+            for (size_t i = b.base; !done && i < buckets_.size(); ++i) {
+                size_t base = b.base;
                 int probe_count = (i >= base ? i - base : i + buckets_.size() - base);
                 done = probe(i, probe_count);
             }
 
-            for (int i = 0; !done && i < buckets_.size(); ++i) {
-                int base = b.base;
+            for (size_t i = 0; !done && i < buckets_.size(); ++i) {
+                size_t base = b.base;
                 int probe_count = (i >= base ? i - base : i + buckets_.size() - base);
                 done = probe(i, probe_count);
             }
@@ -371,8 +372,9 @@ namespace ebt {
 
             };
 
-            for (int i = b.base; i < buckets_.size(); ++i) {
-                int probe_count = (i >= b.base ? i - b.base : i + buckets_.size() - b.base);
+            for (size_t i = b.base; i < buckets_.size(); ++i) {
+                size_t base = b.base;
+                int probe_count = (i >= base ? i - base : i + buckets_.size() - base);
                 auto r = probe(i, probe_count);
                 if (r == probe_result::key_found) {
                     return key_values_.at(buckets_.at(i).index).second;
@@ -381,8 +383,9 @@ namespace ebt {
                 }
             }
 
-            for (int i = 0; i < buckets_.size(); ++i) {
-                int probe_count = (i >= b.base ? i - b.base : i + buckets_.size() - b.base);
+            for (size_t i = 0; i < buckets_.size(); ++i) {
+                size_t base = b.base;
+                int probe_count = (i >= base ? i - base : i + buckets_.size() - base);
                 auto r = probe(i, probe_count);
                 if (r == probe_result::key_found) {
                     return key_values_.at(buckets_.at(i).index).second;
@@ -409,7 +412,18 @@ namespace ebt {
                 throw std::out_of_range("cannot find key");
             }
 
-            key_values_.erase(key_values_.begin() + i);
+            // Keep the entries packed in [0, size_) by moving the last one
+            // into the hole.
+            int index = buckets_.at(i).index;
+            int last = size_ - 1;
+
+            if (index != last) {
+                int j = search(key_values_.at(last).first);
+                key_values_.at(index) = std::move(key_values_.at(last));
+                buckets_.at(j).index = index;
+            }
+
+            key_values_.at(last) = std::pair<K, V>();
 
             auto probe = [&](int j) {
                 int prev = (j == 0 ? int(buckets_.size()) - 1 : j - 1);
@@ -437,11 +451,11 @@ namespace ebt {
 
             bool done = false;
 
-            for (int j = i + 1; !done && j < buckets_.size(); ++j) {
+            for (size_t j = i + 1; !done && j < buckets_.size(); ++j) {
                 done = probe(j);
             }
 
-            for (int j = 0; !done && j < buckets_.size(); ++j) {
+            for (size_t j = 0; !done && j < buckets_.size(); ++j) {
                 done = probe(j);
             }
 
@@ -457,11 +471,50 @@ namespace ebt {
             return search(key) != -1;
         }
 
+        V const* find(K const& key) const
+        {
+            int i = search(key);
+
+            return i == -1 ? nullptr : &key_values_.at(buckets_.at(i).index).second;
+        }
+
+        V* find(K const& key)
+        {
+            int i = search(key);
+
+            return i == -1 ? nullptr : &key_values_.at(buckets_.at(i).index).second;
+        }
+
         int size() const
         {
             return size_;
         }
 
+        using iterator = typename std::vector<std::pair<K, V>>::iterator;
+        using const_iterator = typename std::vector<std::pair<K, V>>::const_iterator;
+
+        // Iterates over the entries, in insertion order until something is
+        // erased.
+        iterator begin()
+        {
+            return key_values_.begin();
+        }
+
+        iterator end()
+        {
+            return key_values_.begin() + size_;
+        }
+
+        const_iterator begin() const
+        {
+            return key_values_.begin();
+        }
+
+        const_iterator end() const
+        {
+            return key_values_.begin() + size_;
+        }
+
     };
 
 }
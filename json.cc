@@ -1,6 +1,10 @@
 #include "ebt/json.h"
 #include "ebt/string.h"
 #include "ebt/exception.h"
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <limits>
 
 namespace ebt {
 
@@ -31,120 +35,105 @@ namespace ebt {
             os << d;
         }
 
-        float json_parser<float>::parse(std::istream& is)
+        bool scan_digits(std::istream& is, std::string& s)
         {
-            std::string s;
-
-            std::string non_zeros = "123456789";
-            std::string digits = "0123456789";
+            bool found = false;
 
-            if (is.peek() == '+') {
-                s.append(1, is.get());
-            } else if (is.peek() == '-') {
+            while (std::isdigit(is.peek())) {
                 s.append(1, is.get());
+                found = true;
             }
 
-            if (non_zeros.find(is.peek()) != std::string::npos) {
-                s.append(1, is.get());
-            }
+            return found;
+        }
 
-            while (digits.find(is.peek()) != std::string::npos) {
+        bool scan_number(std::istream& is, std::string& s, std::string& exponent)
+        {
+            if (is.peek() == '+' || is.peek() == '-') {
                 s.append(1, is.get());
             }
 
+            bool found = scan_digits(is, s);
+
             if (is.peek() == '.') {
                 s.append(1, is.get());
-
-                while (digits.find(is.peek()) != std::string::npos) {
-                    s.append(1, is.get());
-                }
+                found = scan_digits(is, s) || found;
             }
 
-            std::string exponent;
+            if (!found) {
+                return false;
+            }
 
             if (is.peek() == 'e') {
                 s.append(1, is.get());
 
-                if (is.peek() == '+') {
-                    exponent.append(1, is.get());
-                } else if (is.peek() == '-') {
+                if (is.peek() == '+' || is.peek() == '-') {
                     exponent.append(1, is.get());
                 }
 
-                while (digits.find(is.peek()) != std::string::npos) {
-                    exponent.append(1, is.get());
-                }
-            }
-
-            if (exponent != "" && std::stoi(exponent) <= -308) {
-                return 0;
+                return scan_digits(is, exponent);
             }
 
-            s += exponent;
-
-            return std::stof(s);
+            return true;
         }
 
-        double json_parser<double>::parse(std::istream& is)
+        bool json_parser<float>::try_parse(std::istream& is, float& f, parse_status& status)
         {
             std::string s;
+            std::string exponent;
 
-            std::string non_zeros = "123456789";
-            std::string digits = "0123456789";
-
-            if (is.peek() == '+') {
-                s.append(1, is.get());
-            } else if (is.peek() == '-') {
-                s.append(1, is.get());
-            }
-
-            if (non_zeros.find(is.peek()) != std::string::npos) {
-                s.append(1, is.get());
+            if (!scan_number(is, s, exponent)) {
+                return fail(is, parse_error::invalid_number, status);
             }
 
-            while (digits.find(is.peek()) != std::string::npos) {
-                s.append(1, is.get());
+            if (exponent != "" && std::strtol(exponent.c_str(), nullptr, 10) <= -308) {
+                f = 0;
+                return true;
             }
 
-            if (is.peek() == '.') {
-                s.append(1, is.get());
+            s += exponent;
 
-                while (digits.find(is.peek()) != std::string::npos) {
-                    s.append(1, is.get());
-                }
-            }
+            errno = 0;
+            f = std::strtof(s.c_str(), nullptr);
 
-            std::string exponent;
+            return errno != ERANGE || fail(is, parse_error::invalid_number, status);
+        }
 
-            if (is.peek() == 'e') {
-                s.append(1, is.get());
+        float json_parser<float>::parse(std::istream& is)
+        {
+            return parse_or_throw(*this, is);
+        }
 
-                if (is.peek() == '+') {
-                    exponent.append(1, is.get());
-                } else if (is.peek() == '-') {
-                    exponent.append(1, is.get());
-                }
+        bool json_parser<double>::try_parse(std::istream& is, double& d, parse_status& status)
+        {
+            std::string s;
+            std::string exponent;
 
-                while (digits.find(is.peek()) != std::string::npos) {
-                    exponent.append(1, is.get());
-                }
+            if (!scan_number(is, s, exponent)) {
+                return fail(is, parse_error::invalid_number, status);
             }
 
-            if (exponent != "" && std::stoi(exponent) <= -308) {
-                return 0;
+            if (exponent != "" && std::strtol(exponent.c_str(), nullptr, 10) <= -308) {
+                d = 0;
+                return true;
             }
 
             s += exponent;
 
-            return std::stod(s);
+            errno = 0;
+            d = std::strtod(s.c_str(), nullptr);
+
+            return errno != ERANGE || fail(is, parse_error::invalid_number, status);
         }
 
-        int json_parser<int>::parse(std::istream& is)
+        double json_parser<double>::parse(std::istream& is)
         {
-            std::string s;
+            return parse_or_throw(*this, is);
+        }
 
-            std::string non_zeros = "123456789";
-            std::string digits = "0123456789";
+        bool json_parser<int>::try_parse(std::istream& is, int& i, parse_status& status)
+        {
+            std::string s;
 
             if (is.peek() == '+') {
                 is.get();
@@ -152,44 +141,97 @@ namespace ebt {
                 s.append(1, is.get());
             }
 
-            if (non_zeros.find(is.peek()) != std::string::npos) {
-                s.append(1, is.get());
+            if (!scan_digits(is, s)) {
+                return fail(is, parse_error::invalid_number, status);
             }
 
-            while (digits.find(is.peek()) != std::string::npos) {
-                s.append(1, is.get());
+            errno = 0;
+            long v = std::strtol(s.c_str(), nullptr, 10);
+
+            if (errno == ERANGE || v < std::numeric_limits<int>::min()
+                    || v > std::numeric_limits<int>::max()) {
+                return fail(is, parse_error::invalid_number, status);
             }
 
-            return std::stoi(s);
+            i = v;
+            return true;
         }
 
-        std::string json_parser<std::string>::parse(std::istream& is)
+        int json_parser<int>::parse(std::istream& is)
         {
-            std::string result;
-            expect(is, '"');
+            return parse_or_throw(*this, is);
+        }
+
+        bool json_parser<std::string>::try_parse(std::istream& is, std::string& result,
+            parse_status& status)
+        {
+            result.clear();
+
+            if (!try_expect(is, '"', status)) {
+                return false;
+            }
             is.get();
-            char c[2];
-            c[1] = '\0';
             while (is.peek() != '"') {
+                if (is.peek() == std::char_traits<char>::eof()) {
+                    return fail(is, parse_error::unexpected_char, status, '"');
+                }
                 if (is.peek() == '\\') {
                     is.get();
                     if (is.peek() != '"' && is.peek() != '\\') {
-                        throw parser_exception(
-                            "can only escape \" and \\");
+                        return fail(is, parse_error::invalid_escape, status);
                     }
                 }
-                c[0] = is.get();
-                result.append(std::string(c));
+                result.append(1, is.get());
             }
             is.get();
-            return result;
+            return true;
+        }
+
+        std::string json_parser<std::string>::parse(std::istream& is)
+        {
+            return parse_or_throw(*this, is);
+        }
+
+        std::string error_message(parse_status const& status)
+        {
+            switch (status.error) {
+            case parse_error::none:
+                return "";
+            case parse_error::unexpected_char:
+                if (status.expected == 0) {
+                    return format("unexpected: <{}> ", status.actual);
+                }
+                return format("expected: <{}> actual: <{}> ",
+                    char(status.expected), status.actual);
+            case parse_error::invalid_escape:
+                return "can only escape \" and \\";
+            case parse_error::invalid_number:
+                return format("invalid number before: <{}> ", status.actual);
+            case parse_error::unknown_field:
+                return format("unknown field before: <{}> ", status.actual);
+            }
+
+            return "";
+        }
+
+        bool fail(std::istream& is, parse_error error, parse_status& status,
+            int expected)
+        {
+            status.error = error;
+            status.offset = is.rdbuf() == nullptr ? -1
+                : std::streamoff(is.rdbuf()->pubseekoff(0, std::ios_base::cur, std::ios_base::in));
+            status.expected = expected;
+            status.actual = is.peek();
+
+            return false;
         }
 
         void expect(std::istream& is, char c)
         {
-            if (is.peek() != c) {
-                throw parser_exception(format(
-                    "expected: <{}> actual: <{}> ", c, is.peek()));
+            parse_status status;
+
+            if (!try_expect(is, c, status)) {
+                throw parser_exception(error_message(status));
             }
         }
 
@@ -9,7 +9,9 @@
 #include <unordered_map>
 #include <utility>
 #include "ebt/string.h"
+#include "ebt/exception.h"
 #include <complex>
+#include <tuple>
 
 namespace ebt {
 
@@ -142,12 +144,97 @@ namespace ebt {
             }
         };
 
+        enum class parse_error {
+            none,
+            unexpected_char,
+            invalid_escape,
+            invalid_number,
+            unknown_field
+        };
+
+        struct parse_status {
+            parse_error error;
+            std::streamoff offset;
+            int expected;
+            int actual;
+
+            explicit operator bool() const
+            {
+                return error == parse_error::none;
+            }
+        };
+
+        std::string error_message(parse_status const& status);
+
+        // Records the failure in status and returns false.  Kept out of
+        // line so that the error path costs nothing when parsing succeeds.
+        bool fail(std::istream& is, parse_error error, parse_status& status,
+            int expected = 0);
+
+        inline bool try_expect(std::istream& is, char c, parse_status& status)
+        {
+            return is.peek() == c
+                || fail(is, parse_error::unexpected_char, status, c);
+        }
+
         void expect(std::istream& is, char c);
         void whitespace(std::istream& is);
 
         template <class T>
         struct json_parser;
 
+        template <class T>
+        struct has_try_parse {
+            template <class U> static long f(decltype(std::declval<json_parser<U>&>()
+                .try_parse(std::declval<std::istream&>(), std::declval<U&>(),
+                    std::declval<parse_status&>()))*);
+            template <class U> static char f(...);
+
+            static bool const value = (sizeof(f<T>(nullptr)) == sizeof(long));
+        };
+
+        template <class T>
+        typename std::enable_if<has_try_parse<T>::value, bool>::type
+        try_parse(json_parser<T>& parser, std::istream& is, T& t, parse_status& status)
+        {
+            return parser.try_parse(is, t, status);
+        }
+
+        // Parsers that only provide parse() report errors by throwing.
+        template <class T>
+        typename std::enable_if<!has_try_parse<T>::value, bool>::type
+        try_parse(json_parser<T>& parser, std::istream& is, T& t, parse_status& status)
+        {
+            try {
+                t = parser.parse(is);
+                return true;
+            } catch (parser_exception const&) {
+                return fail(is, parse_error::unexpected_char, status);
+            }
+        }
+
+        template <class T>
+        T parse_or_throw(json_parser<T>& parser, std::istream& is)
+        {
+            T result;
+            parse_status status;
+
+            if (!parser.try_parse(is, result, status)) {
+                throw parser_exception(error_message(status));
+            }
+
+            return result;
+        }
+
+        template <class T>
+        parse_status try_load(std::istream& is, T& t)
+        {
+            json_parser<T> parser;
+            parse_status status { parse_error::none, 0, 0, 0 };
+            try_parse(parser, is, t, status);
+            return status;
+        }
+
         template <class T>
         T load(std::istream& is)
         {
@@ -156,54 +243,79 @@ namespace ebt {
 
         template <>
         struct json_parser<int> {
+            bool try_parse(std::istream& is, int& i, parse_status& status);
             int parse(std::istream& is);
         };
 
         template <>
         struct json_parser<float> {
+            bool try_parse(std::istream& is, float& f, parse_status& status);
             float parse(std::istream& is);
         };
 
         template <>
         struct json_parser<double> {
+            bool try_parse(std::istream& is, double& d, parse_status& status);
             double parse(std::istream& is);
         };
 
         template <>
         struct json_parser<std::string> {
+            bool try_parse(std::istream& is, std::string& str, parse_status& status);
             std::string parse(std::istream& is);
         };
 
         template <class T>
         struct json_parser<std::complex<T>> {
-            std::complex<T> parse(std::istream& is)
+            bool try_parse(std::istream& is, std::complex<T>& c, parse_status& status)
             {
                 json_parser<T> t_parser;
-                expect(is, '(');
+                T real;
+                T imag;
+
+                if (!try_expect(is, '(', status)) {
+                    return false;
+                }
                 is.get();
-                T real = t_parser.parse(is);
-                expect(is, ',');
+                if (!json::try_parse(t_parser, is, real, status)
+                        || !try_expect(is, ',', status)) {
+                    return false;
+                }
                 is.get();
-                T imag = t_parser.parse(is);
-                expect(is, ')');
+                if (!json::try_parse(t_parser, is, imag, status)
+                        || !try_expect(is, ')', status)) {
+                    return false;
+                }
                 is.get();
-                return {real, imag};
+
+                c = std::complex<T>(real, imag);
+                return true;
+            }
+
+            std::complex<T> parse(std::istream& is)
+            {
+                return parse_or_throw(*this, is);
             }
         };
 
         template <class T>
         struct json_parser<std::vector<T>> {
-            std::vector<T> parse(std::istream& is)
+            bool try_parse(std::istream& is, std::vector<T>& result, parse_status& status)
             {
-                std::vector<T> result;
                 json_parser<T> elem_parser;
+                result.clear();
 
-                expect(is, '[');
+                if (!try_expect(is, '[', status)) {
+                    return false;
+                }
                 is.get();
                 whitespace(is);
 
                 while (is.peek() != ']') {
-                    result.push_back(elem_parser.parse(is));
+                    result.emplace_back();
+                    if (!json::try_parse(elem_parser, is, result.back(), status)) {
+                        return false;
+                    }
                     whitespace(is);
 
                     if (is.peek() == ',') {
@@ -214,33 +326,48 @@ namespace ebt {
                     }
                 }
 
-                expect(is, ']');
+                if (!try_expect(is, ']', status)) {
+                    return false;
+                }
                 is.get();
 
-                return result;
+                return true;
+            }
+
+            std::vector<T> parse(std::istream& is)
+            {
+                return parse_or_throw(*this, is);
             }
         };
 
         template <class V>
         struct json_parser<std::unordered_map<std::string, V>> {
-            std::unordered_map<std::string, V> parse(std::istream& is)
+            bool try_parse(std::istream& is, std::unordered_map<std::string, V>& result,
+                parse_status& status)
             {
-                std::unordered_map<std::string, V> result;
+                json_parser<std::string> key_parser;
                 json_parser<V> value_parser;
+                std::string key;
+                result.clear();
 
-                expect(is, '{');
+                if (!try_expect(is, '{', status)) {
+                    return false;
+                }
                 is.get();
                 whitespace(is);
 
                 while (is.peek() != '}') {
-                    json_parser<std::string> key_parser;
-                    auto key = key_parser.parse(is);
-
-                    expect(is, ':');
+                    key.clear();
+                    if (!key_parser.try_parse(is, key, status)
+                            || !try_expect(is, ':', status)) {
+                        return false;
+                    }
                     is.get();
                     whitespace(is);
 
-                    result[key] = value_parser.parse(is);
+                    if (!json::try_parse(value_parser, is, result[key], status)) {
+                        return false;
+                    }
                     whitespace(is);
 
                     if (is.peek() == ',') {
@@ -251,45 +378,70 @@ namespace ebt {
                     }
                 }
 
-                expect(is, '}');
+                if (!try_expect(is, '}', status)) {
+                    return false;
+                }
                 is.get();
 
-                return result;
+                return true;
+            }
+
+            std::unordered_map<std::string, V> parse(std::istream& is)
+            {
+                return parse_or_throw(*this, is);
             }
         };
 
-        template <class First, class... Args>
+        template <int i, int n, class... Args>
         struct parse_tuple {
-            std::tuple<First, Args...> operator()(std::istream& is)
+            bool operator()(std::istream& is, std::tuple<Args...>& t, parse_status& status)
             {
-                json_parser<First> first_parser;
-                auto first = std::make_tuple(first_parser.parse(is));
-                expect(is, ',');
-                is.get();
-                whitespace(is);
-                return std::tuple_cat(first, parse_tuple<Args...>()(is));
+                using elem_type = typename std::tuple_element<i, std::tuple<Args...>>::type;
+                json_parser<elem_type> elem_parser;
+
+                if (!json::try_parse(elem_parser, is, std::get<i>(t), status)) {
+                    return false;
+                }
+
+                if (i + 1 < n) {
+                    if (!try_expect(is, ',', status)) {
+                        return false;
+                    }
+                    is.get();
+                    whitespace(is);
+                }
+
+                return parse_tuple<i + 1, n, Args...>()(is, t, status);
             }
         };
 
-        template <class Last>
-        struct parse_tuple<Last> {
-            std::tuple<Last> operator()(std::istream& is)
+        template <int n, class... Args>
+        struct parse_tuple<n, n, Args...> {
+            bool operator()(std::istream& is, std::tuple<Args...>& t, parse_status& status)
             {
-                json_parser<Last> last_parser;
-                return std::make_tuple(last_parser.parse(is));
+                return true;
             }
         };
 
         template <class... Args>
         struct json_parser<std::tuple<Args...>> {
-            std::tuple<Args...> parse(std::istream& is)
+            bool try_parse(std::istream& is, std::tuple<Args...>& result, parse_status& status)
             {
-                expect(is, '(');
+                if (!try_expect(is, '(', status)) {
+                    return false;
+                }
                 is.get();
-                auto result = parse_tuple<Args...>()(is);
-                expect(is, ')');
+                if (!parse_tuple<0, sizeof...(Args), Args...>()(is, result, status)
+                        || !try_expect(is, ')', status)) {
+                    return false;
+                }
                 is.get();
-                return result;
+                return true;
+            }
+
+            std::tuple<Args...> parse(std::istream& is)
+            {
+                return parse_or_throw(*this, is);
             }
         };
 
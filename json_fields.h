@@ -0,0 +1,164 @@
+#ifndef EBT_JSON_FIELDS_H
+#define EBT_JSON_FIELDS_H
+
+#include "ebt/json.h"
+#include <cstdint>
+
+namespace ebt {
+
+    namespace json {
+
+        constexpr uint64_t field_hash(char const* s,
+            uint64_t h = 14695981039346656037ull)
+        {
+            return *s == '\0' ? h
+                : field_hash(s + 1, (h ^ uint64_t((unsigned char) *s)) * 1099511628211ull);
+        }
+
+        inline uint64_t field_hash(std::string const& s)
+        {
+            uint64_t h = 14695981039346656037ull;
+
+            for (auto c: s) {
+                h = (h ^ uint64_t((unsigned char) c)) * 1099511628211ull;
+            }
+
+            return h;
+        }
+
+        template <class T>
+        bool parse_member(std::istream& is, T& t, parse_status& status)
+        {
+            json_parser<T> parser;
+            return json::try_parse(parser, is, t, status);
+        }
+
+        // Parses a json object, handing each key to parser.parse_field,
+        // which decodes the value straight into the matching member.
+        template <class T>
+        bool parse_object(std::istream& is, T& t, parse_status& status,
+            json_parser<T>& parser)
+        {
+            json_parser<std::string> key_parser;
+            std::string key;
+
+            if (!try_expect(is, '{', status)) {
+                return false;
+            }
+            is.get();
+            whitespace(is);
+
+            while (is.peek() != '}') {
+                key.clear();
+                if (!key_parser.try_parse(is, key, status)) {
+                    return false;
+                }
+                whitespace(is);
+                if (!try_expect(is, ':', status)) {
+                    return false;
+                }
+                is.get();
+                whitespace(is);
+
+                if (!parser.parse_field(is, t, key, status)) {
+                    return false;
+                }
+                whitespace(is);
+
+                if (is.peek() == ',') {
+                    is.get();
+                    whitespace(is);
+                } else {
+                    break;
+                }
+            }
+
+            if (!try_expect(is, '}', status)) {
+                return false;
+            }
+            is.get();
+
+            return true;
+        }
+
+    }
+}
+
+#define EBT_PP_CAT(a, b) EBT_PP_CAT_(a, b)
+#define EBT_PP_CAT_(a, b) a ## b
+
+#define EBT_PP_NARGS(...) EBT_PP_NARGS_(__VA_ARGS__, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1)
+#define EBT_PP_NARGS_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, n, ...) n
+
+#define EBT_FOR_EACH(m, ...) EBT_PP_CAT(EBT_FOR_EACH_, EBT_PP_NARGS(__VA_ARGS__))(m, __VA_ARGS__)
+#define EBT_FOR_EACH_1(m, x) m(x)
+#define EBT_FOR_EACH_2(m, x, ...) m(x) EBT_FOR_EACH_1(m, __VA_ARGS__)
+#define EBT_FOR_EACH_3(m, x, ...) m(x) EBT_FOR_EACH_2(m, __VA_ARGS__)
+#define EBT_FOR_EACH_4(m, x, ...) m(x) EBT_FOR_EACH_3(m, __VA_ARGS__)
+#define EBT_FOR_EACH_5(m, x, ...) m(x) EBT_FOR_EACH_4(m, __VA_ARGS__)
+#define EBT_FOR_EACH_6(m, x, ...) m(x) EBT_FOR_EACH_5(m, __VA_ARGS__)
+#define EBT_FOR_EACH_7(m, x, ...) m(x) EBT_FOR_EACH_6(m, __VA_ARGS__)
+#define EBT_FOR_EACH_8(m, x, ...) m(x) EBT_FOR_EACH_7(m, __VA_ARGS__)
+#define EBT_FOR_EACH_9(m, x, ...) m(x) EBT_FOR_EACH_8(m, __VA_ARGS__)
+#define EBT_FOR_EACH_10(m, x, ...) m(x) EBT_FOR_EACH_9(m, __VA_ARGS__)
+#define EBT_FOR_EACH_11(m, x, ...) m(x) EBT_FOR_EACH_10(m, __VA_ARGS__)
+#define EBT_FOR_EACH_12(m, x, ...) m(x) EBT_FOR_EACH_11(m, __VA_ARGS__)
+#define EBT_FOR_EACH_13(m, x, ...) m(x) EBT_FOR_EACH_12(m, __VA_ARGS__)
+#define EBT_FOR_EACH_14(m, x, ...) m(x) EBT_FOR_EACH_13(m, __VA_ARGS__)
+#define EBT_FOR_EACH_15(m, x, ...) m(x) EBT_FOR_EACH_14(m, __VA_ARGS__)
+#define EBT_FOR_EACH_16(m, x, ...) m(x) EBT_FOR_EACH_15(m, __VA_ARGS__)
+
+#define EBT_JSON_WRITE_FIELD(f) \
+    os << sep << "\"" #f "\": "; \
+    ::ebt::json::dump(t.f, os); \
+    sep = ", ";
+
+#define EBT_JSON_PARSE_FIELD(f) \
+    case ::ebt::json::field_hash(#f): \
+        if (key == #f) { \
+            return ::ebt::json::parse_member(is, t.f, status); \
+        } \
+        break;
+
+// Generates json_writer and json_parser specializations that read and
+// write the listed members of type as a json object, e.g.
+//
+//     EBT_FIELDS(point, x, y)
+//
+// Must be used at global scope, with between 1 and 16 fields.
+#define EBT_FIELDS(type, ...) \
+    namespace ebt { \
+    namespace json { \
+        template <> \
+        struct json_writer<type> { \
+            void write(type const& t, std::ostream& os) \
+            { \
+                char const* sep = ""; \
+                os << "{"; \
+                EBT_FOR_EACH(EBT_JSON_WRITE_FIELD, __VA_ARGS__) \
+                os << "}"; \
+            } \
+        }; \
+        template <> \
+        struct json_parser<type> { \
+            bool parse_field(std::istream& is, type& t, std::string const& key, \
+                parse_status& status) \
+            { \
+                switch (field_hash(key)) { \
+                EBT_FOR_EACH(EBT_JSON_PARSE_FIELD, __VA_ARGS__) \
+                } \
+                return fail(is, parse_error::unknown_field, status); \
+            } \
+            bool try_parse(std::istream& is, type& t, parse_status& status) \
+            { \
+                return parse_object(is, t, status, *this); \
+            } \
+            type parse(std::istream& is) \
+            { \
+                return parse_or_throw(*this, is); \
+            } \
+        }; \
+    } \
+    }
+
+#endif
@@ -0,0 +1,223 @@
+#include "ebt/line_reader.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ebt {
+
+    void line_range::pop_front()
+    {
+        if (next_ == end_) {
+            done_ = true;
+            return;
+        }
+
+        void const* p = std::memchr(next_, '\n', end_ - next_);
+        char const* e = (p == nullptr ? end_ : static_cast<char const*>(p));
+
+        line_ = string_ref(next_, e - next_);
+        next_ = (e == end_ ? end_ : e + 1);
+    }
+
+    std::runtime_error read_error(std::string const& what, std::string const& path)
+    {
+        return std::runtime_error("line_reader: " + what + " " + path + ": "
+            + std::strerror(errno));
+    }
+
+    line_reader::line_reader(std::string const& path, size_t block_size)
+        : path_(path), data_(nullptr), size_(0), mapped_(false), fd_(-1), eof_(false)
+        , block_size_(std::max<size_t>(block_size, 1)), current_(0)
+    {
+        for (auto& b: ring_) {
+            b = block { nullptr, 0, 0, 0 };
+        }
+
+        int fd = ::open(path.c_str(), O_RDONLY);
+
+        if (fd == -1) {
+            throw read_error("cannot open", path);
+        }
+
+        struct stat st;
+        bool regular = (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode));
+
+        if (regular && st.st_size > 0) {
+            void* p = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if (p != MAP_FAILED) {
+                ::madvise(p, st.st_size, MADV_SEQUENTIAL);
+                data_ = static_cast<char const*>(p);
+                size_ = st.st_size;
+                mapped_ = true;
+                ::close(fd);
+                return;
+            }
+        }
+
+        // Read-ahead hints only mean something for files; pipes reject
+        // them.
+#ifdef POSIX_FADV_SEQUENTIAL
+        if (regular) {
+            ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        }
+#endif
+
+        fd_ = fd;
+    }
+
+    line_reader::~line_reader()
+    {
+        if (mapped_) {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+
+        for (auto& b: ring_) {
+            std::free(b.data);
+        }
+
+        if (fd_ != -1) {
+            ::close(fd_);
+        }
+    }
+
+    string_ref line_reader::contents() const
+    {
+        if (!mapped_) {
+            throw std::logic_error("line_reader: " + path_ + " is streamed");
+        }
+
+        return string_ref(data_, size_);
+    }
+
+    block_range<line_range> line_reader::lines()
+    {
+        if (mapped_) {
+            return block_range<line_range>(contents(), nullptr);
+        }
+
+        return block_range<line_range>(next_block(), this);
+    }
+
+    block_range<split_range> line_reader::tokens()
+    {
+        if (mapped_) {
+            return block_range<split_range>(contents(), nullptr);
+        }
+
+        return block_range<split_range>(next_block(), this);
+    }
+
+    std::vector<string_ref> line_reader::chunks(int n) const
+    {
+        return newline_chunks(contents(), n);
+    }
+
+    void line_reader::grow(block& b, size_t capacity)
+    {
+        void* p = nullptr;
+
+        if (::posix_memalign(&p, 4096, capacity) != 0) {
+            throw std::bad_alloc();
+        }
+
+        if (b.size > 0) {
+            std::memcpy(p, b.data, b.size);
+        }
+
+        std::free(b.data);
+        b.data = static_cast<char*>(p);
+        b.capacity = capacity;
+    }
+
+    string_ref line_reader::next_block()
+    {
+        block& prev = ring_[current_];
+        current_ = (current_ + 1) % block_count;
+        block& b = ring_[current_];
+
+        size_t carry = prev.size - prev.lines;
+        b.size = 0;
+        b.lines = 0;
+
+        if (b.capacity < std::max(block_size_, carry + 1)) {
+            grow(b, std::max(block_size_, 2 * carry));
+        }
+
+        if (carry > 0) {
+            std::memcpy(b.data, prev.data + prev.lines, carry);
+        }
+        b.size = carry;
+
+        while (true) {
+            while (!eof_ && b.size < b.capacity) {
+                ssize_t n = ::read(fd_, b.data + b.size, b.capacity - b.size);
+
+                if (n < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    throw read_error("cannot read", path_);
+                }
+
+                if (n == 0) {
+                    eof_ = true;
+                }
+
+                b.size += n;
+            }
+
+            if (eof_) {
+                b.lines = b.size;
+                break;
+            }
+
+            void const* p = ::memrchr(b.data, '\n', b.size);
+
+            if (p != nullptr) {
+                b.lines = static_cast<char const*>(p) - b.data + 1;
+                break;
+            }
+
+            // No newline in a full block: the line is longer than a block.
+            grow(b, 2 * b.capacity);
+        }
+
+        return string_ref(b.data, b.lines);
+    }
+
+    std::vector<string_ref> newline_chunks(string_ref s, int n)
+    {
+        std::vector<string_ref> result;
+
+        char const* b = s.data();
+        char const* end = s.data() + s.size();
+
+        for (int i = n; i > 0 && b != end; --i) {
+            char const* e = b + (end - b) / i;
+
+            if (i == 1) {
+                e = end;
+            } else if (e != b && e[-1] != '\n') {
+                void const* p = std::memchr(e, '\n', end - e);
+                e = (p == nullptr ? end : static_cast<char const*>(p) + 1);
+            }
+
+            if (e != b) {
+                result.push_back(string_ref(b, e - b));
+            }
+
+            b = e;
+        }
+
+        return result;
+    }
+
+}
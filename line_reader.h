@@ -0,0 +1,266 @@
+#ifndef EBT_LINE_READER_H
+#define EBT_LINE_READER_H
+
+#include "ebt/range.h"
+#include "ebt/string.h"
+#include "ebt/string_ref.h"
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ebt {
+
+    // A range over the lines of a buffer as views, without the trailing
+    // newline.  As with std::getline, a final newline does not start an
+    // extra empty line.
+    class line_range {
+    public:
+        using value_type = string_ref;
+
+        explicit line_range(string_ref s)
+            : next_(s.data()), end_(s.data() + s.size()), done_(false)
+        {
+            pop_front();
+        }
+
+        void pop_front();
+
+        value_type const& front() const
+        {
+            return line_;
+        }
+
+        bool empty() const
+        {
+            return done_;
+        }
+
+        range_iterator<line_range> begin()
+        {
+            return range_iterator<line_range>(*this);
+        }
+
+        range_iterator<line_range> end()
+        {
+            return range_iterator<line_range>();
+        }
+
+    private:
+        string_ref line_;
+        char const* next_;
+        char const* end_;
+        bool done_;
+    };
+
+    class line_reader;
+
+    // Applies the range R to each piece of a line_reader's input in turn,
+    // so that lines and tokens can be read from a streamed file.
+    template <class R>
+    class block_range {
+    public:
+        using value_type = typename R::value_type;
+
+        block_range(string_ref first, line_reader* source)
+            : r_(first), source_(source)
+        {
+            skip();
+        }
+
+        void pop_front()
+        {
+            r_.pop_front();
+            skip();
+        }
+
+        value_type const& front() const
+        {
+            return r_.front();
+        }
+
+        bool empty() const
+        {
+            return r_.empty();
+        }
+
+        range_iterator<block_range> begin()
+        {
+            return range_iterator<block_range>(*this);
+        }
+
+        range_iterator<block_range> end()
+        {
+            return range_iterator<block_range>();
+        }
+
+    private:
+        R r_;
+        line_reader* source_;
+
+        void skip();
+    };
+
+    // Hands out the lines and tokens of a file as views.  A regular file
+    // is mapped into memory, and the views stay valid for the lifetime
+    // of the reader.  Anything else, such as a pipe, is streamed through
+    // a ring of aligned blocks of block_size bytes, each ending after a
+    // newline, with the partial last line carried into the next block.
+    // A line longer than a block grows its block.
+    //
+    // Streamed input can be read once, and its views stay valid only
+    // until the block after the next one is read.
+    class line_reader {
+    public:
+        explicit line_reader(std::string const& path, size_t block_size = 1 << 24);
+        ~line_reader();
+
+        line_reader(line_reader const&) = delete;
+        line_reader& operator=(line_reader const&) = delete;
+
+        bool mapped() const
+        {
+            return mapped_;
+        }
+
+        // The whole file.  Only for mapped files.
+        string_ref contents() const;
+
+        block_range<line_range> lines();
+
+        // Whitespace-separated tokens, as split does.
+        block_range<split_range> tokens();
+
+        // Cuts a mapped file into at most n pieces that end right after a
+        // newline, so that no line straddles two pieces.
+        std::vector<string_ref> chunks(int n) const;
+
+        // Calls f(chunk) for newline-aligned chunks of the input on the
+        // given number of threads.  A streamed file is handed out a block
+        // at a time, and the next block is read while the threads work
+        // on the current one.  f must be safe to call concurrently.  The
+        // first exception thrown by f is rethrown once the threads are
+        // done.
+        template <class func>
+        void for_each_chunk(int threads, func f);
+
+        // Calls f(line) for every line.  Lines of one chunk are visited in
+        // order.
+        template <class func>
+        void for_each_line(int threads, func f)
+        {
+            for_each_chunk(threads, [&f](string_ref c) {
+                for (line_range r(c); !r.empty(); r.pop_front()) {
+                    f(r.front());
+                }
+            });
+        }
+
+    private:
+        struct block {
+            char* data;
+            size_t capacity;
+            size_t size;
+
+            // The length of the prefix that holds whole lines.
+            size_t lines;
+        };
+
+        static constexpr int block_count = 2;
+
+        std::string path_;
+        char const* data_;
+        size_t size_;
+        bool mapped_;
+
+        int fd_;
+        bool eof_;
+        size_t block_size_;
+        block ring_[block_count];
+        int current_;
+
+        // The next piece of a streamed file, or an empty view at the end.
+        string_ref next_block();
+
+        void grow(block& b, size_t capacity);
+
+        template <class R>
+        friend class block_range;
+    };
+
+    // Cuts s into at most n pieces that end right after a newline.
+    std::vector<string_ref> newline_chunks(string_ref s, int n);
+
+    template <class R>
+    void block_range<R>::skip()
+    {
+        while (r_.empty() && source_ != nullptr) {
+            string_ref b = source_->next_block();
+
+            if (b.size() == 0) {
+                source_ = nullptr;
+            } else {
+                r_ = R(b);
+            }
+        }
+    }
+
+    template <class func>
+    void line_reader::for_each_chunk(int threads, func f)
+    {
+        std::mutex error_mutex;
+        std::exception_ptr error;
+
+        auto run = [&](string_ref b, std::function<void()> const& between) {
+            std::vector<std::thread> workers;
+
+            for (auto& c: newline_chunks(b, threads)) {
+                workers.emplace_back([&, c]() {
+                    try {
+                        f(c);
+                    } catch (...) {
+                        std::lock_guard<std::mutex> lock { error_mutex };
+                        if (!error) {
+                            error = std::current_exception();
+                        }
+                    }
+                });
+            }
+
+            try {
+                between();
+            } catch (...) {
+                for (auto& t: workers) {
+                    t.join();
+                }
+                throw;
+            }
+
+            for (auto& t: workers) {
+                t.join();
+            }
+
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        };
+
+        if (mapped_) {
+            run(contents(), []() {});
+            return;
+        }
+
+        string_ref b = next_block();
+
+        while (b.size() > 0) {
+            string_ref next;
+            run(b, [&]() { next = next_block(); });
+            b = next;
+        }
+    }
+
+}
+
+#endif
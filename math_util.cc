@@ -1,6 +1,20 @@
 #include "math_util.h"
+#include "ebt/dense.h"
+#include "ebt/simd.h"
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#if EBT_SSE2
+#include <emmintrin.h>
+#endif
+
+#if EBT_AVX2_DISPATCH
+#include <immintrin.h>
+#endif
 
 namespace ebt {
 
@@ -24,4 +38,626 @@ namespace ebt {
         }
     }
 
+    namespace {
+
+        double const inf = std::numeric_limits<double>::infinity();
+
+        double const log2e = 1.4426950408889634;
+
+        // ln(2) split so that k * ln2_hi is exact for the k that occur.
+        double const ln2_hi = 6.93145751953125e-1;
+        double const ln2_lo = 1.42860682030941723212e-6;
+
+        double const exp_lo = -708.0;
+        double const exp_hi = 709.78;
+
+        // Adding 1.5 * 2^52 rounds to an integer and leaves it in the low
+        // bits of the representation.
+        double const round_magic = 6755399441055744.0;
+
+        double const sqrt2 = 1.4142135623730951;
+
+        uint64_t const mantissa_mask = 0x000fffffffffffffULL;
+        uint64_t const one_bits = 0x3ff0000000000000ULL;
+        uint64_t const two52_bits = 0x4330000000000000ULL;
+
+        // 1 / k! for k = 0, ..., 13.
+        double const e0 = 1.0;
+        double const e1 = 1.0;
+        double const e2 = 1.0 / 2;
+        double const e3 = 1.0 / 6;
+        double const e4 = 1.0 / 24;
+        double const e5 = 1.0 / 120;
+        double const e6 = 1.0 / 720;
+        double const e7 = 1.0 / 5040;
+        double const e8 = 1.0 / 40320;
+        double const e9 = 1.0 / 362880;
+        double const e10 = 1.0 / 3628800;
+        double const e11 = 1.0 / 39916800;
+        double const e12 = 1.0 / 479001600;
+        double const e13 = 1.0 / 6227020800;
+
+        // 2 / (2k + 1) for k = 0, ..., 8.
+        double const l0 = 2.0;
+        double const l1 = 2.0 / 3;
+        double const l2 = 2.0 / 5;
+        double const l3 = 2.0 / 7;
+        double const l4 = 2.0 / 9;
+        double const l5 = 2.0 / 11;
+        double const l6 = 2.0 / 13;
+        double const l7 = 2.0 / 15;
+        double const l8 = 2.0 / 17;
+
+        uint64_t to_bits(double x)
+        {
+            uint64_t b;
+            std::memcpy(&b, &x, sizeof(b));
+            return b;
+        }
+
+        double from_bits(uint64_t b)
+        {
+            double x;
+            std::memcpy(&x, &b, sizeof(x));
+            return x;
+        }
+
+        // log of a positive normal double.
+        double log_normal(double x)
+        {
+            uint64_t bits = to_bits(x);
+            double e = double(int(bits >> 52) - 1023);
+            double m = from_bits((bits & mantissa_mask) | one_bits);
+
+            if (m > sqrt2) {
+                m *= 0.5;
+                e += 1;
+            }
+
+            double f = (m - 1) / (m + 1);
+            double z = f * f;
+            double s = f * (l0 + z * (l1 + z * (l2 + z * (l3 + z * (l4
+                + z * (l5 + z * (l6 + z * (l7 + z * l8))))))));
+
+            return e * ln2_hi + (s + e * ln2_lo);
+        }
+
+        // The larger of a and b, or NaN if either is.
+        double max_nan(double a, double b)
+        {
+            return (a != a || a > b) ? a : b;
+        }
+
+        double log_add_fast(double a, double b)
+        {
+            if (a != a || b != b) {
+                return a + b;
+            }
+
+            double m = std::max(a, b);
+            double d = std::min(a, b) - m;
+
+            if (m == inf || d == -inf || d != d) {
+                return m;
+            }
+
+            return m + log_normal(1 + fast_exp(d));
+        }
+
+#if EBT_SSE2
+        __m128d exp_sse2(__m128d x)
+        {
+            __m128d over = _mm_cmpgt_pd(x, _mm_set1_pd(exp_hi));
+            __m128d under = _mm_cmplt_pd(x, _mm_set1_pd(exp_lo));
+            // max and min return their second operand when either is
+            // NaN, so a NaN goes through the clamp and the polynomial.
+            x = _mm_min_pd(_mm_set1_pd(exp_hi), _mm_max_pd(_mm_set1_pd(exp_lo), x));
+
+            __m128d magic = _mm_set1_pd(round_magic);
+            __m128d t = _mm_add_pd(_mm_mul_pd(x, _mm_set1_pd(log2e)), magic);
+            __m128d k = _mm_sub_pd(t, magic);
+            __m128d r = _mm_sub_pd(_mm_sub_pd(x, _mm_mul_pd(k, _mm_set1_pd(ln2_hi))),
+                _mm_mul_pd(k, _mm_set1_pd(ln2_lo)));
+
+            __m128d p = _mm_set1_pd(e13);
+            p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(e12));
+            p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(e11));
+            p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(e10));
+            p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(e9));
+            p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(e8));
+            p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(e7));
+            p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(e6));
+            p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(e5));
+            p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(e4));
+            p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(e3));
+            p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(e2));
+            p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(e1));
+            p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(e0));
+
+            // 2^(k - 1), so that k = 1024 stays representable.
+            __m128d s = _mm_castsi128_pd(_mm_slli_epi64(_mm_add_epi64(
+                _mm_castpd_si128(t), _mm_set1_epi64x(1022)), 52));
+            __m128d result = _mm_mul_pd(_mm_mul_pd(p, s), _mm_set1_pd(2.0));
+
+            result = _mm_andnot_pd(under, result);
+            return _mm_or_pd(_mm_and_pd(over, _mm_set1_pd(inf)), _mm_andnot_pd(over, result));
+        }
+
+        // log of positive normal doubles.
+        __m128d log_sse2(__m128d x)
+        {
+            __m128i bits = _mm_castpd_si128(x);
+            __m128d two52 = _mm_castsi128_pd(_mm_set1_epi64x(two52_bits));
+
+            __m128d e = _mm_sub_pd(_mm_or_pd(_mm_castsi128_pd(_mm_srli_epi64(bits, 52)), two52),
+                _mm_add_pd(two52, _mm_set1_pd(1023)));
+            __m128d m = _mm_castsi128_pd(_mm_or_si128(
+                _mm_and_si128(bits, _mm_set1_epi64x(mantissa_mask)), _mm_set1_epi64x(one_bits)));
+
+            __m128d big = _mm_cmpgt_pd(m, _mm_set1_pd(sqrt2));
+            m = _mm_or_pd(_mm_and_pd(big, _mm_mul_pd(m, _mm_set1_pd(0.5))), _mm_andnot_pd(big, m));
+            e = _mm_add_pd(e, _mm_and_pd(big, _mm_set1_pd(1.0)));
+
+            __m128d one = _mm_set1_pd(1.0);
+            __m128d f = _mm_div_pd(_mm_sub_pd(m, one), _mm_add_pd(m, one));
+            __m128d z = _mm_mul_pd(f, f);
+
+            __m128d p = _mm_set1_pd(l8);
+            p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(l7));
+            p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(l6));
+            p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(l5));
+            p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(l4));
+            p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(l3));
+            p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(l2));
+            p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(l1));
+            p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(l0));
+            __m128d s = _mm_mul_pd(f, p);
+
+            return _mm_add_pd(_mm_mul_pd(e, _mm_set1_pd(ln2_hi)),
+                _mm_add_pd(s, _mm_mul_pd(e, _mm_set1_pd(ln2_lo))));
+        }
+
+        // Each kernel handles a prefix of the input and returns its length.
+
+        size_t max_sse2(double const* x, size_t n, double& result)
+        {
+            if (n < 4) {
+                return 0;
+            }
+
+            __m128d m0 = _mm_loadu_pd(x);
+            __m128d m1 = _mm_loadu_pd(x + 2);
+
+            // max_pd drops a NaN in its first operand, so NaNs are
+            // tracked on the side.
+            __m128d nan = _mm_cmpunord_pd(m0, m1);
+
+            size_t i = 4;
+            for (; i + 4 <= n; i += 4) {
+                __m128d a = _mm_loadu_pd(x + i);
+                __m128d b = _mm_loadu_pd(x + i + 2);
+                nan = _mm_or_pd(nan, _mm_cmpunord_pd(a, b));
+                m0 = _mm_max_pd(m0, a);
+                m1 = _mm_max_pd(m1, b);
+            }
+
+            double t[2];
+            _mm_storeu_pd(t, _mm_max_pd(m0, m1));
+            result = max_nan(result, std::max(t[0], t[1]));
+
+            if (_mm_movemask_pd(nan) != 0) {
+                result = std::numeric_limits<double>::quiet_NaN();
+            }
+
+            return i;
+        }
+
+        size_t sum_exp_sse2(double const* x, size_t n, double shift,
+            double* out, double& sum)
+        {
+            __m128d c = _mm_set1_pd(shift);
+            __m128d s0 = _mm_setzero_pd();
+            __m128d s1 = _mm_setzero_pd();
+
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                __m128d a = exp_sse2(_mm_sub_pd(_mm_loadu_pd(x + i), c));
+                __m128d b = exp_sse2(_mm_sub_pd(_mm_loadu_pd(x + i + 2), c));
+
+                if (out != nullptr) {
+                    _mm_storeu_pd(out + i, a);
+                    _mm_storeu_pd(out + i + 2, b);
+                }
+
+                s0 = _mm_add_pd(s0, a);
+                s1 = _mm_add_pd(s1, b);
+            }
+
+            double t[2];
+            _mm_storeu_pd(t, _mm_add_pd(s0, s1));
+            sum += t[0] + t[1];
+
+            return i;
+        }
+
+        size_t exp_sse2(double const* x, double* out, size_t n)
+        {
+            size_t i = 0;
+            for (; i + 2 <= n; i += 2) {
+                _mm_storeu_pd(out + i, exp_sse2(_mm_loadu_pd(x + i)));
+            }
+
+            return i;
+        }
+
+        size_t log_add_sse2(double const* x, double const* y, double* out, size_t n)
+        {
+            size_t i = 0;
+            for (; i + 2 <= n; i += 2) {
+                __m128d a = _mm_loadu_pd(x + i);
+                __m128d b = _mm_loadu_pd(y + i);
+                __m128d m = _mm_max_pd(a, b);
+                __m128d d = _mm_sub_pd(_mm_min_pd(a, b), m);
+
+                __m128d r = _mm_add_pd(m, log_sse2(_mm_add_pd(_mm_set1_pd(1.0), exp_sse2(d))));
+
+                // Where an input is infinite or d is not a number, the
+                // result is the maximum.  max_pd may drop a NaN input, so
+                // where there is one the result is a + b instead.
+                __m128d keep = _mm_or_pd(_mm_cmpeq_pd(m, _mm_set1_pd(inf)),
+                    _mm_or_pd(_mm_cmpeq_pd(d, _mm_set1_pd(-inf)), _mm_cmpunord_pd(d, d)));
+                r = _mm_or_pd(_mm_and_pd(keep, m), _mm_andnot_pd(keep, r));
+
+                __m128d nan = _mm_cmpunord_pd(a, b);
+                _mm_storeu_pd(out + i, _mm_or_pd(_mm_and_pd(nan, _mm_add_pd(a, b)),
+                    _mm_andnot_pd(nan, r)));
+            }
+
+            return i;
+        }
+#endif
+
+#if EBT_AVX2_DISPATCH
+        EBT_TARGET_AVX2_FMA
+        __m256d exp_avx2(__m256d x)
+        {
+            __m256d over = _mm256_cmp_pd(x, _mm256_set1_pd(exp_hi), _CMP_GT_OQ);
+            __m256d under = _mm256_cmp_pd(x, _mm256_set1_pd(exp_lo), _CMP_LT_OQ);
+            x = _mm256_min_pd(_mm256_set1_pd(exp_hi), _mm256_max_pd(_mm256_set1_pd(exp_lo), x));
+
+            __m256d magic = _mm256_set1_pd(round_magic);
+            __m256d t = _mm256_fmadd_pd(x, _mm256_set1_pd(log2e), magic);
+            __m256d k = _mm256_sub_pd(t, magic);
+            __m256d r = _mm256_fnmadd_pd(k, _mm256_set1_pd(ln2_lo),
+                _mm256_fnmadd_pd(k, _mm256_set1_pd(ln2_hi), x));
+
+            __m256d p = _mm256_set1_pd(e13);
+            p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(e12));
+            p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(e11));
+            p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(e10));
+            p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(e9));
+            p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(e8));
+            p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(e7));
+            p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(e6));
+            p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(e5));
+            p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(e4));
+            p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(e3));
+            p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(e2));
+            p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(e1));
+            p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(e0));
+
+            __m256d s = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_add_epi64(
+                _mm256_castpd_si256(t), _mm256_set1_epi64x(1022)), 52));
+            __m256d result = _mm256_mul_pd(_mm256_mul_pd(p, s), _mm256_set1_pd(2.0));
+
+            result = _mm256_andnot_pd(under, result);
+            return _mm256_blendv_pd(result, _mm256_set1_pd(inf), over);
+        }
+
+        EBT_TARGET_AVX2_FMA
+        __m256d log_avx2(__m256d x)
+        {
+            __m256i bits = _mm256_castpd_si256(x);
+            __m256d two52 = _mm256_castsi256_pd(_mm256_set1_epi64x(two52_bits));
+
+            __m256d e = _mm256_sub_pd(
+                _mm256_or_pd(_mm256_castsi256_pd(_mm256_srli_epi64(bits, 52)), two52),
+                _mm256_add_pd(two52, _mm256_set1_pd(1023)));
+            __m256d m = _mm256_castsi256_pd(_mm256_or_si256(
+                _mm256_and_si256(bits, _mm256_set1_epi64x(mantissa_mask)),
+                _mm256_set1_epi64x(one_bits)));
+
+            __m256d big = _mm256_cmp_pd(m, _mm256_set1_pd(sqrt2), _CMP_GT_OQ);
+            m = _mm256_blendv_pd(m, _mm256_mul_pd(m, _mm256_set1_pd(0.5)), big);
+            e = _mm256_add_pd(e, _mm256_and_pd(big, _mm256_set1_pd(1.0)));
+
+            __m256d one = _mm256_set1_pd(1.0);
+            __m256d f = _mm256_div_pd(_mm256_sub_pd(m, one), _mm256_add_pd(m, one));
+            __m256d z = _mm256_mul_pd(f, f);
+
+            __m256d p = _mm256_set1_pd(l8);
+            p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(l7));
+            p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(l6));
+            p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(l5));
+            p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(l4));
+            p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(l3));
+            p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(l2));
+            p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(l1));
+            p = _mm256_fmadd_pd(p, z, _mm256_set1_pd(l0));
+            __m256d s = _mm256_mul_pd(f, p);
+
+            return _mm256_fmadd_pd(e, _mm256_set1_pd(ln2_hi),
+                _mm256_fmadd_pd(e, _mm256_set1_pd(ln2_lo), s));
+        }
+
+        EBT_TARGET_AVX2_FMA
+        size_t max_avx2(double const* x, size_t n, double& result)
+        {
+            if (n < 8) {
+                return 0;
+            }
+
+            __m256d m0 = _mm256_loadu_pd(x);
+            __m256d m1 = _mm256_loadu_pd(x + 4);
+            __m256d nan = _mm256_cmp_pd(m0, m1, _CMP_UNORD_Q);
+
+            size_t i = 8;
+            for (; i + 8 <= n; i += 8) {
+                __m256d a = _mm256_loadu_pd(x + i);
+                __m256d b = _mm256_loadu_pd(x + i + 4);
+                nan = _mm256_or_pd(nan, _mm256_cmp_pd(a, b, _CMP_UNORD_Q));
+                m0 = _mm256_max_pd(m0, a);
+                m1 = _mm256_max_pd(m1, b);
+            }
+
+            double t[4];
+            _mm256_storeu_pd(t, _mm256_max_pd(m0, m1));
+            result = max_nan(result, std::max(std::max(t[0], t[1]), std::max(t[2], t[3])));
+
+            if (_mm256_movemask_pd(nan) != 0) {
+                result = std::numeric_limits<double>::quiet_NaN();
+            }
+
+            return i;
+        }
+
+        EBT_TARGET_AVX2_FMA
+        size_t sum_exp_avx2(double const* x, size_t n, double shift,
+            double* out, double& sum)
+        {
+            __m256d c = _mm256_set1_pd(shift);
+            __m256d s0 = _mm256_setzero_pd();
+            __m256d s1 = _mm256_setzero_pd();
+
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                __m256d a = exp_avx2(_mm256_sub_pd(_mm256_loadu_pd(x + i), c));
+                __m256d b = exp_avx2(_mm256_sub_pd(_mm256_loadu_pd(x + i + 4), c));
+
+                if (out != nullptr) {
+                    _mm256_storeu_pd(out + i, a);
+                    _mm256_storeu_pd(out + i + 4, b);
+                }
+
+                s0 = _mm256_add_pd(s0, a);
+                s1 = _mm256_add_pd(s1, b);
+            }
+
+            double t[4];
+            _mm256_storeu_pd(t, _mm256_add_pd(s0, s1));
+            sum += (t[0] + t[1]) + (t[2] + t[3]);
+
+            return i;
+        }
+
+        EBT_TARGET_AVX2_FMA
+        size_t exp_avx2(double const* x, double* out, size_t n)
+        {
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                _mm256_storeu_pd(out + i, exp_avx2(_mm256_loadu_pd(x + i)));
+            }
+
+            return i;
+        }
+
+        EBT_TARGET_AVX2_FMA
+        size_t log_add_avx2(double const* x, double const* y, double* out, size_t n)
+        {
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                __m256d a = _mm256_loadu_pd(x + i);
+                __m256d b = _mm256_loadu_pd(y + i);
+                __m256d m = _mm256_max_pd(a, b);
+                __m256d d = _mm256_sub_pd(_mm256_min_pd(a, b), m);
+
+                __m256d r = _mm256_add_pd(m,
+                    log_avx2(_mm256_add_pd(_mm256_set1_pd(1.0), exp_avx2(d))));
+
+                __m256d keep = _mm256_or_pd(_mm256_cmp_pd(m, _mm256_set1_pd(inf), _CMP_EQ_OQ),
+                    _mm256_cmp_pd(d, _mm256_set1_pd(-inf), _CMP_EQ_UQ));
+                r = _mm256_blendv_pd(r, m, keep);
+
+                __m256d nan = _mm256_cmp_pd(a, b, _CMP_UNORD_Q);
+                _mm256_storeu_pd(out + i, _mm256_blendv_pd(r, _mm256_add_pd(a, b), nan));
+            }
+
+            return i;
+        }
+#endif
+
+        double max_impl(double const* x, size_t n)
+        {
+            double result = -inf;
+            size_t i = 0;
+
+#if EBT_AVX2_DISPATCH
+            if (cpu_has_fma()) {
+                i = max_avx2(x, n, result);
+            }
+#endif
+
+#if EBT_SSE2
+            i += max_sse2(x + i, n - i, result);
+#endif
+
+            for (; i < n; ++i) {
+                result = max_nan(result, x[i]);
+            }
+
+            return result;
+        }
+
+        // sum(exp(x - shift)), also stored in out unless it is null.
+        double sum_exp_impl(double const* x, size_t n, double shift, double* out)
+        {
+            double sum = 0;
+            size_t i = 0;
+
+#if EBT_AVX2_DISPATCH
+            if (cpu_has_fma()) {
+                i = sum_exp_avx2(x, n, shift, out, sum);
+            }
+#endif
+
+#if EBT_SSE2
+            i += sum_exp_sse2(x + i, n - i, shift, out == nullptr ? nullptr : out + i, sum);
+#endif
+
+            for (; i < n; ++i) {
+                double v = fast_exp(x[i] - shift);
+
+                if (out != nullptr) {
+                    out[i] = v;
+                }
+
+                sum += v;
+            }
+
+            return sum;
+        }
+
+    }
+
+    double fast_exp(double x)
+    {
+        if (x != x) {
+            return x;
+        } else if (x > exp_hi) {
+            return inf;
+        } else if (x < exp_lo) {
+            return 0;
+        }
+
+        double t = x * log2e + round_magic;
+        double k = t - round_magic;
+        double r = (x - k * ln2_hi) - k * ln2_lo;
+
+        double p = e0 + r * (e1 + r * (e2 + r * (e3 + r * (e4 + r * (e5 + r * (e6
+            + r * (e7 + r * (e8 + r * (e9 + r * (e10 + r * (e11 + r * (e12
+            + r * e13))))))))))));
+
+        return p * from_bits((to_bits(t) + 1022) << 52) * 2;
+    }
+
+    double fast_log(double x)
+    {
+        if (x != x || x < 0) {
+            return std::numeric_limits<double>::quiet_NaN();
+        } else if (x == 0) {
+            return -inf;
+        } else if (x == inf) {
+            return inf;
+        } else if (x < std::numeric_limits<double>::min()) {
+            // Scale subnormals up by 2^54.
+            return log_normal(x * 18014398509481984.0) - 54 * ln2_hi - 54 * ln2_lo;
+        }
+
+        return log_normal(x);
+    }
+
+    void fast_exp(span<double const> x, span<double> out)
+    {
+        if (x.size() != out.size()) {
+            throw std::invalid_argument("fast_exp: sizes differ");
+        }
+
+        size_t n = x.size();
+        size_t i = 0;
+
+#if EBT_AVX2_DISPATCH
+        if (cpu_has_fma()) {
+            i = exp_avx2(x.data(), out.data(), n);
+        }
+#endif
+
+#if EBT_SSE2
+        i += exp_sse2(x.data() + i, out.data() + i, n - i);
+#endif
+
+        for (; i < n; ++i) {
+            out[i] = fast_exp(x[i]);
+        }
+    }
+
+    double log_sum_exp(span<double const> x)
+    {
+        double m = max_impl(x.data(), x.size());
+
+        if (m == -inf || m == inf) {
+            return m;
+        }
+
+        return m + std::log(sum_exp_impl(x.data(), x.size(), m, nullptr));
+    }
+
+    void log_add(span<double const> x, span<double const> y, span<double> out)
+    {
+        if (x.size() != y.size() || x.size() != out.size()) {
+            throw std::invalid_argument("log_add: sizes differ");
+        }
+
+        size_t n = x.size();
+        size_t i = 0;
+
+#if EBT_AVX2_DISPATCH
+        if (cpu_has_fma()) {
+            i = log_add_avx2(x.data(), y.data(), out.data(), n);
+        }
+#endif
+
+#if EBT_SSE2
+        i += log_add_sse2(x.data() + i, y.data() + i, out.data() + i, n - i);
+#endif
+
+        for (; i < n; ++i) {
+            out[i] = log_add_fast(x[i], y[i]);
+        }
+    }
+
+    void softmax(span<double const> x, span<double> out)
+    {
+        if (x.size() != out.size()) {
+            throw std::invalid_argument("softmax: sizes differ");
+        }
+
+        double m = max_impl(x.data(), x.size());
+        double sum = sum_exp_impl(x.data(), x.size(), m, out.data());
+
+        dense::scale(1 / sum, out.data(), out.size());
+    }
+
+    void log_softmax(span<double const> x, span<double> out)
+    {
+        if (x.size() != out.size()) {
+            throw std::invalid_argument("log_softmax: sizes differ");
+        }
+
+        double z = log_sum_exp(x);
+
+        for (size_t i = 0; i < x.size(); ++i) {
+            out[i] = x[i] - z;
+        }
+    }
+
 }
@@ -1,11 +1,43 @@
 #ifndef EBT_MATH_UTIL_H
 #define EBT_MATH_UTIL_H
 
+#include "ebt/span.h"
+
 namespace ebt {
 
     double log_add(double a, double b);
     double sign(double x);
 
+    // exp by range reduction to |r| <= ln(2)/2 and a degree-13 polynomial.
+    // The relative error is below 5e-16 where the result is a normal
+    // double; results below 2^-1021 (x < -708) are flushed to zero.
+    double fast_exp(double x);
+
+    // log by reduction of the mantissa to [sqrt(1/2), sqrt(2)] and a
+    // series in (m - 1) / (m + 1) up to degree 17.  The relative error is
+    // below 2e-15.
+    double fast_log(double x);
+
+    // The kernels below use vectorized fast_exp and fast_log.  A NaN in
+    // the input gives a NaN in the result, whatever the length.
+
+    // out[i] = fast_exp(x[i]).  out may be x.
+    void fast_exp(span<double const> x, span<double> out);
+
+    // log(sum(exp(x))), with the maximum subtracted first; -inf if x is
+    // empty or all -inf.
+    double log_sum_exp(span<double const> x);
+
+    // out[i] = log_add(x[i], y[i]).  out may be x or y.
+    void log_add(span<double const> x, span<double const> y, span<double> out);
+
+    // out = exp(x) / sum(exp(x)), for x with a finite maximum.  out may
+    // be x.
+    void softmax(span<double const> x, span<double> out);
+
+    // out = x - log_sum_exp(x).  out may be x.
+    void log_softmax(span<double const> x, span<double> out);
+
 }
 
 #endif
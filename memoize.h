@@ -0,0 +1,277 @@
+#ifndef EBT_MEMOIZE_H
+#define EBT_MEMOIZE_H
+
+#include "ebt/functional.h"
+#include "ebt/hashmap.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace ebt {
+
+    // At most capacity key-value pairs, evicted in CLOCK order: the hand
+    // sweeps the slots, clears the referenced bit of entries that were
+    // looked up since it last passed, and evicts the first entry that was
+    // not.  New entries start unreferenced, so entries that are never
+    // looked up again go first.
+    template <class K, class V>
+    class clock_cache {
+    public:
+        explicit clock_cache(size_t capacity)
+            : capacity_(capacity), hand_(0)
+        {
+            if (capacity == 0) {
+                throw std::invalid_argument("cache capacity must be positive");
+            }
+        }
+
+        V const* find(K const& key)
+        {
+            size_t const* i = index_.find(key);
+
+            if (i == nullptr) {
+                return nullptr;
+            }
+
+            slots_[*i].referenced = true;
+
+            return &slots_[*i].value;
+        }
+
+        // key must not be in the cache.
+        V const& insert(K const& key, V value)
+        {
+            size_t i;
+
+            if (slots_.size() < capacity_) {
+                i = slots_.size();
+                slots_.push_back(slot { key, std::move(value), false });
+            } else {
+                while (slots_[hand_].referenced) {
+                    slots_[hand_].referenced = false;
+                    hand_ = (hand_ + 1) % capacity_;
+                }
+
+                i = hand_;
+                hand_ = (hand_ + 1) % capacity_;
+
+                index_.erase(slots_[i].key);
+                slots_[i] = slot { key, std::move(value), false };
+            }
+
+            index_[key] = i;
+
+            return slots_[i].value;
+        }
+
+        size_t size() const
+        {
+            return slots_.size();
+        }
+
+        size_t capacity() const
+        {
+            return capacity_;
+        }
+
+    private:
+        struct slot {
+            K key;
+            V value;
+            bool referenced;
+        };
+
+        size_t capacity_;
+        size_t hand_;
+        std::vector<slot> slots_;
+        hashmap<K, size_t> index_;
+    };
+
+    // The argument and result types of a unary functor or function.
+    template <class F>
+    struct unary_traits
+        : unary_traits<decltype(&F::operator())> {};
+
+    template <class R, class A>
+    struct unary_traits<R (*)(A)> {
+        using argument_type = typename std::decay<A>::type;
+        using result_type = typename std::decay<R>::type;
+    };
+
+    template <class R, class A>
+    struct unary_traits<R (A)>
+        : unary_traits<R (*)(A)> {};
+
+    template <class C, class R, class A>
+    struct unary_traits<R (C::*)(A)>
+        : unary_traits<R (*)(A)> {};
+
+    template <class C, class R, class A>
+    struct unary_traits<R (C::*)(A) const>
+        : unary_traits<R (*)(A)> {};
+
+    // f with the results for the most recently used arguments kept in a
+    // clock_cache.  Copies share the cache, which must not be used from
+    // more than one thread; see sharded_memoized for that.
+    template <class func>
+    class memoized {
+    public:
+        using argument_type = typename unary_traits<func>::argument_type;
+        using result_type = typename unary_traits<func>::result_type;
+
+        memoized(func f, size_t capacity)
+            : state_(std::make_shared<state>(std::move(f), capacity))
+        {}
+
+        result_type operator()(argument_type const& x) const
+        {
+            if (result_type const* v = state_->cache.find(x)) {
+                ++state_->hits;
+                return *v;
+            }
+
+            ++state_->misses;
+
+            return state_->cache.insert(x, state_->f(x));
+        }
+
+        uint64_t hits() const
+        {
+            return state_->hits;
+        }
+
+        uint64_t misses() const
+        {
+            return state_->misses;
+        }
+
+        size_t size() const
+        {
+            return state_->cache.size();
+        }
+
+    private:
+        struct state {
+            func f;
+            clock_cache<argument_type, result_type> cache;
+            uint64_t hits;
+            uint64_t misses;
+
+            state(func f, size_t capacity)
+                : f(std::move(f)), cache(capacity), hits(0), misses(0)
+            {}
+        };
+
+        std::shared_ptr<state> state_;
+    };
+
+    template <class func>
+    memoized<func> memoize(func f, size_t capacity)
+    {
+        return memoized<func>(std::move(f), capacity);
+    }
+
+    // A memoized f that may be called concurrently.  The cache is split
+    // into shards by the hash of the argument, each with its own lock and
+    // an equal share of the capacity.  f runs outside the lock, so two
+    // threads missing on the same argument may both compute it.
+    template <class func>
+    class sharded_memoized {
+    public:
+        using argument_type = typename unary_traits<func>::argument_type;
+        using result_type = typename unary_traits<func>::result_type;
+
+        sharded_memoized(func f, size_t capacity, int shards = 16)
+            : state_(std::make_shared<state>(std::move(f), capacity, shards))
+        {}
+
+        result_type operator()(argument_type const& x) const
+        {
+            shard& s = *state_->shards[state_->hash(x) % state_->shards.size()];
+
+            {
+                std::lock_guard<std::mutex> lock { s.mutex };
+
+                if (result_type const* v = s.cache.find(x)) {
+                    ++state_->hits;
+                    return *v;
+                }
+            }
+
+            ++state_->misses;
+
+            result_type v = state_->f(x);
+
+            std::lock_guard<std::mutex> lock { s.mutex };
+
+            if (s.cache.find(x) == nullptr) {
+                s.cache.insert(x, v);
+            }
+
+            return v;
+        }
+
+        uint64_t hits() const
+        {
+            return state_->hits;
+        }
+
+        uint64_t misses() const
+        {
+            return state_->misses;
+        }
+
+    private:
+        struct shard {
+            std::mutex mutex;
+            clock_cache<argument_type, result_type> cache;
+
+            explicit shard(size_t capacity)
+                : cache(capacity)
+            {}
+        };
+
+        struct state {
+            func f;
+            std::hash<argument_type> hash;
+            std::vector<std::unique_ptr<shard>> shards;
+            std::atomic<uint64_t> hits;
+            std::atomic<uint64_t> misses;
+
+            state(func f, size_t capacity, int n)
+                : f(std::move(f)), hits(0), misses(0)
+            {
+                n = std::max(n, 1);
+                for (int i = 0; i < n; ++i) {
+                    shards.emplace_back(new shard(std::max<size_t>(1, capacity / n)));
+                }
+            }
+        };
+
+        std::shared_ptr<state> state_;
+    };
+
+    template <class func>
+    sharded_memoized<func> sharded_memoize(func f, size_t capacity, int shards = 16)
+    {
+        return sharded_memoized<func>(std::move(f), capacity, shards);
+    }
+
+    // A map over r whose results are memoized across elements, for f
+    // that is expensive and sees the same inputs repeatedly.  Copies
+    // share the cache, which is sharded so that the elements may be
+    // indexed concurrently, as parallel_map does.
+    template <class range, class func>
+    auto cached_map(range const& r, func f, size_t capacity, int shards = 16)
+        -> decltype(map(r, sharded_memoize(std::move(f), capacity, shards)))
+    {
+        return map(r, sharded_memoize(std::move(f), capacity, shards));
+    }
+
+}
+
+#endif
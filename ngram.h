@@ -1,6 +1,10 @@
 #ifndef EBT_NGRAM_H
 #define EBT_NGRAM_H
 
+#include "ebt/range.h"
+#include "ebt/span.h"
+#include <cstdint>
+#include <functional>
 #include <list>
 
 namespace ebt {
@@ -88,6 +92,177 @@ namespace ebt {
         return NGramIterable<Iterable>(std::forward<Iterable>(iterable), n);
     }
 
+    // The n-grams of a contiguous sequence as spans into it, without
+    // copying.  A sequence shorter than n has no n-grams.
+    template <class T>
+    class ngram_range {
+    public:
+        using value_type = span<T const>;
+
+        ngram_range(span<T const> seq, size_t n)
+            : window_(seq.data(), n)
+            , left_(n != 0 && n <= seq.size() ? seq.size() - n + 1 : 0)
+        {}
+
+        void pop_front()
+        {
+            --left_;
+            if (left_ != 0) {
+                window_ = value_type(window_.data() + 1, window_.size());
+            }
+        }
+
+        value_type const& front() const
+        {
+            return window_;
+        }
+
+        bool empty() const
+        {
+            return left_ == 0;
+        }
+
+        range_iterator<ngram_range> begin()
+        {
+            return range_iterator<ngram_range>(*this);
+        }
+
+        range_iterator<ngram_range> end()
+        {
+            return range_iterator<ngram_range>();
+        }
+
+    private:
+        value_type window_;
+        size_t left_;
+    };
+
+    // An n-gram together with a 64-bit polynomial hash of its elements,
+    // so that it can be used as a hash table key without rehashing.
+    template <class T>
+    struct hashed_ngram {
+        span<T const> tokens;
+        uint64_t hash;
+    };
+
+    template <class T>
+    bool operator==(hashed_ngram<T> const& a, hashed_ngram<T> const& b)
+    {
+        return a.hash == b.hash && a.tokens == b.tokens;
+    }
+
+    template <class T>
+    bool operator!=(hashed_ngram<T> const& a, hashed_ngram<T> const& b)
+    {
+        return !(a == b);
+    }
+
+    namespace ngram_detail {
+
+        uint64_t const base = 0x100000001b3ull;
+
+        template <class T>
+        uint64_t code(T const& t)
+        {
+            uint64_t c = std::hash<T>()(t) * 0x9e3779b97f4a7c15ull;
+            return c ^ (c >> 29);
+        }
+
+    }
+
+    // Like ngram_range, but keeps the hash of the window up to date in
+    // constant time per step by rolling it, so that the hash of
+    // t_0 ... t_{n-1} is sum_i code(t_i) * base^(n - 1 - i) mod 2^64.
+    template <class T>
+    class hashed_ngram_range {
+    public:
+        using value_type = hashed_ngram<T>;
+
+        hashed_ngram_range(span<T const> seq, size_t n)
+            : r_(seq, n), top_(1)
+        {
+            for (size_t i = 1; i < n; ++i) {
+                top_ *= ngram_detail::base;
+            }
+
+            value_.hash = 0;
+            if (!r_.empty()) {
+                for (auto& t: r_.front()) {
+                    value_.hash = value_.hash * ngram_detail::base
+                        + ngram_detail::code(t);
+                }
+            }
+            value_.tokens = r_.front();
+        }
+
+        void pop_front()
+        {
+            T const* old = r_.front().data();
+            r_.pop_front();
+
+            if (!r_.empty()) {
+                value_.hash = (value_.hash - ngram_detail::code(*old) * top_)
+                    * ngram_detail::base + ngram_detail::code(r_.front().back());
+            }
+            value_.tokens = r_.front();
+        }
+
+        value_type const& front() const
+        {
+            return value_;
+        }
+
+        bool empty() const
+        {
+            return r_.empty();
+        }
+
+        range_iterator<hashed_ngram_range> begin()
+        {
+            return range_iterator<hashed_ngram_range>(*this);
+        }
+
+        range_iterator<hashed_ngram_range> end()
+        {
+            return range_iterator<hashed_ngram_range>();
+        }
+
+    private:
+        ngram_range<T> r_;
+        uint64_t top_;
+        value_type value_;
+    };
+
+    template <class seq>
+    ngram_range<typename seq::value_type> ngram_view(seq const& s, size_t n)
+    {
+        using T = typename seq::value_type;
+        return ngram_range<T>(span<T const>(s.data(), s.size()), n);
+    }
+
+    template <class seq>
+    hashed_ngram_range<typename seq::value_type>
+    hashed_ngram_view(seq const& s, size_t n)
+    {
+        using T = typename seq::value_type;
+        return hashed_ngram_range<T>(span<T const>(s.data(), s.size()), n);
+    }
+
+}
+
+namespace std {
+
+    template <class T>
+    struct hash<ebt::hashed_ngram<T>> {
+        using argument_type = ebt::hashed_ngram<T>;
+        using result_type = size_t;
+
+        size_t operator()(ebt::hashed_ngram<T> const& g) const noexcept
+        {
+            return g.hash;
+        }
+    };
+
 }
 
 #endif
@@ -0,0 +1,336 @@
+#include "ebt/ngram_counter.h"
+#include "ebt/string.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace ebt {
+
+    bool operator==(ngram_key const& a, ngram_key const& b)
+    {
+        return std::memcmp(a.ids, b.ids, sizeof(a.ids)) == 0;
+    }
+
+    bool operator<(ngram_key const& a, ngram_key const& b)
+    {
+        return std::lexicographical_compare(a.ids, a.ids + ngram_key::max_order,
+            b.ids, b.ids + ngram_key::max_order);
+    }
+
+    namespace {
+
+        // Flush a thread's own table into the shards past this many entries.
+        size_t const local_limit = 1 << 16;
+
+        struct record {
+            ngram_key key;
+            uint64_t count;
+        };
+
+        bool record_less(record const& a, record const& b)
+        {
+            return a.key < b.key;
+        }
+
+        std::runtime_error spill_error(std::string const& what, std::string const& path)
+        {
+            return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+        }
+
+        // A sorted run of records, read either from memory or from a file
+        // in blocks.
+        class run_cursor {
+        public:
+            explicit run_cursor(std::vector<record>&& records)
+                : file_(nullptr), buf_(std::move(records)), pos_(0)
+            {}
+
+            explicit run_cursor(std::string const& path)
+                : path_(path), pos_(0)
+            {
+                file_ = std::fopen(path.c_str(), "rb");
+
+                if (file_ == nullptr) {
+                    throw spill_error("unable to open", path);
+                }
+
+                fill();
+            }
+
+            ~run_cursor()
+            {
+                if (file_ != nullptr) {
+                    std::fclose(file_);
+                }
+            }
+
+            bool empty() const
+            {
+                return pos_ == buf_.size();
+            }
+
+            record const& front() const
+            {
+                return buf_[pos_];
+            }
+
+            void pop_front()
+            {
+                ++pos_;
+
+                if (pos_ == buf_.size() && file_ != nullptr) {
+                    fill();
+                }
+            }
+
+        private:
+            std::FILE* file_;
+            std::string path_;
+            std::vector<record> buf_;
+            size_t pos_;
+
+            void fill()
+            {
+                buf_.resize(4096);
+                size_t n = std::fread(buf_.data(), sizeof(record), buf_.size(), file_);
+
+                if (n < buf_.size() && std::ferror(file_)) {
+                    throw spill_error("unable to read", path_);
+                }
+
+                buf_.resize(n);
+                pos_ = 0;
+            }
+        };
+
+        struct cursor_greater {
+            bool operator()(run_cursor const* a, run_cursor const* b) const
+            {
+                return b->front().key < a->front().key;
+            }
+        };
+
+        std::vector<record> sorted_records(hashmap<ngram_key, uint64_t> const& counts)
+        {
+            std::vector<record> result;
+            result.reserve(counts.size());
+
+            for (auto& p: counts) {
+                result.push_back(record { p.first, p.second });
+            }
+
+            std::sort(result.begin(), result.end(), record_less);
+
+            return result;
+        }
+
+    }
+
+    ngram_counter::ngram_counter(options const& opt)
+        : opt_(opt)
+    {
+        if (opt_.order < 1 || opt_.order > ngram_key::max_order) {
+            throw std::invalid_argument("n-gram order out of range");
+        }
+    }
+
+    ngram_counter::~ngram_counter()
+    {
+        for (auto& s: shards_) {
+            for (auto& path: s.runs) {
+                std::remove(path.c_str());
+            }
+        }
+    }
+
+    void ngram_counter::count(table& local, span<uint32_t const> ids)
+    {
+        ngram_key key;
+
+        for (size_t i = 0; i < ids.size(); ++i) {
+            std::fill(key.ids, key.ids + ngram_key::max_order, symbol_table::npos);
+
+            for (size_t k = 0; k < size_t(opt_.order) && i + k < ids.size(); ++k) {
+                key.ids[k] = ids[i + k];
+                local[key] += 1;
+            }
+        }
+    }
+
+    void ngram_counter::merge(table& local)
+    {
+        std::vector<std::vector<std::pair<ngram_key, uint64_t>>> parts(shard_count);
+        std::hash<ngram_key> hash;
+
+        for (auto& p: local) {
+            parts[hash(p.first) >> 58].push_back(p);
+        }
+
+        local = table();
+
+        for (int i = 0; i < shard_count; ++i) {
+            if (parts[i].empty()) {
+                continue;
+            }
+
+            shard& s = shards_[i];
+            std::lock_guard<std::mutex> lock { s.mutex };
+
+            for (auto& p: parts[i]) {
+                s.counts[p.first] += p.second;
+            }
+
+            // A budget smaller than the shard count still allows each
+            // shard one entry, rather than spilling on every merge.
+            if (opt_.max_entries != 0 && size_t(s.counts.size())
+                    > std::max<size_t>(opt_.max_entries / shard_count, 1)) {
+                spill(s);
+            }
+        }
+    }
+
+    void ngram_counter::spill(shard& s)
+    {
+        std::vector<record> records = sorted_records(s.counts);
+
+        std::string path = opt_.spill_dir + "/ngram_counter.XXXXXX";
+        int fd = mkstemp(&path[0]);
+
+        if (fd == -1) {
+            throw spill_error("unable to create", path);
+        }
+
+        std::FILE* f = fdopen(fd, "wb");
+
+        if (f == nullptr) {
+            close(fd);
+            std::remove(path.c_str());
+            throw spill_error("unable to open", path);
+        }
+
+        size_t n = std::fwrite(records.data(), sizeof(record), records.size(), f);
+
+        if (std::fclose(f) != 0 || n != records.size()) {
+            std::remove(path.c_str());
+            throw spill_error("unable to write", path);
+        }
+
+        s.runs.push_back(path);
+        s.counts = table();
+    }
+
+    void ngram_counter::add(string_ref line)
+    {
+        std::vector<uint32_t> ids;
+
+        for (auto& t: split_range(line)) {
+            ids.push_back(symbols_.intern(t));
+        }
+
+        add(span<uint32_t const>(ids.data(), ids.size()));
+    }
+
+    void ngram_counter::add(span<uint32_t const> ids)
+    {
+        table local;
+        count(local, ids);
+        merge(local);
+    }
+
+    void ngram_counter::add(line_reader& reader, int threads)
+    {
+        reader.for_each_chunk(threads, [&](string_ref c) {
+            table local;
+            std::vector<uint32_t> ids;
+
+            for (line_range r(c); !r.empty(); r.pop_front()) {
+                ids.clear();
+
+                for (auto& t: split_range(r.front())) {
+                    ids.push_back(symbols_.intern(t));
+                }
+
+                count(local, span<uint32_t const>(ids.data(), ids.size()));
+
+                if (size_t(local.size()) > local_limit) {
+                    merge(local);
+                }
+            }
+
+            merge(local);
+        });
+    }
+
+    void ngram_counter::for_each(
+        std::function<void(span<uint32_t const>, uint64_t)> f) const
+    {
+        for (auto& s: shards_) {
+            // The shard is copied out so that f runs without its lock.
+            std::vector<record> counts;
+            std::vector<std::string> runs;
+
+            {
+                std::lock_guard<std::mutex> lock { s.mutex };
+                counts = sorted_records(s.counts);
+                runs = s.runs;
+            }
+
+            std::vector<std::unique_ptr<run_cursor>> cursors;
+            cursors.emplace_back(new run_cursor(std::move(counts)));
+            for (auto& path: runs) {
+                cursors.emplace_back(new run_cursor(path));
+            }
+
+            std::priority_queue<run_cursor*, std::vector<run_cursor*>,
+                cursor_greater> heap;
+            for (auto& c: cursors) {
+                if (!c->empty()) {
+                    heap.push(c.get());
+                }
+            }
+
+            while (!heap.empty()) {
+                record r = heap.top()->front();
+                r.count = 0;
+
+                while (!heap.empty() && heap.top()->front().key == r.key) {
+                    run_cursor* c = heap.top();
+                    heap.pop();
+                    r.count += c->front().count;
+                    c->pop_front();
+
+                    if (!c->empty()) {
+                        heap.push(c);
+                    }
+                }
+
+                if (r.count >= opt_.min_count) {
+                    f(span<uint32_t const>(r.key.ids, r.key.order()), r.count);
+                }
+            }
+        }
+    }
+
+    symbol_table const& ngram_counter::symbols() const
+    {
+        return symbols_;
+    }
+
+    size_t ngram_counter::runs() const
+    {
+        size_t result = 0;
+
+        for (auto& s: shards_) {
+            std::lock_guard<std::mutex> lock { s.mutex };
+            result += s.runs.size();
+        }
+
+        return result;
+    }
+
+}
@@ -0,0 +1,123 @@
+#ifndef EBT_NGRAM_COUNTER_H
+#define EBT_NGRAM_COUNTER_H
+
+#include "ebt/hashmap.h"
+#include "ebt/hash.h"
+#include "ebt/line_reader.h"
+#include "ebt/span.h"
+#include "ebt/string_ref.h"
+#include "ebt/symbol_table.h"
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ebt {
+
+    // An n-gram of symbol ids, padded with symbol_table::npos.
+    struct ngram_key {
+        static constexpr int max_order = 8;
+
+        uint32_t ids[max_order];
+
+        int order() const
+        {
+            int n = 0;
+            while (n < max_order && ids[n] != symbol_table::npos) {
+                ++n;
+            }
+            return n;
+        }
+    };
+
+    bool operator==(ngram_key const& a, ngram_key const& b);
+    bool operator<(ngram_key const& a, ngram_key const& b);
+
+}
+
+namespace std {
+
+    template <>
+    struct hash<ebt::ngram_key> {
+        using argument_type = ebt::ngram_key;
+        using result_type = size_t;
+
+        size_t operator()(ebt::ngram_key const& k) const noexcept
+        {
+            return ebt::hash_bytes(k.ids, sizeof(k.ids));
+        }
+    };
+
+}
+
+namespace ebt {
+
+    // Counts all n-grams of order 1 to order over whitespace-separated
+    // tokens.  Tokens are interned into symbols(), and counts are kept in
+    // hashmaps sharded by the hash of the n-gram.  Each counting thread
+    // first collects counts in a table of its own and merges it into the
+    // shards when it grows past a limit.
+    //
+    // If max_entries is non-zero and a shard holds more than its share
+    // of it, the shard is sorted and spilled as a run to a file in
+    // spill_dir.  The share is at least one entry, even when it would
+    // round to zero.  for_each merges the runs back.
+    class ngram_counter {
+    public:
+        struct options {
+            int order = 3;
+            uint64_t min_count = 1;
+            size_t max_entries = 0;
+            std::string spill_dir = "/tmp";
+        };
+
+        explicit ngram_counter(options const& opt);
+        ~ngram_counter();
+
+        ngram_counter(ngram_counter const&) = delete;
+        ngram_counter& operator=(ngram_counter const&) = delete;
+
+        // Counts the n-grams of one line.  May be called concurrently.
+        void add(string_ref line);
+
+        void add(span<uint32_t const> ids);
+
+        // Counts every line of the reader on the given number of threads.
+        void add(line_reader& reader, int threads);
+
+        // Calls f(ids, count) once for every n-gram counted at least
+        // min_count times.  N-grams are visited shard by shard, in
+        // sorted order within a shard.  Each shard is copied before f is
+        // called on it, so f may call add; the counts it adds are not
+        // seen by shards already copied.
+        void for_each(std::function<void(span<uint32_t const>, uint64_t)> f) const;
+
+        symbol_table const& symbols() const;
+
+        // The number of runs spilled to disk so far.
+        size_t runs() const;
+
+    private:
+        static constexpr int shard_count = 64;
+
+        using table = hashmap<ngram_key, uint64_t>;
+
+        struct shard {
+            mutable std::mutex mutex;
+            table counts;
+            std::vector<std::string> runs;
+        };
+
+        options opt_;
+        symbol_table symbols_;
+        shard shards_[shard_count];
+
+        void count(table& local, span<uint32_t const> ids);
+        void merge(table& local);
+        void spill(shard& s);
+    };
+
+}
+
+#endif
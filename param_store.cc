@@ -0,0 +1,450 @@
+#include "ebt/param_store.h"
+#include "ebt/dense.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ebt {
+
+    namespace {
+
+        size_t const alignment = 64;
+
+        // Where the buffer starts in a saved file.
+        size_t const file_alignment = 4096;
+
+        char const magic[8] = { 'e', 'b', 't', 'p', 'a', 'r', 'a', 'm' };
+
+        size_t round_up(size_t n, size_t m)
+        {
+            return (n + m - 1) / m * m;
+        }
+
+        std::runtime_error file_error(std::string const& what, std::string const& path)
+        {
+            return std::runtime_error("param_store: " + what + " " + path + ": "
+                + std::strerror(errno));
+        }
+
+        struct file_closer {
+            void operator()(std::FILE* f) const
+            {
+                std::fclose(f);
+            }
+        };
+
+        using file_ptr = std::unique_ptr<std::FILE, file_closer>;
+
+        template <class U>
+        void write_value(std::FILE* f, U const& v)
+        {
+            std::fwrite(&v, sizeof(U), 1, f);
+        }
+
+        template <class U>
+        bool read_value(std::FILE* f, U& v)
+        {
+            return std::fread(&v, sizeof(U), 1, f) == 1;
+        }
+
+    }
+
+    template <class T>
+    param_store<T>::param_store()
+        : data_(nullptr), size_(0), capacity_(0), map_(nullptr), map_size_(0)
+    {}
+
+    template <class T>
+    param_store<T>::param_store(std::unordered_map<std::string, std::vector<T>> const& map)
+        : param_store()
+    {
+        std::vector<std::string> names;
+        size_t total = 0;
+
+        for (auto& p: map) {
+            names.push_back(p.first);
+            total += round_up(p.second.size(), alignment / sizeof(T));
+        }
+
+        std::sort(names.begin(), names.end());
+        reserve(total);
+
+        for (auto& name: names) {
+            auto& v = map.at(name);
+            span<T> s = add(name, v.size());
+            std::copy(v.begin(), v.end(), s.begin());
+        }
+    }
+
+    template <class T>
+    param_store<T>::param_store(param_store const& that)
+        : param_store()
+    {
+        reserve(that.size_);
+        if (that.size_ > 0) {
+            std::memcpy(data_, that.data_, that.size_ * sizeof(T));
+        }
+        size_ = that.size_;
+        blocks_ = that.blocks_;
+        index_ = that.index_;
+    }
+
+    template <class T>
+    param_store<T>::param_store(param_store&& that)
+        : param_store()
+    {
+        swap(that);
+    }
+
+    template <class T>
+    param_store<T>& param_store<T>::operator=(param_store that)
+    {
+        swap(that);
+        return *this;
+    }
+
+    template <class T>
+    param_store<T>::~param_store()
+    {
+        release();
+    }
+
+    template <class T>
+    void param_store<T>::swap(param_store& that)
+    {
+        std::swap(data_, that.data_);
+        std::swap(size_, that.size_);
+        std::swap(capacity_, that.capacity_);
+        std::swap(map_, that.map_);
+        std::swap(map_size_, that.map_size_);
+        blocks_.swap(that.blocks_);
+        index_.swap(that.index_);
+    }
+
+    template <class T>
+    void param_store<T>::release()
+    {
+        if (map_ != nullptr) {
+            ::munmap(map_, map_size_);
+        } else {
+            std::free(data_);
+        }
+
+        data_ = nullptr;
+        capacity_ = 0;
+        map_ = nullptr;
+        map_size_ = 0;
+    }
+
+    template <class T>
+    void param_store<T>::reserve(size_t capacity)
+    {
+        if (capacity <= capacity_) {
+            return;
+        }
+
+        void* p = nullptr;
+
+        if (::posix_memalign(&p, alignment, std::max<size_t>(capacity, 1) * sizeof(T)) != 0) {
+            throw std::bad_alloc();
+        }
+
+        T* data = static_cast<T*>(p);
+
+        if (size_ > 0) {
+            std::memcpy(data, data_, size_ * sizeof(T));
+        }
+        std::memset(data + size_, 0, (capacity - size_) * sizeof(T));
+
+        size_t size = size_;
+        release();
+
+        data_ = data;
+        size_ = size;
+        capacity_ = capacity;
+    }
+
+    template <class T>
+    span<T> param_store<T>::add(std::string const& name, size_t size)
+    {
+        if (index_.count(name)) {
+            throw std::invalid_argument("param_store: duplicate block " + name);
+        }
+
+        size_t padded = round_up(size, alignment / sizeof(T));
+
+        if (size_ + padded > capacity_) {
+            reserve(std::max(size_ + padded, 2 * capacity_));
+        }
+
+        index_[name] = blocks_.size();
+        blocks_.push_back(block { name, size_, size });
+        size_ += padded;
+
+        return span<T>(data_ + blocks_.back().offset, size);
+    }
+
+    template <class T>
+    span<T> param_store<T>::operator[](std::string const& name)
+    {
+        block const& b = blocks_[index_.at(name)];
+        return span<T>(data_ + b.offset, b.size);
+    }
+
+    template <class T>
+    span<T const> param_store<T>::operator[](std::string const& name) const
+    {
+        block const& b = blocks_[index_.at(name)];
+        return span<T const>(data_ + b.offset, b.size);
+    }
+
+    template <class T>
+    bool param_store<T>::has(std::string const& name) const
+    {
+        return index_.count(name) != 0;
+    }
+
+    template <class T>
+    std::vector<typename param_store<T>::block> const& param_store<T>::blocks() const
+    {
+        return blocks_;
+    }
+
+    template <class T>
+    size_t param_store<T>::size() const
+    {
+        return size_;
+    }
+
+    template <class T>
+    T* param_store<T>::data()
+    {
+        return data_;
+    }
+
+    template <class T>
+    T const* param_store<T>::data() const
+    {
+        return data_;
+    }
+
+    template <class T>
+    bool param_store<T>::same_layout(param_store const& that) const
+    {
+        if (size_ != that.size_ || blocks_.size() != that.blocks_.size()) {
+            return false;
+        }
+
+        for (size_t i = 0; i < blocks_.size(); ++i) {
+            block const& a = blocks_[i];
+            block const& b = that.blocks_[i];
+
+            if (a.offset != b.offset || a.size != b.size || a.name != b.name) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    template <class T>
+    std::unordered_map<std::string, std::vector<T>> param_store<T>::to_map() const
+    {
+        std::unordered_map<std::string, std::vector<T>> result;
+
+        for (auto& b: blocks_) {
+            result[b.name] = std::vector<T>(data_ + b.offset, data_ + b.offset + b.size);
+        }
+
+        return result;
+    }
+
+    // The file holds the magic bytes, the element size, the block count,
+    // the buffer length, the offset of the buffer in the file, and then
+    // each block as its name length, name, offset and size.  Integers are
+    // in the byte order of the machine that wrote them.
+    template <class T>
+    void param_store<T>::save(std::string const& path) const
+    {
+        file_ptr f { std::fopen(path.c_str(), "wb") };
+
+        if (f == nullptr) {
+            throw file_error("unable to create", path);
+        }
+
+        size_t header = sizeof(magic) + 2 * sizeof(uint32_t) + 2 * sizeof(uint64_t);
+        for (auto& b: blocks_) {
+            header += sizeof(uint32_t) + b.name.size() + 2 * sizeof(uint64_t);
+        }
+        uint64_t data_offset = round_up(header, file_alignment);
+
+        std::fwrite(magic, sizeof(magic), 1, f.get());
+        write_value(f.get(), uint32_t(sizeof(T)));
+        write_value(f.get(), uint32_t(blocks_.size()));
+        write_value(f.get(), uint64_t(size_));
+        write_value(f.get(), data_offset);
+
+        for (auto& b: blocks_) {
+            write_value(f.get(), uint32_t(b.name.size()));
+            std::fwrite(b.name.data(), 1, b.name.size(), f.get());
+            write_value(f.get(), uint64_t(b.offset));
+            write_value(f.get(), uint64_t(b.size));
+        }
+
+        std::vector<char> zeros(data_offset - header);
+        std::fwrite(zeros.data(), 1, zeros.size(), f.get());
+
+        if (std::fwrite(data_, sizeof(T), size_, f.get()) != size_
+                || std::fflush(f.get()) != 0) {
+            throw file_error("unable to write", path);
+        }
+    }
+
+    template <class T>
+    param_store<T> param_store<T>::load(std::string const& path)
+    {
+        file_ptr f { std::fopen(path.c_str(), "rb") };
+
+        if (f == nullptr) {
+            throw file_error("unable to open", path);
+        }
+
+        char m[sizeof(magic)];
+        uint32_t elem_size;
+        uint32_t nblocks;
+        uint64_t size;
+        uint64_t data_offset;
+
+        if (std::fread(m, sizeof(m), 1, f.get()) != 1
+                || std::memcmp(m, magic, sizeof(magic)) != 0
+                || !read_value(f.get(), elem_size) || !read_value(f.get(), nblocks)
+                || !read_value(f.get(), size) || !read_value(f.get(), data_offset)) {
+            throw std::runtime_error("param_store: not a parameter file " + path);
+        }
+
+        if (elem_size != sizeof(T)) {
+            throw std::runtime_error("param_store: element size mismatch in " + path);
+        }
+
+        param_store result;
+
+        for (uint32_t i = 0; i < nblocks; ++i) {
+            uint32_t len;
+            uint64_t offset;
+            uint64_t bsize;
+
+            if (!read_value(f.get(), len)) {
+                throw std::runtime_error("param_store: truncated index in " + path);
+            }
+
+            std::string name(len, '\0');
+
+            if (std::fread(&name[0], 1, len, f.get()) != len
+                    || !read_value(f.get(), offset) || !read_value(f.get(), bsize)
+                    || offset + bsize > size) {
+                throw std::runtime_error("param_store: truncated index in " + path);
+            }
+
+            result.index_[name] = result.blocks_.size();
+            result.blocks_.push_back(block { name, size_t(offset), size_t(bsize) });
+        }
+
+        size_t bytes = data_offset + size * sizeof(T);
+        long page = ::sysconf(_SC_PAGESIZE);
+
+        if (size > 0 && page > 0 && data_offset % page == 0) {
+            int fd = ::fileno(f.get());
+            struct stat st;
+
+            if (::fstat(fd, &st) == 0 && size_t(st.st_size) >= bytes) {
+                void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+                if (p != MAP_FAILED) {
+                    result.map_ = p;
+                    result.map_size_ = bytes;
+                    result.data_ = reinterpret_cast<T*>(static_cast<char*>(p) + data_offset);
+                    result.size_ = size;
+                    result.capacity_ = size;
+                    return result;
+                }
+            }
+        }
+
+        // Files that cannot be mapped are read into a fresh buffer.
+        result.reserve(size);
+
+        if (std::fseek(f.get(), data_offset, SEEK_SET) != 0
+                || std::fread(result.data_, sizeof(T), size, f.get()) != size) {
+            throw file_error("unable to read", path);
+        }
+
+        result.size_ = size;
+
+        return result;
+    }
+
+    template <class T>
+    void check_layout(param_store<T> const& a, param_store<T> const& b)
+    {
+        if (!a.same_layout(b)) {
+            throw std::invalid_argument("param_store: layouts differ");
+        }
+    }
+
+    template <class T>
+    double dot(param_store<T> const& a, param_store<T> const& b)
+    {
+        check_layout(a, b);
+        return dense::dot(a.data(), b.data(), a.size());
+    }
+
+    template <class T>
+    void axpy(T a, param_store<T> const& x, param_store<T>& y)
+    {
+        check_layout(x, y);
+        dense::axpy(a, x.data(), y.data(), x.size());
+    }
+
+    template <class T>
+    void scale(T a, param_store<T>& x)
+    {
+        dense::scale(a, x.data(), x.size());
+    }
+
+    template <class T>
+    double norm1(param_store<T> const& x)
+    {
+        return dense::norm1(x.data(), x.size());
+    }
+
+    template <class T>
+    double norm2(param_store<T> const& x)
+    {
+        return dense::norm2(x.data(), x.size());
+    }
+
+    template class param_store<float>;
+    template class param_store<double>;
+
+    template double dot(param_store<float> const& a, param_store<float> const& b);
+    template double dot(param_store<double> const& a, param_store<double> const& b);
+    template void axpy(float a, param_store<float> const& x, param_store<float>& y);
+    template void axpy(double a, param_store<double> const& x, param_store<double>& y);
+    template void scale(float a, param_store<float>& x);
+    template void scale(double a, param_store<double>& x);
+    template double norm1(param_store<float> const& x);
+    template double norm1(param_store<double> const& x);
+    template double norm2(param_store<float> const& x);
+    template double norm2(param_store<double> const& x);
+
+}
@@ -0,0 +1,111 @@
+#ifndef EBT_PARAM_STORE_H
+#define EBT_PARAM_STORE_H
+
+#include "ebt/span.h"
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ebt {
+
+    // Named blocks of parameters kept in one contiguous, 64-byte aligned
+    // buffer, so that operations over a whole model are single loops over
+    // the buffer.  Every block starts on a 64-byte boundary; the padding
+    // between blocks is zero and stays zero under the operations below.
+    //
+    // Defined for float and double.
+    template <class T>
+    class param_store {
+    public:
+        struct block {
+            std::string name;
+            size_t offset;
+            size_t size;
+        };
+
+        param_store();
+
+        // The blocks are laid out in order of name, so stores built from
+        // maps with the same keys and sizes have the same layout.
+        explicit param_store(std::unordered_map<std::string, std::vector<T>> const& map);
+
+        param_store(param_store const& that);
+        param_store(param_store&& that);
+        param_store& operator=(param_store that);
+        ~param_store();
+
+        // Appends a zeroed block.  This may move the buffer, which
+        // invalidates every span and pointer into the store.
+        span<T> add(std::string const& name, size_t size);
+
+        // Throws std::out_of_range if there is no block of that name.
+        span<T> operator[](std::string const& name);
+        span<T const> operator[](std::string const& name) const;
+
+        bool has(std::string const& name) const;
+
+        std::vector<block> const& blocks() const;
+
+        // The length of the buffer, padding included.
+        size_t size() const;
+
+        T* data();
+        T const* data() const;
+
+        bool same_layout(param_store const& that) const;
+
+        std::unordered_map<std::string, std::vector<T>> to_map() const;
+
+        // Writes the index and then the buffer, which starts at a page
+        // boundary of the file so that load can map it.
+        void save(std::string const& path) const;
+
+        // Maps the buffer of a saved store copy-on-write, so pages are read
+        // on first use and writes stay private to the process.
+        static param_store load(std::string const& path);
+
+        friend void swap(param_store& a, param_store& b)
+        {
+            a.swap(b);
+        }
+
+    private:
+        T* data_;
+        size_t size_;
+        size_t capacity_;
+
+        // Non-null when data_ points into a mapping of this length.
+        void* map_;
+        size_t map_size_;
+
+        std::vector<block> blocks_;
+        std::unordered_map<std::string, size_t> index_;
+
+        void reserve(size_t capacity);
+        void release();
+        void swap(param_store& that);
+    };
+
+    // The operations on two stores require the same layout, and throw
+    // std::invalid_argument otherwise.
+
+    template <class T>
+    double dot(param_store<T> const& a, param_store<T> const& b);
+
+    // y += a * x
+    template <class T>
+    void axpy(T a, param_store<T> const& x, param_store<T>& y);
+
+    template <class T>
+    void scale(T a, param_store<T>& x);
+
+    template <class T>
+    double norm1(param_store<T> const& x);
+
+    template <class T>
+    double norm2(param_store<T> const& x);
+
+}
+
+#endif
@@ -0,0 +1,86 @@
+#include "ebt/pipeline.h"
+#include <iomanip>
+#include <stdexcept>
+#include <thread>
+
+namespace ebt {
+
+    void pipeline_state::guard(std::function<void()> const& f)
+    {
+        try {
+            f();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock { error_mutex };
+            if (!error) {
+                error = std::current_exception();
+            }
+            abort = true;
+        }
+    }
+
+    void pipeline_backoff(int& round)
+    {
+        if (round < 64) {
+            // Spin.
+        } else if (round < 128) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+
+        ++round;
+    }
+
+    pipeline::pipeline(std::shared_ptr<pipeline_state> state)
+        : state_(state)
+    {}
+
+    void pipeline::run()
+    {
+        if (state_->workers.empty()) {
+            throw std::logic_error("pipeline has already run");
+        }
+
+        std::vector<std::thread> threads;
+
+        for (auto& w: state_->workers) {
+            threads.emplace_back(std::move(w));
+        }
+
+        state_->workers.clear();
+
+        for (auto& t: threads) {
+            t.join();
+        }
+
+        if (state_->error) {
+            std::rethrow_exception(state_->error);
+        }
+    }
+
+    size_t pipeline::stages() const
+    {
+        return state_->stats.size();
+    }
+
+    stage_stats const& pipeline::stats(size_t i) const
+    {
+        return state_->stats.at(i);
+    }
+
+    void pipeline::report(std::ostream& os) const
+    {
+        for (auto& s: state_->stats) {
+            double busy = s.busy_ns * 1e-9;
+
+            os << s.name << ": threads " << s.threads
+                << " items " << s.items
+                << " items/s " << (busy > 0 ? s.items / busy * s.threads : 0)
+                << " queue " << std::fixed << std::setprecision(2) << s.mean_occupancy()
+                << std::defaultfloat
+                << " empty-waits " << s.empty_waits
+                << " full-waits " << s.full_waits << std::endl;
+        }
+    }
+
+}
@@ -0,0 +1,338 @@
+#ifndef EBT_PIPELINE_H
+#define EBT_PIPELINE_H
+
+#include "ebt/queue.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace ebt {
+
+    struct pipeline_options {
+        // Items handed from one stage to the next at a time.
+        size_t batch_size = 256;
+
+        // Batches that may wait between two stages before the upstream
+        // stage blocks.
+        size_t queue_capacity = 64;
+    };
+
+    struct stage_stats {
+        std::string name;
+        int threads;
+
+        std::atomic<uint64_t> items;
+        std::atomic<uint64_t> batches;
+
+        // Time spent in the stage's own function, summed over threads.
+        std::atomic<uint64_t> busy_ns;
+
+        // The size of the input queue, in batches, summed over every
+        // batch taken from it.
+        std::atomic<uint64_t> occupancy_sum;
+
+        // How often the stage waited on an empty input or a full output.
+        std::atomic<uint64_t> empty_waits;
+        std::atomic<uint64_t> full_waits;
+
+        stage_stats(std::string name, int threads)
+            : name(name), threads(threads), items(0), batches(0), busy_ns(0),
+              occupancy_sum(0), empty_waits(0), full_waits(0)
+        {}
+
+        double mean_occupancy() const
+        {
+            return batches == 0 ? 0 : double(occupancy_sum) / batches;
+        }
+    };
+
+    struct pipeline_state {
+        pipeline_options options;
+        std::vector<std::function<void()>> workers;
+        std::deque<stage_stats> stats;
+
+        std::atomic<bool> abort;
+        std::mutex error_mutex;
+        std::exception_ptr error;
+
+        explicit pipeline_state(pipeline_options const& opt)
+            : options(opt), abort(false)
+        {}
+
+        // Runs f, and on an exception records it and stops the pipeline.
+        void guard(std::function<void()> const& f);
+    };
+
+    // Waits with a short spin, then yields, then sleeps.
+    void pipeline_backoff(int& round);
+
+    // The queue between two stages.  It uses an spsc_queue when one
+    // thread writes and one reads, and an mpmc_queue otherwise.  Reading
+    // ends once every writer has called close and the queue is empty.
+    template <class T>
+    class channel {
+    public:
+        channel(pipeline_state& state, int producers)
+            : state_(state), producers_(producers)
+        {}
+
+        void open(int consumers)
+        {
+            size_t capacity = state_.options.queue_capacity;
+
+            if (producers_ == 1 && consumers == 1) {
+                spsc_.reset(new spsc_queue<T>(capacity));
+            } else {
+                mpmc_.reset(new mpmc_queue<T>(capacity));
+            }
+        }
+
+        bool push(T& v, stage_stats& s)
+        {
+            for (int round = 0; !state_.abort; ) {
+                if (spsc_ ? spsc_->try_push(v) : mpmc_->try_push(v)) {
+                    return true;
+                }
+
+                if (round == 0) {
+                    ++s.full_waits;
+                }
+
+                pipeline_backoff(round);
+            }
+
+            return false;
+        }
+
+        bool pop(T& v, stage_stats& s)
+        {
+            for (int round = 0; !state_.abort; ) {
+                if (spsc_ ? spsc_->try_pop(v) : mpmc_->try_pop(v)) {
+                    s.occupancy_sum += size_approx() + 1;
+                    return true;
+                }
+
+                if (producers_ == 0) {
+                    // Writers may have pushed between the failed pop and
+                    // the check.
+                    return spsc_ ? spsc_->try_pop(v) : mpmc_->try_pop(v);
+                }
+
+                if (round == 0) {
+                    ++s.empty_waits;
+                }
+
+                pipeline_backoff(round);
+            }
+
+            return false;
+        }
+
+        void close()
+        {
+            --producers_;
+        }
+
+        size_t size_approx() const
+        {
+            return spsc_ ? spsc_->size_approx() : mpmc_->size_approx();
+        }
+
+    private:
+        pipeline_state& state_;
+        std::atomic<int> producers_;
+        std::unique_ptr<spsc_queue<T>> spsc_;
+        std::unique_ptr<mpmc_queue<T>> mpmc_;
+    };
+
+    // A built pipeline.  run starts every stage on its own threads and
+    // returns when the source is exhausted and every item has reached the
+    // sink, rethrowing the first exception a stage threw.
+    class pipeline {
+    public:
+        explicit pipeline(std::shared_ptr<pipeline_state> state);
+
+        void run();
+
+        size_t stages() const;
+
+        stage_stats const& stats(size_t i) const;
+
+        // One line per stage with its throughput, mean input queue
+        // occupancy and wait counts.
+        void report(std::ostream& os) const;
+
+    private:
+        std::shared_ptr<pipeline_state> state_;
+    };
+
+    // A pipeline under construction whose last stage produces T.
+    template <class T>
+    class pipeline_builder {
+    public:
+        pipeline_builder(std::shared_ptr<pipeline_state> state,
+                std::shared_ptr<channel<std::vector<T>>> out)
+            : state_(state), out_(out)
+        {}
+
+        // Adds a stage that maps every item with f on the given number of
+        // threads.  f must be safe to call concurrently if threads > 1.
+        template <class func>
+        pipeline_builder<typename std::decay<
+            typename std::result_of<func(T&)>::type>::type>
+        then(std::string name, int threads, func f)
+        {
+            using U = typename std::decay<typename std::result_of<func(T&)>::type>::type;
+
+            auto state = state_;
+            auto in = out_;
+            auto out = std::make_shared<channel<std::vector<U>>>(*state, threads);
+            in->open(threads);
+
+            state->stats.emplace_back(name, threads);
+            stage_stats* s = &state->stats.back();
+
+            // The workers are owned by the state, so they must not hold a
+            // shared_ptr to it.
+            pipeline_state* st = state.get();
+
+            for (int t = 0; t < threads; ++t) {
+                state->workers.push_back([=]() mutable {
+                    st->guard([&]() {
+                        std::vector<T> batch;
+                        std::vector<U> result;
+
+                        while (in->pop(batch, *s)) {
+                            auto start = std::chrono::steady_clock::now();
+
+                            result.clear();
+                            result.reserve(batch.size());
+                            for (auto& x: batch) {
+                                result.push_back(f(x));
+                            }
+
+                            s->busy_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                std::chrono::steady_clock::now() - start).count();
+                            s->items += batch.size();
+                            ++s->batches;
+
+                            if (!out->push(result, *s)) {
+                                break;
+                            }
+                        }
+                    });
+
+                    out->close();
+                });
+            }
+
+            return pipeline_builder<U>(state, out);
+        }
+
+        // Ends the pipeline with a stage that consumes every item.
+        template <class func>
+        pipeline sink(std::string name, int threads, func f)
+        {
+            auto state = state_;
+            auto in = out_;
+            in->open(threads);
+
+            state->stats.emplace_back(name, threads);
+            stage_stats* s = &state->stats.back();
+
+            // The workers are owned by the state, so they must not hold a
+            // shared_ptr to it.
+            pipeline_state* st = state.get();
+
+            for (int t = 0; t < threads; ++t) {
+                state->workers.push_back([=]() mutable {
+                    st->guard([&]() {
+                        std::vector<T> batch;
+
+                        while (in->pop(batch, *s)) {
+                            auto start = std::chrono::steady_clock::now();
+
+                            for (auto& x: batch) {
+                                f(x);
+                            }
+
+                            s->busy_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                std::chrono::steady_clock::now() - start).count();
+                            s->items += batch.size();
+                            ++s->batches;
+                        }
+                    });
+                });
+            }
+
+            return pipeline(state);
+        }
+
+    private:
+        std::shared_ptr<pipeline_state> state_;
+        std::shared_ptr<channel<std::vector<T>>> out_;
+    };
+
+    // Starts a pipeline with a source that runs on one thread and fills
+    // its argument with the next item, returning false when there are no
+    // more.
+    template <class T, class func>
+    pipeline_builder<T> pipeline_source(std::string name, func f,
+        pipeline_options const& opt = pipeline_options())
+    {
+        auto state = std::make_shared<pipeline_state>(opt);
+        auto out = std::make_shared<channel<std::vector<T>>>(*state, 1);
+
+        state->stats.emplace_back(name, 1);
+        stage_stats* s = &state->stats.back();
+        pipeline_state* st = state.get();
+
+        state->workers.push_back([=]() mutable {
+            st->guard([&]() {
+                std::vector<T> batch;
+                T item;
+
+                while (true) {
+                    auto start = std::chrono::steady_clock::now();
+
+                    batch.clear();
+                    while (batch.size() < st->options.batch_size && f(item)) {
+                        batch.push_back(std::move(item));
+                    }
+
+                    s->busy_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - start).count();
+
+                    if (batch.empty()) {
+                        break;
+                    }
+
+                    s->items += batch.size();
+                    ++s->batches;
+
+                    bool last = batch.size() < st->options.batch_size;
+
+                    if (!out->push(batch, *s) || last) {
+                        break;
+                    }
+                }
+            });
+
+            out->close();
+        });
+
+        return pipeline_builder<T>(state, out);
+    }
+
+}
+
+#endif
@@ -0,0 +1,196 @@
+#ifndef EBT_QUEUE_H
+#define EBT_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace ebt {
+
+    inline size_t round_up_pow2(size_t n)
+    {
+        size_t result = 1;
+        while (result < n) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    // A bounded ring buffer for exactly one producer thread and one
+    // consumer thread.  The capacity is rounded up to a power of two.
+    template <class T>
+    class spsc_queue {
+    public:
+        explicit spsc_queue(size_t capacity)
+            : buf_(round_up_pow2(capacity)), mask_(buf_.size() - 1),
+              head_(0), tail_(0), head_cache_(0), tail_cache_(0)
+        {}
+
+        bool try_push(T& v)
+        {
+            size_t tail = tail_.load(std::memory_order_relaxed);
+
+            if (tail - head_cache_ == buf_.size()) {
+                head_cache_ = head_.load(std::memory_order_acquire);
+
+                if (tail - head_cache_ == buf_.size()) {
+                    return false;
+                }
+            }
+
+            buf_[tail & mask_] = std::move(v);
+            tail_.store(tail + 1, std::memory_order_release);
+
+            return true;
+        }
+
+        bool try_pop(T& v)
+        {
+            size_t head = head_.load(std::memory_order_relaxed);
+
+            if (head == tail_cache_) {
+                tail_cache_ = tail_.load(std::memory_order_acquire);
+
+                if (head == tail_cache_) {
+                    return false;
+                }
+            }
+
+            v = std::move(buf_[head & mask_]);
+            head_.store(head + 1, std::memory_order_release);
+
+            return true;
+        }
+
+        size_t size_approx() const
+        {
+            return tail_.load(std::memory_order_relaxed)
+                - head_.load(std::memory_order_relaxed);
+        }
+
+        size_t capacity() const
+        {
+            return buf_.size();
+        }
+
+    private:
+        std::vector<T> buf_;
+        size_t mask_;
+
+        // The two ends live on separate cache lines, each next to the
+        // other end's index as last seen by its own thread.
+        char pad0_[64];
+        std::atomic<size_t> head_;
+        char pad1_[64];
+        std::atomic<size_t> tail_;
+        char pad2_[64];
+        size_t head_cache_;
+        char pad3_[64];
+        size_t tail_cache_;
+    };
+
+    // A bounded ring buffer for any number of producers and consumers,
+    // after Dmitry Vyukov's design: every cell carries a sequence number
+    // that says whether it is ready to be written or read in the current
+    // lap, so each operation is a single compare-and-swap on its index.
+    template <class T>
+    class mpmc_queue {
+    public:
+        explicit mpmc_queue(size_t capacity)
+            : cells_(new cell[round_up_pow2(capacity)]),
+              mask_(round_up_pow2(capacity) - 1),
+              head_(0), tail_(0)
+        {
+            for (size_t i = 0; i <= mask_; ++i) {
+                cells_[i].seq.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        bool try_push(T& v)
+        {
+            size_t pos = tail_.load(std::memory_order_relaxed);
+            cell* c;
+
+            while (true) {
+                c = &cells_[pos & mask_];
+                size_t seq = c->seq.load(std::memory_order_acquire);
+                long diff = long(seq) - long(pos);
+
+                if (diff == 0) {
+                    if (tail_.compare_exchange_weak(pos, pos + 1,
+                            std::memory_order_relaxed)) {
+                        break;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = tail_.load(std::memory_order_relaxed);
+                }
+            }
+
+            c->data = std::move(v);
+            c->seq.store(pos + 1, std::memory_order_release);
+
+            return true;
+        }
+
+        bool try_pop(T& v)
+        {
+            size_t pos = head_.load(std::memory_order_relaxed);
+            cell* c;
+
+            while (true) {
+                c = &cells_[pos & mask_];
+                size_t seq = c->seq.load(std::memory_order_acquire);
+                long diff = long(seq) - long(pos + 1);
+
+                if (diff == 0) {
+                    if (head_.compare_exchange_weak(pos, pos + 1,
+                            std::memory_order_relaxed)) {
+                        break;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = head_.load(std::memory_order_relaxed);
+                }
+            }
+
+            v = std::move(c->data);
+            c->seq.store(pos + mask_ + 1, std::memory_order_release);
+
+            return true;
+        }
+
+        size_t size_approx() const
+        {
+            size_t tail = tail_.load(std::memory_order_relaxed);
+            size_t head = head_.load(std::memory_order_relaxed);
+            return tail > head ? tail - head : 0;
+        }
+
+        size_t capacity() const
+        {
+            return mask_ + 1;
+        }
+
+    private:
+        struct cell {
+            std::atomic<size_t> seq;
+            T data;
+        };
+
+        std::unique_ptr<cell[]> cells_;
+        size_t mask_;
+
+        char pad0_[64];
+        std::atomic<size_t> head_;
+        char pad1_[64];
+        std::atomic<size_t> tail_;
+        char pad2_[64];
+    };
+
+}
+
+#endif
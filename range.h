@@ -1,7 +1,15 @@
 #ifndef EBT_RANGE_H
 #define EBT_RANGE_H
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
 #include <iterator>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace ebt {
 
@@ -19,10 +27,100 @@ namespace ebt {
         static bool const value = (sizeof(f<T>(nullptr)) == sizeof(long));
     };
 
+    // A range that knows how many elements are left.
+    template <class T>
+    struct is_sized_range {
+        template <class U>
+        static auto f(U const* u) -> decltype(size_t(u->size()), long());
+        template <class U> static char f(...);
+
+        static bool const value = is_range<T>::value
+            && (sizeof(f<T>(nullptr)) == sizeof(long));
+    };
+
+    // A sized range whose i-th element, counted from the front, can be
+    // reached in constant time with operator[].  operator[] returns either
+    // a reference into storage the range does not own, or a value_type
+    // built on the spot, so indexing never touches the range itself and
+    // one range can be indexed from several threads.
+    template <class T>
+    struct is_random_access_range {
+        template <class U>
+        static auto f(U const* u) -> typename std::enable_if<std::is_same<
+            typename std::decay<decltype((*u)[size_t(0)])>::type,
+            typename std::decay<typename U::value_type>::type>::value,
+            long>::type;
+        template <class U> static char f(...);
+
+        static bool const value = is_sized_range<T>::value
+            && (sizeof(f<T>(nullptr)) == sizeof(long));
+    };
+
+    // What operator[] of a random-access range returns.
+    template <class range>
+    using index_result = decltype(std::declval<range const&>()[size_t(0)]);
+
+    // Room for one element built on demand, for ranges whose front() has
+    // to return a reference to something they compute.  Copies start out
+    // empty, since the element may refer into the range copied from.
+    template <class T>
+    class element_cache {
+    public:
+        element_cache()
+            : full_(false)
+        {}
+
+        element_cache(element_cache const&)
+            : full_(false)
+        {}
+
+        element_cache& operator=(element_cache const&)
+        {
+            clear();
+            return *this;
+        }
+
+        ~element_cache()
+        {
+            clear();
+        }
+
+        bool empty() const
+        {
+            return !full_;
+        }
+
+        template <class... args>
+        T const& emplace(args&&... a)
+        {
+            clear();
+            new (&storage_) T(std::forward<args>(a)...);
+            full_ = true;
+            return get();
+        }
+
+        T const& get() const
+        {
+            return *reinterpret_cast<T const*>(&storage_);
+        }
+
+        void clear()
+        {
+            if (full_) {
+                get().~T();
+                full_ = false;
+            }
+        }
+
+    private:
+        bool full_;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage_;
+    };
+
     template <class range>
     class range_iterator
         : public std::iterator<std::input_iterator_tag,
-            typename range::value_type> {
+            typename std::decay<typename range::value_type>::type> {
     public:
         range_iterator()
             : r_(nullptr)
@@ -40,23 +138,85 @@ namespace ebt {
             return *this;
         }
 
-        typename range_iterator::value_type const& operator*()
+        typename range::value_type const& operator*() const
         {
             return r_->front();
         }
 
-        bool operator!=(range_iterator const& that)
+        // All iterators over a range share its position, so two of them
+        // are equal if they are over the same range or both at the end.
+        bool operator==(range_iterator const& that) const
         {
-            if (that.r_ == nullptr) {
-                return !r_->empty();
+            if (at_end() || that.at_end()) {
+                return at_end() == that.at_end();
             }
-            return true;
+            return r_ == that.r_;
+        }
+
+        bool operator!=(range_iterator const& that) const
+        {
+            return !(*this == that);
         }
 
     private:
         range* r_;
+
+        bool at_end() const
+        {
+            return r_ == nullptr || r_->empty();
+        }
+    };
+
+    // Containers that store their elements in one array.
+    template <class T>
+    struct is_contiguous : std::false_type {};
+
+    template <class T, class A>
+    struct is_contiguous<std::vector<T, A>>
+        : std::integral_constant<bool, !std::is_same<T, bool>::value> {};
+
+    template <class C, class T, class A>
+    struct is_contiguous<std::basic_string<C, T, A>> : std::true_type {};
+
+    template <class T, size_t n>
+    struct is_contiguous<std::array<T, n>> : std::true_type {};
+
+    struct ignore_sink {
+        template <class T>
+        void operator()(T const&) const
+        {}
     };
 
+    template <class T>
+    struct has_for_each {
+        template <class U>
+        static auto f(U const* u) -> decltype(
+            u->for_each(std::declval<ignore_sink&>()), long());
+        template <class U> static char f(...);
+
+        static bool const value = (sizeof(f<T>(nullptr)) == sizeof(long));
+    };
+
+    // Calls f on every element left in r, without consuming r.  Ranges
+    // that can drive the loop themselves provide a for_each member, so
+    // that a chain of adaptors becomes one loop with the functors
+    // nested inside it.
+    template <class range, class func>
+    typename std::enable_if<has_for_each<range>::value>::type
+    for_each(range const& r, func&& f)
+    {
+        r.for_each(f);
+    }
+
+    template <class range, class func>
+    typename std::enable_if<is_range<range>::value && !has_for_each<range>::value>::type
+    for_each(range r, func&& f)
+    {
+        for (; !r.empty(); r.pop_front()) {
+            f(r.front());
+        }
+    }
+
     template <class container>
     class range {
     public:
@@ -82,6 +242,41 @@ namespace ebt {
             return !(b_ != e_);
         }
 
+        template <class r = range>
+        typename std::enable_if<r::random_access, size_t>::type
+        size() const
+        {
+            return e_ - b_;
+        }
+
+        template <class r = range>
+        typename std::enable_if<r::random_access, value_type const&>::type
+        operator[](size_t n) const
+        {
+            return b_[n];
+        }
+
+        template <class r = range>
+        typename std::enable_if<r::contiguous, value_type const*>::type
+        data() const
+        {
+            return b_ == e_ ? nullptr : &*b_;
+        }
+
+        template <class func>
+        void for_each(func&& f) const
+        {
+            for (const_iterator i = b_; i != e_; ++i) {
+                f(*i);
+            }
+        }
+
+        static bool const random_access = std::is_base_of<
+            std::random_access_iterator_tag,
+            typename std::iterator_traits<const_iterator>::iterator_category>::value;
+
+        static bool const contiguous = is_contiguous<container>::value;
+
         range_iterator<range> begin()
         {
             return range_iterator<range>(*this);
@@ -103,6 +298,179 @@ namespace ebt {
         return range<container>(con);
     }
 
+    // The elements [b, e) of a random-access range.
+    template <class range>
+    class slice_range {
+    public:
+        using value_type = typename range::value_type;
+
+        slice_range(range r, size_t b, size_t e)
+            : r_(std::move(r)), b_(b), e_(e)
+        {}
+
+        void pop_front()
+        {
+            ++b_;
+            cache_.clear();
+        }
+
+        value_type const& front() const
+        {
+            return front(std::is_reference<index_result<range>>());
+        }
+
+        bool empty() const
+        {
+            return b_ >= e_;
+        }
+
+        size_t size() const
+        {
+            return e_ - b_;
+        }
+
+        index_result<range> operator[](size_t n) const
+        {
+            return r_[b_ + n];
+        }
+
+        template <class func>
+        void for_each(func&& f) const
+        {
+            for (size_t i = b_; i < e_; ++i) {
+                f(r_[i]);
+            }
+        }
+
+        range_iterator<slice_range> begin()
+        {
+            return range_iterator<slice_range>(*this);
+        }
+
+        range_iterator<slice_range> end()
+        {
+            return range_iterator<slice_range>();
+        }
+
+    private:
+        template <class> friend class chunk_range;
+
+        range r_;
+        size_t b_;
+        size_t e_;
+
+        mutable element_cache<value_type> cache_;
+
+        value_type const& front(std::true_type) const
+        {
+            return r_[b_];
+        }
+
+        value_type const& front(std::false_type) const
+        {
+            if (cache_.empty()) {
+                cache_.emplace(r_[b_]);
+            }
+            return cache_.get();
+        }
+    };
+
+    template <class range>
+    typename std::enable_if<is_random_access_range<range>::value,
+        slice_range<range>>::type
+    slice(range r, size_t b, size_t e)
+    {
+        e = std::min<size_t>(e, r.size());
+        return slice_range<range>(std::move(r), std::min(b, e), e);
+    }
+
+    // Consecutive slices of at most n elements of a random-access range,
+    // for example to hand out to threads.
+    template <class range>
+    class chunk_range {
+    public:
+        using value_type = slice_range<range>;
+
+        chunk_range(range r, size_t n)
+            : chunk_(std::move(r), 0, 0), n_(std::max<size_t>(n, 1)), i_(0),
+              size_(chunk_.r_.size()), dirty_(true)
+        {}
+
+        void pop_front()
+        {
+            i_ += n_;
+            dirty_ = true;
+        }
+
+        value_type const& front() const
+        {
+            if (dirty_) {
+                chunk_.b_ = i_;
+                chunk_.e_ = std::min(i_ + n_, size_);
+                chunk_.cache_.clear();
+                dirty_ = false;
+            }
+            return chunk_;
+        }
+
+        bool empty() const
+        {
+            return i_ >= size_;
+        }
+
+        size_t size() const
+        {
+            return (size_ - std::min(i_, size_) + n_ - 1) / n_;
+        }
+
+        value_type operator[](size_t k) const
+        {
+            size_t b = std::min(i_ + k * n_, size_);
+            return value_type(chunk_.r_, b, std::min(b + n_, size_));
+        }
+
+        range_iterator<chunk_range> begin()
+        {
+            return range_iterator<chunk_range>(*this);
+        }
+
+        range_iterator<chunk_range> end()
+        {
+            return range_iterator<chunk_range>();
+        }
+
+    private:
+        mutable value_type chunk_;
+        size_t n_;
+        size_t i_;
+        size_t size_;
+        mutable bool dirty_;
+    };
+
+    template <class range>
+    typename std::enable_if<is_random_access_range<range>::value,
+        chunk_range<range>>::type
+    chunk(range r, size_t n)
+    {
+        return chunk_range<range>(std::move(r), n);
+    }
+
+    template <class container>
+    typename std::enable_if<!is_range<container>::value,
+        slice_range<range<container>>>::type
+    slice(container const& con, size_t b, size_t e)
+    {
+        return slice(make_range(con), b, e);
+    }
+
+    template <class container>
+    typename std::enable_if<!is_range<container>::value,
+        chunk_range<range<container>>>::type
+    chunk(container const& con, size_t n)
+    {
+        return chunk(make_range(con), n);
+    }
+
 }
 
 #endif
@@ -0,0 +1,146 @@
+#include "ebt/replacer.h"
+#include <stdexcept>
+#include <deque>
+
+namespace ebt {
+
+    replacer::replacer(std::vector<std::pair<std::string, std::string>> rules)
+        : rules_(std::move(rules))
+    {
+        // Bytes that appear in no pattern all share class 0, which keeps
+        // the transition table small.
+        for (int c = 0; c < 256; ++c) {
+            class_[c] = 0;
+        }
+        classes_ = 1;
+        for (auto& r: rules_) {
+            if (r.first.empty()) {
+                throw std::invalid_argument("replacer: empty pattern");
+            }
+            for (unsigned char c: r.first) {
+                if (class_[c] == 0) {
+                    class_[c] = classes_++;
+                }
+            }
+        }
+
+        next_.assign(classes_, -1);
+        match_.assign(1, -1);
+        depth_.assign(1, 0);
+
+        for (int k = 0; k < int(rules_.size()); ++k) {
+            int state = 0;
+
+            for (unsigned char c: rules_[k].first) {
+                int& t = next_[state * classes_ + class_[c]];
+
+                if (t == -1) {
+                    t = match_.size();
+                    match_.push_back(-1);
+                    depth_.push_back(depth_[state] + 1);
+                    next_.resize(next_.size() + classes_, -1);
+                }
+
+                state = next_[state * classes_ + class_[c]];
+            }
+
+            if (match_[state] == -1) {
+                match_[state] = k;
+            }
+        }
+
+        // Breadth-first over the trie, turning it into a DFA whose
+        // missing edges follow failure links.
+        std::vector<int> fail(match_.size(), 0);
+        std::deque<int> queue;
+
+        for (int a = 0; a < classes_; ++a) {
+            int& t = next_[a];
+            if (t == -1) {
+                t = 0;
+            } else {
+                queue.push_back(t);
+            }
+        }
+
+        while (!queue.empty()) {
+            int state = queue.front();
+            queue.pop_front();
+
+            if (match_[state] == -1) {
+                match_[state] = match_[fail[state]];
+            }
+
+            for (int a = 0; a < classes_; ++a) {
+                int& t = next_[state * classes_ + a];
+                int f = next_[fail[state] * classes_ + a];
+
+                if (t == -1) {
+                    t = f;
+                } else {
+                    fail[t] = f;
+                    queue.push_back(t);
+                }
+            }
+        }
+    }
+
+    void replacer::apply(string_ref s, std::string& out) const
+    {
+        out.clear();
+
+        int state = 0;
+        size_t i = 0;
+        size_t start = 0;
+
+        // The best match seen so far that has not been written yet.
+        int k = -1;
+        size_t begin = 0;
+
+        while (true) {
+            // The depth of the current state tells where the earliest
+            // match still in progress begins.  Once that is past the
+            // pending match, nothing can beat it.
+            if (k != -1 && (i == s.size() || i - depth_[state] > begin)) {
+                out.append(s.data() + start, begin - start);
+                out += rules_[k].second;
+                start = begin + rules_[k].first.size();
+
+                i = start;
+                state = 0;
+                k = -1;
+
+                continue;
+            }
+
+            if (i == s.size()) {
+                break;
+            }
+
+            state = next_[state * classes_ + class_[(unsigned char) s[i]]];
+            ++i;
+
+            int m = match_[state];
+
+            if (m != -1) {
+                size_t b = i - rules_[m].first.size();
+
+                if (k == -1 || b < begin || (b == begin
+                        && rules_[m].first.size() > rules_[k].first.size())) {
+                    k = m;
+                    begin = b;
+                }
+            }
+        }
+
+        out.append(s.data() + start, s.size() - start);
+    }
+
+    std::string replacer::operator()(string_ref s) const
+    {
+        std::string result;
+        apply(s, result);
+        return result;
+    }
+
+}
@@ -0,0 +1,42 @@
+#ifndef EBT_REPLACER_H
+#define EBT_REPLACER_H
+
+#include "ebt/string_ref.h"
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace ebt {
+
+    // Applies a list of pattern/replacement rules in a single pass, using
+    // an Aho-Corasick automaton over all patterns.
+    //
+    // Matches are leftmost-longest: the match starting first wins, and
+    // among matches starting at the same position the longest one wins,
+    // with ties going to the earlier rule.  Scanning resumes right after
+    // each match, so replacements are never rescanned.  For rules whose
+    // patterns do not overlap, this is the same as applying the rules one
+    // after another.
+    class replacer {
+    public:
+        explicit replacer(std::vector<std::pair<std::string, std::string>> rules);
+
+        // Writes the rewritten s into out, replacing its contents.
+        void apply(string_ref s, std::string& out) const;
+
+        std::string operator()(string_ref s) const;
+
+    private:
+        std::vector<std::pair<std::string, std::string>> rules_;
+
+        unsigned char class_[256];
+        int classes_;
+
+        std::vector<int> next_;
+        std::vector<int> match_;
+        std::vector<int> depth_;
+    };
+
+}
+
+#endif
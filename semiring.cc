@@ -0,0 +1,548 @@
+#include "ebt/semiring.h"
+#include "ebt/dense.h"
+#include "ebt/simd.h"
+#include <cmath>
+#include <vector>
+
+#if EBT_SSE2
+#include <emmintrin.h>
+#endif
+
+#if EBT_AVX2_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace ebt {
+
+    namespace {
+
+        double const inf = std::numeric_limits<double>::infinity();
+
+        // Columns of the output accumulated at a time; with the scratch
+        // rows below they fit in L1.
+        size_t const col_block = 256;
+
+        // Rows of B read per pass over a block of columns, which then fit
+        // in L2.
+        size_t const k_block = 128;
+
+        // Rows of A reused across a batch in matvec_batch.
+        size_t const row_block = 32;
+
+#if EBT_SSE2
+        // Each kernel handles a prefix of the input and returns its length.
+
+        size_t max_plus_sse2(double const* row, double xi, double* acc, size_t n)
+        {
+            __m128d c = _mm_set1_pd(xi);
+
+            size_t i = 0;
+            for (; i + 2 <= n; i += 2) {
+                _mm_storeu_pd(acc + i, _mm_max_pd(_mm_loadu_pd(acc + i),
+                    _mm_add_pd(_mm_loadu_pd(row + i), c)));
+            }
+
+            return i;
+        }
+
+        size_t max_plus_arg_sse2(double const* row, double xi, double* acc,
+            double* arg, double idx, size_t n)
+        {
+            __m128d c = _mm_set1_pd(xi);
+            __m128d vi = _mm_set1_pd(idx);
+
+            size_t i = 0;
+            for (; i + 2 <= n; i += 2) {
+                __m128d v = _mm_add_pd(_mm_loadu_pd(row + i), c);
+                __m128d a = _mm_loadu_pd(acc + i);
+                __m128d gt = _mm_cmpgt_pd(v, a);
+                _mm_storeu_pd(acc + i, _mm_or_pd(_mm_and_pd(gt, v), _mm_andnot_pd(gt, a)));
+                _mm_storeu_pd(arg + i, _mm_or_pd(_mm_and_pd(gt, vi),
+                    _mm_andnot_pd(gt, _mm_loadu_pd(arg + i))));
+            }
+
+            return i;
+        }
+
+        size_t shift_row_sse2(double const* row, double xi, double const* shift,
+            double* out, size_t n)
+        {
+            __m128d c = _mm_set1_pd(xi);
+
+            size_t i = 0;
+            for (; i + 2 <= n; i += 2) {
+                _mm_storeu_pd(out + i, _mm_sub_pd(_mm_add_pd(_mm_loadu_pd(row + i), c),
+                    _mm_loadu_pd(shift + i)));
+            }
+
+            return i;
+        }
+
+        size_t row_max_sse2(double const* x, size_t n, double& result)
+        {
+            __m128d m0 = _mm_set1_pd(-inf);
+            __m128d m1 = _mm_set1_pd(-inf);
+
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                m0 = _mm_max_pd(m0, _mm_loadu_pd(x + i));
+                m1 = _mm_max_pd(m1, _mm_loadu_pd(x + i + 2));
+            }
+
+            double t[2];
+            _mm_storeu_pd(t, _mm_max_pd(m0, m1));
+            result = std::max(result, std::max(t[0], t[1]));
+
+            return i;
+        }
+#endif
+
+#if EBT_AVX2_DISPATCH
+        EBT_TARGET_AVX2_FMA
+        size_t max_plus_avx2(double const* row, double xi, double* acc, size_t n)
+        {
+            __m256d c = _mm256_set1_pd(xi);
+
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                _mm256_storeu_pd(acc + i, _mm256_max_pd(_mm256_loadu_pd(acc + i),
+                    _mm256_add_pd(_mm256_loadu_pd(row + i), c)));
+            }
+
+            return i;
+        }
+
+        EBT_TARGET_AVX2_FMA
+        size_t max_plus_arg_avx2(double const* row, double xi, double* acc,
+            double* arg, double idx, size_t n)
+        {
+            __m256d c = _mm256_set1_pd(xi);
+            __m256d vi = _mm256_set1_pd(idx);
+
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                __m256d v = _mm256_add_pd(_mm256_loadu_pd(row + i), c);
+                __m256d a = _mm256_loadu_pd(acc + i);
+                __m256d gt = _mm256_cmp_pd(v, a, _CMP_GT_OQ);
+                _mm256_storeu_pd(acc + i, _mm256_blendv_pd(a, v, gt));
+                _mm256_storeu_pd(arg + i, _mm256_blendv_pd(_mm256_loadu_pd(arg + i), vi, gt));
+            }
+
+            return i;
+        }
+
+        EBT_TARGET_AVX2_FMA
+        size_t shift_row_avx2(double const* row, double xi, double const* shift,
+            double* out, size_t n)
+        {
+            __m256d c = _mm256_set1_pd(xi);
+
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                _mm256_storeu_pd(out + i, _mm256_sub_pd(
+                    _mm256_add_pd(_mm256_loadu_pd(row + i), c), _mm256_loadu_pd(shift + i)));
+            }
+
+            return i;
+        }
+
+        EBT_TARGET_AVX2_FMA
+        size_t row_max_avx2(double const* x, size_t n, double& result)
+        {
+            __m256d m0 = _mm256_set1_pd(-inf);
+            __m256d m1 = _mm256_set1_pd(-inf);
+
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                m0 = _mm256_max_pd(m0, _mm256_loadu_pd(x + i));
+                m1 = _mm256_max_pd(m1, _mm256_loadu_pd(x + i + 4));
+            }
+
+            double t[4];
+            _mm256_storeu_pd(t, _mm256_max_pd(m0, m1));
+            result = std::max(result, std::max(std::max(t[0], t[1]), std::max(t[2], t[3])));
+
+            return i;
+        }
+#endif
+
+        // acc[j] = max(acc[j], row[j] + xi)
+        void max_plus(double const* row, double xi, double* acc, size_t n)
+        {
+            size_t i = 0;
+
+#if EBT_AVX2_DISPATCH
+            if (cpu_has_fma()) {
+                i = max_plus_avx2(row, xi, acc, n);
+            }
+#endif
+
+#if EBT_SSE2
+            i += max_plus_sse2(row + i, xi, acc + i, n - i);
+#endif
+
+            for (; i < n; ++i) {
+                acc[i] = std::max(acc[i], row[i] + xi);
+            }
+        }
+
+        // As max_plus, setting arg[j] = idx where acc[j] increases.
+        void max_plus_arg(double const* row, double xi, double* acc,
+            double* arg, double idx, size_t n)
+        {
+            size_t i = 0;
+
+#if EBT_AVX2_DISPATCH
+            if (cpu_has_fma()) {
+                i = max_plus_arg_avx2(row, xi, acc, arg, idx, n);
+            }
+#endif
+
+#if EBT_SSE2
+            i += max_plus_arg_sse2(row + i, xi, acc + i, arg + i, idx, n - i);
+#endif
+
+            for (; i < n; ++i) {
+                double v = row[i] + xi;
+
+                if (v > acc[i]) {
+                    acc[i] = v;
+                    arg[i] = idx;
+                }
+            }
+        }
+
+        // out[j] = row[j] + xi - shift[j]
+        void shift_row(double const* row, double xi, double const* shift,
+            double* out, size_t n)
+        {
+            size_t i = 0;
+
+#if EBT_AVX2_DISPATCH
+            if (cpu_has_fma()) {
+                i = shift_row_avx2(row, xi, shift, out, n);
+            }
+#endif
+
+#if EBT_SSE2
+            i += shift_row_sse2(row + i, xi, shift + i, out + i, n - i);
+#endif
+
+            for (; i < n; ++i) {
+                out[i] = row[i] + xi - shift[i];
+            }
+        }
+
+        double row_max(double const* x, size_t n)
+        {
+            double result = -inf;
+            size_t i = 0;
+
+#if EBT_AVX2_DISPATCH
+            if (cpu_has_fma()) {
+                i = row_max_avx2(x, n, result);
+            }
+#endif
+
+#if EBT_SSE2
+            i += row_max_sse2(x + i, n - i, result);
+#endif
+
+            for (; i < n; ++i) {
+                result = std::max(result, x[i]);
+            }
+
+            return result;
+        }
+
+        // Buffers of more doubles than this are freed when the call that
+        // grew them returns, so that one large product does not hold on to
+        // its memory for the life of the thread.
+        size_t const scratch_cap = 1 << 16;
+
+        // At least size doubles of a buffer kept per thread.  Calls that
+        // take one do not nest.
+        class scratch {
+        public:
+            explicit scratch(size_t size)
+                : buf_(buffer())
+            {
+                if (buf_.size() < size) {
+                    buf_.resize(size);
+                }
+            }
+
+            ~scratch()
+            {
+                if (buf_.size() > scratch_cap) {
+                    std::vector<double>().swap(buf_);
+                }
+            }
+
+            double* data()
+            {
+                return buf_.data();
+            }
+
+        private:
+            std::vector<double>& buf_;
+
+            static std::vector<double>& buffer()
+            {
+                thread_local std::vector<double> buf;
+                return buf;
+            }
+        };
+
+        // The products visit the output in blocks of columns, and within
+        // a block take the rows of B in blocks of k_block; each row of C
+        // is updated with the block of B while it is in cache.
+
+        void matmul_impl(real_semiring, double const* a, double const* b,
+            size_t n, size_t k, size_t m, double* c)
+        {
+            std::fill(c, c + n * m, 0.0);
+
+            for (size_t jb = 0; jb < m; jb += col_block) {
+                size_t w = std::min(col_block, m - jb);
+
+                for (size_t kb = 0; kb < k; kb += k_block) {
+                    size_t ke = std::min(k, kb + k_block);
+
+                    for (size_t i = 0; i < n; ++i) {
+                        for (size_t l = kb; l < ke; ++l) {
+                            dense::axpy(a[i * k + l], b + l * m + jb, c + i * m + jb, w);
+                        }
+                    }
+                }
+            }
+        }
+
+        void matmul_impl(tropical_semiring, double const* a, double const* b,
+            size_t n, size_t k, size_t m, double* c)
+        {
+            std::fill(c, c + n * m, -inf);
+
+            for (size_t jb = 0; jb < m; jb += col_block) {
+                size_t w = std::min(col_block, m - jb);
+
+                for (size_t kb = 0; kb < k; kb += k_block) {
+                    size_t ke = std::min(k, kb + k_block);
+
+                    for (size_t i = 0; i < n; ++i) {
+                        for (size_t l = kb; l < ke; ++l) {
+                            if (a[i * k + l] != -inf) {
+                                max_plus(b + l * m + jb, a[i * k + l], c + i * m + jb, w);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        // Each output is kept as a running max in c and a sum of exp(term
+        // - max) in s.  A block of B first raises the max, rescaling s,
+        // and then adds its terms, so every term takes one exp.
+        void matmul_impl(log_semiring, double const* a, double const* b,
+            size_t n, size_t k, size_t m, double* c)
+        {
+            std::fill(c, c + n * m, -inf);
+
+            scratch sums { n * m };
+            double* s = sums.data();
+            std::fill(s, s + n * m, 0.0);
+
+            double block_max[col_block];
+            double shift[col_block];
+            double terms[col_block];
+
+            for (size_t jb = 0; jb < m; jb += col_block) {
+                size_t w = std::min(col_block, m - jb);
+
+                for (size_t kb = 0; kb < k; kb += k_block) {
+                    size_t ke = std::min(k, kb + k_block);
+
+                    for (size_t i = 0; i < n; ++i) {
+                        double const* ai = a + i * k;
+                        double* ci = c + i * m + jb;
+                        double* si = s + i * m + jb;
+
+                        std::fill(block_max, block_max + w, -inf);
+                        for (size_t l = kb; l < ke; ++l) {
+                            if (ai[l] != -inf) {
+                                max_plus(b + l * m + jb, ai[l], block_max, w);
+                            }
+                        }
+
+                        for (size_t j = 0; j < w; ++j) {
+                            if (block_max[j] > ci[j]) {
+                                si[j] *= fast_exp(ci[j] - block_max[j]);
+                                ci[j] = block_max[j];
+                            }
+
+                            // Columns with no finite term yet get exp(-inf)
+                            // = 0 rather than exp(-inf + inf).
+                            shift[j] = (ci[j] == -inf ? 0 : ci[j]);
+                        }
+
+                        for (size_t l = kb; l < ke; ++l) {
+                            if (ai[l] != -inf) {
+                                shift_row(b + l * m + jb, ai[l], shift, terms, w);
+                                fast_exp(span<double const>(terms, w), span<double>(terms, w));
+                                dense::add(si, terms, si, w);
+                            }
+                        }
+                    }
+                }
+            }
+
+            for (size_t i = 0; i < n * m; ++i) {
+                if (c[i] != -inf) {
+                    c[i] += std::log(s[i]);
+                }
+            }
+        }
+
+        double reduce_row(real_semiring, double const* a, double const* x,
+            size_t n, double*)
+        {
+            return dense::dot(a, x, n);
+        }
+
+        double reduce_row(tropical_semiring, double const* a, double const* x,
+            size_t n, double* tmp)
+        {
+            dense::add(a, x, tmp, n);
+            return row_max(tmp, n);
+        }
+
+        double reduce_row(log_semiring, double const* a, double const* x,
+            size_t n, double* tmp)
+        {
+            dense::add(a, x, tmp, n);
+            return log_sum_exp(span<double const>(tmp, n));
+        }
+
+        template <class S>
+        void matvec_batch_impl(double const* a, size_t rows, size_t cols,
+            double const* x, size_t batch, double* y)
+        {
+            scratch tmp { cols };
+
+            for (size_t ib = 0; ib < rows; ib += row_block) {
+                size_t ie = std::min(rows, ib + row_block);
+
+                for (size_t s = 0; s < batch; ++s) {
+                    for (size_t i = ib; i < ie; ++i) {
+                        y[s * rows + i] = reduce_row(S(), a + i * cols, x + s * cols,
+                            cols, tmp.data());
+                    }
+                }
+            }
+        }
+
+    }
+
+    template <class S>
+    void vecmat(double const* x, double const* a, size_t rows, size_t cols, double* y)
+    {
+        matmul_impl(S(), x, a, 1, rows, cols, y);
+    }
+
+    template <class S>
+    void matvec(double const* a, size_t rows, size_t cols, double const* x, double* y)
+    {
+        matvec_batch_impl<S>(a, rows, cols, x, 1, y);
+    }
+
+    template <class S>
+    void matmul(double const* a, double const* b, size_t n, size_t k, size_t m, double* c)
+    {
+        matmul_impl(S(), a, b, n, k, m, c);
+    }
+
+    template <class S>
+    void matvec_batch(double const* a, size_t rows, size_t cols,
+        double const* x, size_t batch, double* y)
+    {
+        matvec_batch_impl<S>(a, rows, cols, x, batch, y);
+    }
+
+    void vecmat_argmax(double const* x, double const* a, size_t rows, size_t cols,
+        double* y, uint32_t* arg)
+    {
+        matmul_argmax(x, a, 1, rows, cols, y, arg);
+    }
+
+    void matvec_argmax(double const* a, size_t rows, size_t cols, double const* x,
+        double* y, uint32_t* arg)
+    {
+        scratch buf { cols };
+        double* tmp = buf.data();
+
+        for (size_t i = 0; i < rows; ++i) {
+            y[i] = reduce_row(tropical_semiring(), a + i * cols, x, cols, tmp);
+            arg[i] = argmax_npos;
+
+            if (y[i] != -inf) {
+                arg[i] = std::find(tmp, tmp + cols, y[i]) - tmp;
+            }
+        }
+    }
+
+    // The backpointers are kept as doubles while accumulating, so that the
+    // vector kernels can blend them with the same masks as the values.
+    void matmul_argmax(double const* a, double const* b, size_t n, size_t k, size_t m,
+        double* c, uint32_t* arg)
+    {
+        std::fill(c, c + n * m, -inf);
+
+        scratch indices { n * m };
+        double* index = indices.data();
+        std::fill(index, index + n * m, -1.0);
+
+        for (size_t jb = 0; jb < m; jb += col_block) {
+            size_t w = std::min(col_block, m - jb);
+
+            for (size_t kb = 0; kb < k; kb += k_block) {
+                size_t ke = std::min(k, kb + k_block);
+
+                for (size_t i = 0; i < n; ++i) {
+                    for (size_t l = kb; l < ke; ++l) {
+                        if (a[i * k + l] != -inf) {
+                            max_plus_arg(b + l * m + jb, a[i * k + l], c + i * m + jb,
+                                index + i * m + jb, double(l), w);
+                        }
+                    }
+                }
+            }
+        }
+
+        for (size_t i = 0; i < n * m; ++i) {
+            arg[i] = (index[i] < 0 ? argmax_npos : uint32_t(index[i]));
+        }
+    }
+
+    template void vecmat<real_semiring>(double const*, double const*, size_t, size_t, double*);
+    template void vecmat<log_semiring>(double const*, double const*, size_t, size_t, double*);
+    template void vecmat<tropical_semiring>(double const*, double const*, size_t, size_t, double*);
+
+    template void matvec<real_semiring>(double const*, size_t, size_t, double const*, double*);
+    template void matvec<log_semiring>(double const*, size_t, size_t, double const*, double*);
+    template void matvec<tropical_semiring>(double const*, size_t, size_t, double const*, double*);
+
+    template void matmul<real_semiring>(double const*, double const*,
+        size_t, size_t, size_t, double*);
+    template void matmul<log_semiring>(double const*, double const*,
+        size_t, size_t, size_t, double*);
+    template void matmul<tropical_semiring>(double const*, double const*,
+        size_t, size_t, size_t, double*);
+
+    template void matvec_batch<real_semiring>(double const*, size_t, size_t,
+        double const*, size_t, double*);
+    template void matvec_batch<log_semiring>(double const*, size_t, size_t,
+        double const*, size_t, double*);
+    template void matvec_batch<tropical_semiring>(double const*, size_t, size_t,
+        double const*, size_t, double*);
+
+}
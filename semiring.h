@@ -0,0 +1,88 @@
+#ifndef EBT_SEMIRING_H
+#define EBT_SEMIRING_H
+
+#include "ebt/math_util.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace ebt {
+
+    // Semirings over double, as the plus and times of the kernels below.
+
+    struct real_semiring {
+        static double zero() { return 0; }
+        static double one() { return 1; }
+        static double plus(double a, double b) { return a + b; }
+        static double times(double a, double b) { return a * b; }
+    };
+
+    // Sums of probabilities in log space, as in forward-backward.
+    struct log_semiring {
+        static double zero() { return -std::numeric_limits<double>::infinity(); }
+        static double one() { return 0; }
+
+        static double plus(double a, double b)
+        {
+            if (a == zero() || b == zero()) {
+                return std::max(a, b);
+            }
+            return log_add(a, b);
+        }
+
+        static double times(double a, double b) { return a + b; }
+    };
+
+    // Max-plus, as in Viterbi.
+    struct tropical_semiring {
+        static double zero() { return -std::numeric_limits<double>::infinity(); }
+        static double one() { return 0; }
+        static double plus(double a, double b) { return std::max(a, b); }
+        static double times(double a, double b) { return a + b; }
+    };
+
+    // Matrices are dense and row-major.  The kernels are defined for the
+    // three semirings above, vectorized like dense.h, and blocked so that
+    // the rows of the output being accumulated stay in cache.  The
+    // output must not overlap the inputs.
+
+    // y = x A, for x of length rows: y[j] = sum_i x[i] * a[i][j].
+    template <class S>
+    void vecmat(double const* x, double const* a, size_t rows, size_t cols, double* y);
+
+    // y = A x, for x of length cols: y[i] = sum_j a[i][j] * x[j].
+    template <class S>
+    void matvec(double const* a, size_t rows, size_t cols, double const* x, double* y);
+
+    // C = A B, for A of n by k and B of k by m.  With the rows of A being
+    // the state vectors of n sequences, this is vecmat for all of them at
+    // once.
+    template <class S>
+    void matmul(double const* a, double const* b, size_t n, size_t k, size_t m, double* c);
+
+    // y[s] = A x[s] for batch vectors x[s] of length cols, stored as the
+    // rows of x, with the results stored as the rows of y.
+    template <class S>
+    void matvec_batch(double const* a, size_t rows, size_t cols,
+        double const* x, size_t batch, double* y);
+
+    // The tropical kernels with backpointers: alongside each output, the
+    // index i (or j, for matvec) of the first term that attains the max,
+    // or npos if every term is -inf.
+
+    uint32_t const argmax_npos = uint32_t(-1);
+
+    void vecmat_argmax(double const* x, double const* a, size_t rows, size_t cols,
+        double* y, uint32_t* arg);
+
+    void matvec_argmax(double const* a, size_t rows, size_t cols, double const* x,
+        double* y, uint32_t* arg);
+
+    // A Viterbi step for n sequences at once; arg is n by m like C.
+    void matmul_argmax(double const* a, double const* b, size_t n, size_t k, size_t m,
+        double* c, uint32_t* arg);
+
+}
+
+#endif
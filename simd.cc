@@ -0,0 +1,53 @@
+#include "ebt/simd.h"
+#include <atomic>
+
+namespace ebt {
+
+    namespace {
+
+        std::atomic<int> max_level { int(simd_level::avx2) };
+
+        bool allowed(simd_level level)
+        {
+            return max_level.load(std::memory_order_relaxed) >= int(level);
+        }
+
+    }
+
+    bool cpu_has_ssse3()
+    {
+#if EBT_AVX2_DISPATCH
+        static bool const result = __builtin_cpu_supports("ssse3");
+        return result && allowed(simd_level::ssse3);
+#else
+        return false;
+#endif
+    }
+
+    bool cpu_has_avx2()
+    {
+#if EBT_AVX2_DISPATCH
+        static bool const result = __builtin_cpu_supports("avx2");
+        return result && allowed(simd_level::avx2);
+#else
+        return false;
+#endif
+    }
+
+    bool cpu_has_fma()
+    {
+#if EBT_AVX2_DISPATCH
+        static bool const result = __builtin_cpu_supports("avx2")
+            && __builtin_cpu_supports("fma");
+        return result && allowed(simd_level::avx2);
+#else
+        return false;
+#endif
+    }
+
+    void set_max_simd_level(simd_level level)
+    {
+        max_level.store(int(level), std::memory_order_relaxed);
+    }
+
+}
@@ -0,0 +1,32 @@
+#ifndef EBT_SIMD_H
+#define EBT_SIMD_H
+
+#if defined(__SSE2__)
+#define EBT_SSE2 1
+#endif
+
+// Kernels compiled for AVX2 and FMA are selected at run time, so the
+// library itself can be built for the SSE2 baseline.
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define EBT_AVX2_DISPATCH 1
+#define EBT_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define EBT_TARGET_AVX2 __attribute__((target("avx2")))
+#define EBT_TARGET_AVX2_FMA __attribute__((target("avx2,fma")))
+#endif
+
+namespace ebt {
+
+    bool cpu_has_ssse3();
+    bool cpu_has_avx2();
+    bool cpu_has_fma();
+
+    // The widest instruction set that run-time dispatch may pick.  Tests
+    // lower it to run the SSE2 and SSSE3 kernels on machines that have
+    // AVX2.
+    enum class simd_level { sse2, ssse3, avx2 };
+
+    void set_max_simd_level(simd_level level);
+
+}
+
+#endif
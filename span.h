@@ -0,0 +1,146 @@
+#ifndef EBT_SPAN_H
+#define EBT_SPAN_H
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+#include <ostream>
+
+namespace ebt {
+
+    // A non-owning view of size contiguous elements.  The elements must
+    // outlive the span.
+    template <class T>
+    class span {
+    public:
+        using value_type = typename std::remove_const<T>::type;
+        using iterator = T*;
+        using const_iterator = T*;
+
+        span()
+            : data_(nullptr), size_(0)
+        {}
+
+        span(T* data, size_t size)
+            : data_(data), size_(size)
+        {}
+
+        template <class U, class = typename std::enable_if<
+            std::is_convertible<U*, T*>::value>::type>
+        span(span<U> const& s)
+            : data_(s.data()), size_(s.size())
+        {}
+
+        template <class U, class = typename std::enable_if<
+            std::is_convertible<U*, T*>::value>::type>
+        span(std::vector<U>& v)
+            : data_(v.data()), size_(v.size())
+        {}
+
+        template <class U, class = typename std::enable_if<
+            std::is_convertible<U const*, T*>::value>::type>
+        span(std::vector<U> const& v)
+            : data_(v.data()), size_(v.size())
+        {}
+
+        T* data() const
+        {
+            return data_;
+        }
+
+        size_t size() const
+        {
+            return size_;
+        }
+
+        bool empty() const
+        {
+            return size_ == 0;
+        }
+
+        T* begin() const
+        {
+            return data_;
+        }
+
+        T* end() const
+        {
+            return data_ + size_;
+        }
+
+        T& operator[](size_t i) const
+        {
+            return data_[i];
+        }
+
+        T& front() const
+        {
+            return data_[0];
+        }
+
+        T& back() const
+        {
+            return data_[size_ - 1];
+        }
+
+        span subspan(size_t pos, size_t size) const
+        {
+            return span(data_ + pos, size);
+        }
+
+    private:
+        T* data_;
+        size_t size_;
+    };
+
+    template <class T>
+    span<T> make_span(std::vector<T>& v)
+    {
+        return span<T>(v.data(), v.size());
+    }
+
+    template <class T>
+    span<T const> make_span(std::vector<T> const& v)
+    {
+        return span<T const>(v.data(), v.size());
+    }
+
+    template <class T, class U>
+    bool operator==(span<T> const& a, span<U> const& b)
+    {
+        if (a.size() != b.size()) {
+            return false;
+        }
+
+        for (size_t i = 0; i < a.size(); ++i) {
+            if (!(a[i] == b[i])) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    template <class T, class U>
+    bool operator!=(span<T> const& a, span<U> const& b)
+    {
+        return !(a == b);
+    }
+
+    template <class T>
+    std::ostream& operator<<(std::ostream& os, span<T> const& s)
+    {
+        os << "[";
+        for (size_t i = 0; i < s.size(); ++i) {
+            if (i != 0) {
+                os << ", ";
+            }
+            os << s[i];
+        }
+        os << "]";
+        return os;
+    }
+
+}
+
+#endif
@@ -0,0 +1,312 @@
+#include "ebt/sparse_id_vector.h"
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace ebt {
+
+    sparse_id_vector::sparse_id_vector(std::vector<uint32_t> ids,
+        std::vector<double> values)
+    {
+        if (ids.size() != values.size()) {
+            throw std::invalid_argument("ids and values differ in length");
+        }
+
+        if (std::is_sorted(ids.begin(), ids.end())
+                && std::adjacent_find(ids.begin(), ids.end()) == ids.end()) {
+            ids_ = std::move(ids);
+            values_ = std::move(values);
+            return;
+        }
+
+        std::vector<uint32_t> order(ids.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(),
+            [&](uint32_t i, uint32_t j) { return ids[i] < ids[j]; });
+
+        ids_.reserve(ids.size());
+        values_.reserve(ids.size());
+
+        for (auto i: order) {
+            if (!ids_.empty() && ids_.back() == ids[i]) {
+                values_.back() += values[i];
+            } else {
+                ids_.push_back(ids[i]);
+                values_.push_back(values[i]);
+            }
+        }
+    }
+
+    sparse_id_vector::sparse_id_vector(
+        std::initializer_list<std::pair<uint32_t, double>> list)
+    {
+        std::vector<uint32_t> ids;
+        std::vector<double> values;
+
+        for (auto& p: list) {
+            ids.push_back(p.first);
+            values.push_back(p.second);
+        }
+
+        *this = sparse_id_vector(std::move(ids), std::move(values));
+    }
+
+    void sparse_id_vector::push_back(uint32_t id, double value)
+    {
+        if (!ids_.empty() && id <= ids_.back()) {
+            throw std::invalid_argument("ids must be pushed in increasing order");
+        }
+
+        ids_.push_back(id);
+        values_.push_back(value);
+    }
+
+    void sparse_id_vector::reserve(size_t size)
+    {
+        ids_.reserve(size);
+        values_.reserve(size);
+    }
+
+    void sparse_id_vector::clear()
+    {
+        ids_.clear();
+        values_.clear();
+    }
+
+    double sparse_id_vector::operator()(uint32_t id) const
+    {
+        auto i = std::lower_bound(ids_.begin(), ids_.end(), id);
+
+        if (i == ids_.end() || *i != id) {
+            return 0;
+        }
+
+        return values_[i - ids_.begin()];
+    }
+
+    sparse_id_vector& sparse_id_vector::operator+=(sparse_id_vector const& that)
+    {
+        axpy(1, that, *this);
+        return *this;
+    }
+
+    sparse_id_vector& sparse_id_vector::operator-=(sparse_id_vector const& that)
+    {
+        axpy(-1, that, *this);
+        return *this;
+    }
+
+    sparse_id_vector& sparse_id_vector::operator*=(double scalar)
+    {
+        for (auto& v: values_) {
+            v *= scalar;
+        }
+        return *this;
+    }
+
+    namespace {
+
+        // The first index in [i, n) whose id is not below id, found by
+        // doubling steps from i and then bisecting.
+        size_t gallop(uint32_t const* ids, size_t i, size_t n, uint32_t id)
+        {
+            size_t step = 1;
+            size_t lo = i;
+            size_t hi = i;
+
+            while (hi < n && ids[hi] < id) {
+                lo = hi + 1;
+                hi += step;
+                step *= 2;
+            }
+
+            return std::lower_bound(ids + lo, ids + std::min(hi, n), id) - ids;
+        }
+
+    }
+
+    double dot(sparse_id_vector const& a, sparse_id_vector const& b)
+    {
+        if (a.size() > b.size()) {
+            return dot(b, a);
+        }
+
+        uint32_t const* ai = a.ids().data();
+        uint32_t const* bi = b.ids().data();
+        double const* av = a.values().data();
+        double const* bv = b.values().data();
+        size_t n = a.size();
+        size_t m = b.size();
+
+        double result = 0;
+
+        if (n * 16 < m) {
+            size_t j = 0;
+
+            for (size_t i = 0; i < n && j < m; ++i) {
+                j = gallop(bi, j, m, ai[i]);
+
+                if (j < m && bi[j] == ai[i]) {
+                    result += av[i] * bv[j];
+                    ++j;
+                }
+            }
+
+            return result;
+        }
+
+        size_t i = 0;
+        size_t j = 0;
+
+        while (i < n && j < m) {
+            uint32_t x = ai[i];
+            uint32_t y = bi[j];
+
+            if (x == y) {
+                result += av[i] * bv[j];
+            }
+
+            i += (x <= y);
+            j += (y <= x);
+        }
+
+        return result;
+    }
+
+    double dot(sparse_id_vector const& a, span<double const> dense)
+    {
+        uint32_t const* ids = a.ids().data();
+        double const* values = a.values().data();
+        size_t n = a.size();
+
+        double s0 = 0;
+        double s1 = 0;
+        size_t i = 0;
+
+        for (; i + 2 <= n; i += 2) {
+            s0 += values[i] * dense[ids[i]];
+            s1 += values[i + 1] * dense[ids[i + 1]];
+        }
+
+        for (; i < n; ++i) {
+            s0 += values[i] * dense[ids[i]];
+        }
+
+        return s0 + s1;
+    }
+
+    void axpy(double a, sparse_id_vector const& x, sparse_id_vector& y)
+    {
+        if (x.empty()) {
+            return;
+        }
+
+        std::vector<uint32_t> const& xi = x.ids();
+        std::vector<double> const& xv = x.values();
+
+        // If every id of x is already in y, as when accumulating into a
+        // weight vector, y is updated in place without reallocating.
+        if (x.size() <= y.size()) {
+            std::vector<uint32_t> const& yi = y.ids();
+            size_t i = 0;
+
+            for (size_t j = 0; i < xi.size(); ++i, ++j) {
+                j = gallop(yi.data(), j, yi.size(), xi[i]);
+
+                if (j == yi.size() || yi[j] != xi[i]) {
+                    break;
+                }
+            }
+
+            if (i == xi.size()) {
+                double* yv = y.values().data();
+
+                for (size_t i = 0, j = 0; i < xi.size(); ++i, ++j) {
+                    j = gallop(yi.data(), j, yi.size(), xi[i]);
+                    yv[j] += a * xv[i];
+                }
+
+                return;
+            }
+        }
+
+        sparse_id_vector result;
+        result.reserve(x.size() + y.size());
+
+        std::vector<uint32_t> const& yi = y.ids();
+        std::vector<double> const& yv = y.values();
+        size_t i = 0;
+        size_t j = 0;
+
+        while (i < xi.size() || j < yi.size()) {
+            if (j == yi.size() || (i < xi.size() && xi[i] < yi[j])) {
+                result.push_back(xi[i], a * xv[i]);
+                ++i;
+            } else if (i == xi.size() || yi[j] < xi[i]) {
+                result.push_back(yi[j], yv[j]);
+                ++j;
+            } else {
+                result.push_back(yi[j], yv[j] + a * xv[i]);
+                ++i;
+                ++j;
+            }
+        }
+
+        y = std::move(result);
+    }
+
+    void axpy(double a, sparse_id_vector const& x, span<double> y)
+    {
+        uint32_t const* ids = x.ids().data();
+        double const* values = x.values().data();
+
+        for (size_t i = 0; i < x.size(); ++i) {
+            y[ids[i]] += a * values[i];
+        }
+    }
+
+    bool operator==(sparse_id_vector const& a, sparse_id_vector const& b)
+    {
+        return a.ids() == b.ids() && a.values() == b.values();
+    }
+
+    std::ostream& operator<<(std::ostream& os, sparse_id_vector const& v)
+    {
+        os << "{";
+        for (size_t i = 0; i < v.size(); ++i) {
+            if (i != 0) {
+                os << ", ";
+            }
+            os << v.ids()[i] << ": " << v.values()[i];
+        }
+        os << "}";
+        return os;
+    }
+
+    sparse_id_vector to_sparse_id_vector(SparseVector const& v, symbol_table& symbols)
+    {
+        std::vector<uint32_t> ids;
+        std::vector<double> values;
+        ids.reserve(v.size());
+        values.reserve(v.size());
+
+        for (auto& p: v) {
+            ids.push_back(symbols.intern(p.first));
+            values.push_back(p.second);
+        }
+
+        return sparse_id_vector(std::move(ids), std::move(values));
+    }
+
+    SparseVector to_sparse_vector(sparse_id_vector const& v, symbol_table const& symbols)
+    {
+        SparseVector result;
+
+        for (size_t i = 0; i < v.size(); ++i) {
+            result(symbols.str(v.ids()[i]).str()) = v.values()[i];
+        }
+
+        return result;
+    }
+
+}
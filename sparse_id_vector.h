@@ -0,0 +1,96 @@
+#ifndef EBT_SPARSE_ID_VECTOR_H
+#define EBT_SPARSE_ID_VECTOR_H
+
+#include "ebt/span.h"
+#include "ebt/sparse_vector.h"
+#include "ebt/symbol_table.h"
+#include <cstdint>
+#include <initializer_list>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+namespace ebt {
+
+    // A sparse vector keyed by 32-bit feature ids, stored as two parallel
+    // arrays sorted by id.  Unlike SparseVector, entries that become zero
+    // are kept.
+    class sparse_id_vector {
+    public:
+        sparse_id_vector() = default;
+
+        // Sorts the entries and sums the values of repeated ids.
+        sparse_id_vector(std::vector<uint32_t> ids, std::vector<double> values);
+
+        sparse_id_vector(std::initializer_list<std::pair<uint32_t, double>> list);
+
+        // Appends an entry whose id is larger than every id so far.
+        void push_back(uint32_t id, double value);
+
+        void reserve(size_t size);
+
+        void clear();
+
+        size_t size() const
+        {
+            return ids_.size();
+        }
+
+        bool empty() const
+        {
+            return ids_.empty();
+        }
+
+        std::vector<uint32_t> const& ids() const
+        {
+            return ids_;
+        }
+
+        std::vector<double> const& values() const
+        {
+            return values_;
+        }
+
+        // The values can be changed in place; the ids cannot.
+        std::vector<double>& values()
+        {
+            return values_;
+        }
+
+        // Returns the value of id, or 0 if it is absent.
+        double operator()(uint32_t id) const;
+
+        sparse_id_vector& operator+=(sparse_id_vector const& that);
+        sparse_id_vector& operator-=(sparse_id_vector const& that);
+        sparse_id_vector& operator*=(double scalar);
+
+    private:
+        std::vector<uint32_t> ids_;
+        std::vector<double> values_;
+    };
+
+    // A merge over the two id lists.  When one vector is much shorter, its
+    // ids are searched for in the other by galloping instead.
+    double dot(sparse_id_vector const& a, sparse_id_vector const& b);
+
+    // Gathers from a dense vector, which must be longer than every id.
+    double dot(sparse_id_vector const& a, span<double const> dense);
+
+    // y += a * x, with the result merged in one pass.
+    void axpy(double a, sparse_id_vector const& x, sparse_id_vector& y);
+
+    // y += a * x for a dense y, which must be longer than every id.
+    void axpy(double a, sparse_id_vector const& x, span<double> y);
+
+    bool operator==(sparse_id_vector const& a, sparse_id_vector const& b);
+
+    std::ostream& operator<<(std::ostream& os, sparse_id_vector const& v);
+
+    // Converts through the ids of a symbol_table, interning new features.
+    sparse_id_vector to_sparse_id_vector(SparseVector const& v, symbol_table& symbols);
+
+    SparseVector to_sparse_vector(sparse_id_vector const& v, symbol_table const& symbols);
+
+}
+
+#endif
@@ -17,88 +17,106 @@ namespace ebt {
         : map_(std::move(map))
     {}
     
-    double& SparseVector::operator()(std::string const &key)
+    SparseVector::value_ref SparseVector::operator()(std::string const &key)
     {
-        return map_[key];
+        return value_ref(map_[key], scale_);
     }
     
     double SparseVector::operator()(std::string const &key) const
     {
-        if (in(key, map_)) {
-            return map_.at(key);
-        } else {
+        auto i = map_.find(key);
+
+        if (i == map_.end()) {
             return 0;
+        } else {
+            return i->second * scale_;
         }
     }
     
     SparseVector & SparseVector::operator+=(SparseVector const &that)
     {
-        for (auto &p: that.map_) {
-            map_[p.first] += p.second;
-            if (std::fabs(map_[p.first]) < 1e-300) {
-                map_.erase(p.first);
-            }
-        }
-        return *this;
+        return axpy(1, that);
     }
     
     SparseVector & SparseVector::operator-=(SparseVector const &that)
     {
-        for (auto &p: that.map_) {
-            map_[p.first] -= p.second;
-            if (std::fabs(map_[p.first]) < 1e-300) {
-                map_.erase(p.first);
-            }
-        }
-        return *this;
+        return axpy(-1, that);
     }
     
     SparseVector & SparseVector::operator*=(double scalar)
     {
-        std::vector<std::string> to_erase;
-    
-        for (auto &p: map_) {
-            p.second *= scalar;
-            if (std::fabs(p.second) < 1e-300) {
-                to_erase.push_back(p.first);
-            }
+        if (scalar == 0) {
+            map_.clear();
+            scale_ = 1;
+            return *this;
         }
-    
-        for (auto &k: to_erase) {
-            map_.erase(k);
+
+        scale_ *= scalar;
+
+        // Keep the stored values from drifting out of range after many
+        // small decays.
+        if (std::fabs(scale_) < 1e-100 || std::fabs(scale_) > 1e100) {
+            fold();
         }
+
         return *this;
     }
     
     SparseVector & SparseVector::operator/=(double scalar)
     {
-        std::vector<std::string> to_erase;
-    
+        return *this *= 1.0 / scalar;
+    }
+
+    SparseVector & SparseVector::axpy(double a, SparseVector const &x)
+    {
+        double factor = a * x.scale_ / scale_;
+
+        for (auto &p: x.map_) {
+            map_[p.first] += factor * p.second;
+        }
+
+        return *this;
+    }
+
+    void SparseVector::fold()
+    {
+        if (scale_ == 1) {
+            return;
+        }
+
         for (auto &p: map_) {
-            p.second /= scalar;
-            if (std::fabs(p.second) < 1e-300) {
-                to_erase.push_back(p.first);
-            }
+            p.second *= scale_;
         }
-    
-        for (auto &k: to_erase) {
-            map_.erase(k);
+
+        scale_ = 1;
+    }
+
+    void SparseVector::compact(double threshold)
+    {
+        fold();
+
+        for (auto i = map_.begin(); i != map_.end(); ) {
+            if (std::fabs(i->second) < threshold) {
+                i = map_.erase(i);
+            } else {
+                ++i;
+            }
         }
-        return *this;
     }
     
     SparseVector::const_iterator SparseVector::begin() const
     {
-        return map_.begin();
+        return const_iterator(map_.begin(), scale_);
     }
     
     SparseVector::const_iterator SparseVector::end() const
     {
-        return map_.end();
+        return const_iterator(map_.end(), scale_);
     }
     
     SparseVector::iterator SparseVector::begin()
     {
+        fold();
         return map_.begin();
     }
     
@@ -119,10 +137,13 @@ namespace ebt {
         }
     
         double result = 0;
-        for (auto &p: a) {
-            result += p.second * b(p.first);
+        for (auto &p: a.map_) {
+            auto i = b.map_.find(p.first);
+            if (i != b.map_.end()) {
+                result += p.second * i->second;
+            }
         }
-        return result;
+        return result * a.scale_ * b.scale_;
     }
     
     bool in(std::string const &key, SparseVector const &v)
@@ -132,19 +153,28 @@ namespace ebt {
 
     std::ostream& operator<<(std::ostream& os, SparseVector const& v)
     {
-        json::dump(v.map_, os);
+        if (v.scale_ == 1) {
+            json::dump(v.map_, os);
+        } else {
+            std::unordered_map<std::string, double> scaled = v.map_;
+            for (auto& p: scaled) {
+                p.second *= v.scale_;
+            }
+            json::dump(scaled, os);
+        }
+
         return os;
     }
     
     double get(ebt::SparseVector const& vec, std::string key, double default_)
     {
-        return ebt::get(vec.map_, key, default_);
+        return in(key, vec) ? vec(key) : default_;
     }
 
     double norm(ebt::SparseVector const& v, int p)
     {
         double max = 0;
-        for (auto& e: v) {
+        for (auto& e: v.map_) {
             if (std::fabs(e.second) > max) {
                 max = std::fabs(e.second);
             }
@@ -153,9 +183,9 @@ namespace ebt {
             return 0;
         }
         double sum = 0;
-        for (auto& e: v) {
+        for (auto& e: v.map_) {
             sum += std::pow(std::fabs(e.second) / max, p);
         }
-        return max * std::pow(sum, 1.0 / p);
+        return std::fabs(v.scale_) * max * std::pow(sum, 1.0 / p);
     }
 }
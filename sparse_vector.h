@@ -1,15 +1,19 @@
 #ifndef EBT_SPARSE_VECTOR_H
 #define EBT_SPARSE_VECTOR_H
 
+#include "ebt/range.h"
+#include <iterator>
 #include <string>
 #include <unordered_map>
+#include <utility>
 
 namespace ebt {
 
     class SparseVector {
     public:
-        using const_iterator
-            = typename std::unordered_map<std::string, double>::const_iterator;
+        class const_iterator;
+        class value_ref;
+
         using iterator
             = typename std::unordered_map<std::string, double>::iterator;
     
@@ -20,13 +24,24 @@ namespace ebt {
     
         explicit SparseVector(std::unordered_map<std::string, double> map);
     
-        double& operator()(std::string const &key);
+        value_ref operator()(std::string const &key);
         double operator()(std::string const &key) const;
     
         SparseVector & operator+=(SparseVector const &that);
         SparseVector & operator-=(SparseVector const &that);
         SparseVector & operator*=(double scalar);
         SparseVector & operator/=(double scalar);
+
+        // *this += a * x, with one lookup per key of x.
+        SparseVector & axpy(double a, SparseVector const &x);
+
+        // Multiplies the pending scale factor into the values.  Non-const
+        // iteration does this first.
+        void fold();
+
+        // Removes the entries whose magnitude is below threshold.  Nothing
+        // else removes entries that become zero.
+        void compact(double threshold = 1e-300);
     
         const_iterator begin() const;
         const_iterator end() const;
@@ -39,11 +54,123 @@ namespace ebt {
         friend double dot(SparseVector const &a, SparseVector const &b);
         friend bool in(std::string const &key, SparseVector const &v);
         friend double get(ebt::SparseVector const& vec, std::string key, double default_);
+        friend double norm(ebt::SparseVector const& v, int p);
 
         friend std::ostream& operator<<(std::ostream& os, SparseVector const& v);
     
     private:
+        // The value of a key is map_[key] * scale_, so that scaling the
+        // whole vector is O(1).
         std::unordered_map<std::string, double> map_;
+        double scale_ = 1;
+    };
+
+    // Iterates over the entries with the scale factor applied, leaving the
+    // vector as it is.  The pair is rebuilt on each dereference.
+    class SparseVector::const_iterator
+        : public std::iterator<std::forward_iterator_tag,
+            std::pair<std::string const&, double>> {
+    public:
+        const_iterator() = default;
+
+        const_iterator(std::unordered_map<std::string, double>::const_iterator it,
+                double scale)
+            : it_(it), scale_(scale)
+        {}
+
+        value_type const& operator*() const
+        {
+            return entry_.emplace(it_->first, it_->second * scale_);
+        }
+
+        value_type const* operator->() const
+        {
+            return &**this;
+        }
+
+        const_iterator& operator++()
+        {
+            ++it_;
+            return *this;
+        }
+
+        const_iterator operator++(int)
+        {
+            const_iterator result = *this;
+            ++it_;
+            return result;
+        }
+
+        bool operator==(const_iterator const& that) const
+        {
+            return it_ == that.it_;
+        }
+
+        bool operator!=(const_iterator const& that) const
+        {
+            return it_ != that.it_;
+        }
+
+    private:
+        std::unordered_map<std::string, double>::const_iterator it_;
+        double scale_ = 1;
+        mutable element_cache<value_type> entry_;
+    };
+
+    // What non-const operator() returns.  Reads and writes go through the
+    // scale factor, so writing one key leaves the others scaled lazily.
+    // It is valid until the vector is next scaled or folded.
+    class SparseVector::value_ref {
+    public:
+        operator double() const
+        {
+            return *value_ * scale_;
+        }
+
+        value_ref& operator=(value_ref const& that)
+        {
+            return *this = double(that);
+        }
+
+        value_ref& operator=(double v)
+        {
+            *value_ = v / scale_;
+            return *this;
+        }
+
+        value_ref& operator+=(double v)
+        {
+            *value_ += v / scale_;
+            return *this;
+        }
+
+        value_ref& operator-=(double v)
+        {
+            *value_ -= v / scale_;
+            return *this;
+        }
+
+        value_ref& operator*=(double v)
+        {
+            *value_ *= v;
+            return *this;
+        }
+
+        value_ref& operator/=(double v)
+        {
+            *value_ /= v;
+            return *this;
+        }
+
+    private:
+        friend class SparseVector;
+
+        value_ref(double& value, double scale)
+            : value_(&value), scale_(scale)
+        {}
+
+        double* value_;
+        double scale_;
     };
     
     double dot(SparseVector const &a, SparseVector const &b);
@@ -1,161 +1,579 @@
 #include "ebt/string.h"
+#include "ebt/simd.h"
+#include <cstring>
+#include <cstdio>
+#include <cstdint>
+
+#if EBT_SSE2
+#include <emmintrin.h>
+#endif
+
+#if EBT_AVX2_DISPATCH
+#include <immintrin.h>
+#endif
 
 namespace ebt {
 
+    void append(std::string& buf, string_ref s)
+    {
+        buf.append(s.data(), s.size());
+    }
+
+    void append(std::string& buf, std::string const& s)
+    {
+        buf += s;
+    }
+
+    void append(std::string& buf, char const* s)
+    {
+        buf += s;
+    }
+
+    void append(std::string& buf, char c)
+    {
+        buf += c;
+    }
+
+    void append(std::string& buf, unsigned long long i)
+    {
+        char digits[24];
+        char* p = digits + sizeof(digits);
+
+        do {
+            *--p = '0' + i % 10;
+            i /= 10;
+        } while (i != 0);
+
+        buf.append(p, digits + sizeof(digits) - p);
+    }
+
+    void append(std::string& buf, long long i)
+    {
+        if (i < 0) {
+            buf += '-';
+            append(buf, 0ull - static_cast<unsigned long long>(i));
+        } else {
+            append(buf, static_cast<unsigned long long>(i));
+        }
+    }
+
+    void append(std::string& buf, int i)
+    {
+        append(buf, static_cast<long long>(i));
+    }
+
+    void append(std::string& buf, long i)
+    {
+        append(buf, static_cast<long long>(i));
+    }
+
+    void append(std::string& buf, unsigned int i)
+    {
+        append(buf, static_cast<unsigned long long>(i));
+    }
+
+    void append(std::string& buf, unsigned long i)
+    {
+        append(buf, static_cast<unsigned long long>(i));
+    }
+
+    void append(std::string& buf, float f)
+    {
+        append(buf, static_cast<double>(f));
+    }
+
+    void append(std::string& buf, double d)
+    {
+        char s[32];
+        int n = std::snprintf(s, sizeof(s), "%g", d);
+        buf.append(s, n);
+    }
+
+    namespace {
+
+        thread_local string_builder scratch_builder;
+        thread_local bool scratch_busy = false;
+
+    }
+
+    local_builder::local_builder()
+    {
+        if (scratch_busy) {
+            sb_ = &own_;
+        } else {
+            scratch_busy = true;
+            sb_ = &scratch_builder;
+            sb_->clear();
+        }
+    }
+
+    local_builder::~local_builder()
+    {
+        if (sb_ != &own_) {
+            scratch_busy = false;
+        }
+    }
+
     std::ostream& format(std::ostream& os, std::string fmt)
     {
-        return os << fmt;
+        format_rest(os, string_ref(fmt));
+        return os;
     }
 
-    class split_impl {
-    public:
-        split_impl(std::string const& str, std::string const& sep="");
-        std::vector<std::string> compute();
-    private:
-        void push_back(std::vector<std::string> &list,
-            std::string const& p);
-    
-        std::string str_;
-        std::string sep_;
-    };
-    
-    split_impl::split_impl(std::string const& str, std::string const& sep):
-        str_(str), sep_(sep)
+    format_string::format_string(string_ref fmt)
+    {
+        size_t i;
+
+        while ((i = format_literal(text_, fmt)) != string_ref::npos) {
+            holes_.push_back(text_.size());
+            fmt = fmt.substr(i);
+        }
+    }
+
+    size_t string_ref::find(string_ref s, size_t pos) const
+    {
+        if (s.size() == 0) {
+            return pos <= size_ ? pos : npos;
+        }
+
+        while (pos + s.size() <= size_) {
+            pos = find(s[0], pos);
+
+            if (pos == npos || pos + s.size() > size_) {
+                return npos;
+            }
+
+            if (std::memcmp(data_ + pos, s.data(), s.size()) == 0) {
+                return pos;
+            }
+
+            ++pos;
+        }
+
+        return npos;
+    }
+
+    size_t string_ref::find_first_of(string_ref chars, size_t pos) const
+    {
+        for (; pos < size_; ++pos) {
+            if (chars.find(data_[pos]) != npos) {
+                return pos;
+            }
+        }
+
+        return npos;
+    }
+
+    split_range::split_range(string_ref s, string_ref sep)
+        : next_(s.data()), end_(s.data() + s.size()), sep_(sep), done_(false)
     {
+        pop_front();
     }
-    
-    std::vector<std::string> split_impl::compute()
+
+    void split_range::pop_front()
     {
-        std::vector<std::string> out;
-        int p = 0;
-        while (1) {
-            auto q = std::string::npos;
-            if (sep_ != "") {
-                q = str_.find(sep_, p);
+        if (next_ == nullptr) {
+            done_ = true;
+            return;
+        }
+
+        string_ref rest(next_, end_ - next_);
+
+        if (sep_.size() != 0) {
+            size_t q = rest.find(sep_);
+
+            if (q == string_ref::npos) {
+                token_ = rest;
+                next_ = nullptr;
             } else {
-                q = str_.find_first_of(" \n\t", p);
+                token_ = rest.substr(0, q);
+                next_ += q + sep_.size();
+            }
+        } else {
+            char const* ws = " \n\t";
+
+            size_t p = 0;
+            while (p < rest.size() && std::strchr(ws, rest[p]) != nullptr) {
+                ++p;
             }
-            if (q == std::string::npos) {
-                push_back(out, str_.substr(p));
-                break;
+
+            if (p == rest.size()) {
+                next_ = nullptr;
+                done_ = true;
+                return;
             }
-            push_back(out, str_.substr(p, q - p));
-            if (q + std::max<unsigned int>(sep_.length(), 1) <
-                    str_.length()) {
-                p = q + std::max<unsigned int>(sep_.length(), 1);
+
+            size_t q = rest.find_first_of(ws, p);
+
+            if (q == string_ref::npos) {
+                token_ = rest.substr(p);
+                next_ = nullptr;
             } else {
-                push_back(out, "");
-                break;
+                token_ = rest.substr(p, q - p);
+                next_ += q;
             }
         }
-    
-        return out;
     }
-    
-    void split_impl::push_back(std::vector<std::string>& list,
-        std::string const& s)
+
+    std::vector<std::string> split(std::string const& s,
+        std::string sep)
     {
-        if (sep_ != "" || s != "") {
-            list.push_back(s);
+        std::vector<std::string> result;
+
+        for (split_range r(s, sep); !r.empty(); r.pop_front()) {
+            result.emplace_back(r.front().data(), r.front().size());
         }
+
+        return result;
     }
-    
-    std::vector<std::string> split(std::string const& s,
-        std::string sep)
+
+    std::vector<std::string> split(char const* s, std::string sep)
+    {
+        return split(std::string(s), sep);
+    }
+
+    std::vector<string_ref> split(string_ref s, string_ref sep)
     {
-        return split_impl(s, sep).compute();
+        std::vector<string_ref> result;
+
+        for (split_range r(s, sep); !r.empty(); r.pop_front()) {
+            result.push_back(r.front());
+        }
+
+        return result;
     }
 
     std::string replace(std::string s, std::string pattern,
         std::string replacement)
     {
-        std::vector<std::string> parts = ebt::split(s, pattern);
-        return ebt::join(parts, replacement);
+        if (pattern.empty()) {
+            std::vector<std::string> parts = ebt::split(s, pattern);
+            return ebt::join(parts, replacement);
+        }
+
+        size_t p = s.find(pattern);
+
+        if (p == std::string::npos) {
+            return s;
+        }
+
+        std::string result;
+        result.reserve(s.size());
+
+        size_t b = 0;
+        while (p != std::string::npos) {
+            result.append(s, b, p - b);
+            result += replacement;
+            b = p + pattern.size();
+            p = s.find(pattern, b);
+        }
+        result.append(s, b, std::string::npos);
+
+        return result;
     }
 
     std::string strip(std::string const& str, std::string const& chars)
     {
-        int s = 0;
-        for (int i = 0; i < int(str.size()); ++i) {
-            if (chars.find(str[i]) == std::string::npos) {
-                break;
+        return strip(string_ref(str), string_ref(chars)).str();
+    }
+
+    std::string strip(char const* str, std::string const& chars)
+    {
+        return strip(string_ref(str), string_ref(chars)).str();
+    }
+
+    // A 256-bit membership table, so that each byte costs one lookup
+    // instead of a scan over chars.
+    struct char_set {
+        uint64_t bits[4];
+
+        explicit char_set(string_ref chars)
+            : bits{0, 0, 0, 0}
+        {
+            for (unsigned char c: chars) {
+                bits[c >> 6] |= uint64_t(1) << (c & 63);
             }
+        }
+
+        bool has(unsigned char c) const
+        {
+            return (bits[c >> 6] >> (c & 63)) & 1;
+        }
+    };
+
+    string_ref strip(string_ref str, string_ref chars)
+    {
+        char_set set(chars);
+
+        size_t s = 0;
+        while (s < str.size() && set.has(str[s])) {
             ++s;
         }
-    
-        int b = str.size();
-        for (int i = int(str.size()) - 1; i >= 0; --i) {
-            if (chars.find(str[i]) == std::string::npos) {
-                break;
-            }
+
+        size_t b = str.size();
+        while (b > s && set.has(str[b - 1])) {
             --b;
         }
-    
+
         return str.substr(s, b - s);
     }
 
-    std::string escapeseq(std::string const& s)
+    // Returns the index of the first '\\' or '"' in p[0, size), or size.
+    size_t find_escape(char const* p, size_t size)
     {
-        std::string result;
-    
-        for (auto c: s) {
-            if (c == '\\') {
-                result += '\\';
-                result += '\\';
-            } else if (c == '"') {
-                result += '\\';
-                result += '\"';
-            } else {
-                result += c;
+        size_t i = 0;
+
+#if EBT_SSE2
+        __m128i const backslash = _mm_set1_epi8('\\');
+        __m128i const quote = _mm_set1_epi8('"');
+
+        for (; i + 16 <= size; i += 16) {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + i));
+            int mask = _mm_movemask_epi8(_mm_or_si128(
+                _mm_cmpeq_epi8(x, backslash), _mm_cmpeq_epi8(x, quote)));
+
+            if (mask != 0) {
+                return i + __builtin_ctz(mask);
+            }
+        }
+#endif
+
+        for (; i < size; ++i) {
+            if (p[i] == '\\' || p[i] == '"') {
+                return i;
+            }
+        }
+
+        return size;
+    }
+
+    size_t escaped_size(string_ref s)
+    {
+        size_t extra = 0;
+        for (size_t i = find_escape(s.data(), s.size()); i < s.size();
+                i += 1 + find_escape(s.data() + i + 1, s.size() - i - 1)) {
+            ++extra;
+        }
+
+        return s.size() + extra;
+    }
+
+    // Writes s with '\\' and '"' escaped to out, which must have room for
+    // escaped_size(s) characters.
+    void escape_into(char* out, string_ref s)
+    {
+        size_t i = 0;
+        while (i < s.size()) {
+            size_t n = find_escape(s.data() + i, s.size() - i);
+            std::memcpy(out, s.data() + i, n);
+            out += n;
+            i += n;
+
+            if (i < s.size()) {
+                *out++ = '\\';
+                *out++ = s[i];
+                ++i;
             }
         }
-    
+    }
+
+    std::string escapeseq(std::string const& s)
+    {
+        std::string result(escaped_size(s), '\0');
+        escape_into(&result[0], s);
         return result;
     }
 
-    std::string upper(std::string const& s)
+    string_builder& escapeseq(string_ref s, string_builder& sb)
     {
-        std::string result;
-        for (auto& c: s) {
-            result += std::toupper(c);
+        escape_into(sb.extend(escaped_size(s)), s);
+        return sb;
+    }
+
+    void flip_case_scalar(char* dst, char const* src, size_t size, char lo, char hi)
+    {
+        for (size_t i = 0; i < size; ++i) {
+            char c = src[i];
+            dst[i] = (lo <= c && c <= hi ? c ^ 0x20 : c);
+        }
+    }
+
+#if EBT_SSE2
+    size_t flip_case_sse2(char* dst, char const* src, size_t size, char lo, char hi)
+    {
+        __m128i const above = _mm_set1_epi8(lo - 1);
+        __m128i const below = _mm_set1_epi8(hi + 1);
+        __m128i const bit = _mm_set1_epi8(0x20);
+
+        size_t i = 0;
+        for (; i + 16 <= size; i += 16) {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i));
+            __m128i in = _mm_and_si128(_mm_cmpgt_epi8(x, above), _mm_cmplt_epi8(x, below));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                _mm_xor_si128(x, _mm_and_si128(in, bit)));
         }
+
+        return i;
+    }
+#endif
+
+#if EBT_AVX2_DISPATCH
+    EBT_TARGET_AVX2
+    size_t flip_case_avx2(char* dst, char const* src, size_t size, char lo, char hi)
+    {
+        __m256i const above = _mm256_set1_epi8(lo - 1);
+        __m256i const below = _mm256_set1_epi8(hi + 1);
+        __m256i const bit = _mm256_set1_epi8(0x20);
+
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32) {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + i));
+            __m256i in = _mm256_and_si256(_mm256_cmpgt_epi8(x, above),
+                _mm256_cmpgt_epi8(below, x));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+                _mm256_xor_si256(x, _mm256_and_si256(in, bit)));
+        }
+
+        return i;
+    }
+#endif
+
+    // Flips the case of the ASCII letters in [lo, hi].  Bytes outside
+    // ASCII are left alone, as std::toupper does in the "C" locale.
+    void flip_case(char* dst, char const* src, size_t size, char lo, char hi)
+    {
+        size_t i = 0;
+
+#if EBT_AVX2_DISPATCH
+        if (cpu_has_avx2()) {
+            i = flip_case_avx2(dst, src, size, lo, hi);
+        }
+#endif
+
+#if EBT_SSE2
+        i += flip_case_sse2(dst + i, src + i, size - i, lo, hi);
+#endif
+
+        flip_case_scalar(dst + i, src + i, size - i, lo, hi);
+    }
+
+    std::string upper(std::string const& s)
+    {
+        std::string result(s.size(), '\0');
+        flip_case(&result[0], s.data(), s.size(), 'a', 'z');
         return result;
     }
 
+    string_builder& upper(string_ref s, string_builder& sb)
+    {
+        flip_case(sb.extend(s.size()), s.data(), s.size(), 'a', 'z');
+        return sb;
+    }
+
     std::string lower(std::string const& s)
     {
-        std::string result;
-        for (auto& c: s) {
-            result += std::tolower(c);
-        }
+        std::string result(s.size(), '\0');
+        flip_case(&result[0], s.data(), s.size(), 'A', 'Z');
         return result;
     }
 
+    string_builder& lower(string_ref s, string_builder& sb)
+    {
+        flip_case(sb.extend(s.size()), s.data(), s.size(), 'A', 'Z');
+        return sb;
+    }
+
+    void upper_inplace(std::string& s)
+    {
+        flip_case(&s[0], s.data(), s.size(), 'a', 'z');
+    }
+
+    void lower_inplace(std::string& s)
+    {
+        flip_case(&s[0], s.data(), s.size(), 'A', 'Z');
+    }
+
     bool startswith(std::string const& s, std::string const& prefix)
     {
-        return s.find(prefix) == 0;
+        return startswith(string_ref(s), string_ref(prefix));
+    }
+
+    bool startswith(char const* s, string_ref prefix)
+    {
+        return startswith(string_ref(s), prefix);
+    }
+
+    bool startswith(string_ref s, string_ref prefix)
+    {
+        return s.size() >= prefix.size()
+            && s.substr(0, prefix.size()) == prefix;
     }
 
     bool endswith(std::string const& s, std::string const& suffix)
     {
-        int i = s.find(suffix);
-        return i >= 0 && i == int(s.size()) - int(suffix.size());
+        return endswith(string_ref(s), string_ref(suffix));
+    }
+
+    bool endswith(char const* s, string_ref suffix)
+    {
+        return endswith(string_ref(s), suffix);
+    }
+
+    bool endswith(string_ref s, string_ref suffix)
+    {
+        return s.size() >= suffix.size()
+            && s.substr(s.size() - suffix.size()) == suffix;
+    }
+
+    // Counts the bytes that start a character, i.e., that are not
+    // continuation bytes of the form 10xxxxxx.
+    size_t count_utf8_starts(char const* p, size_t size)
+    {
+        size_t count = 0;
+        size_t i = 0;
+
+#if EBT_SSE2
+        __m128i const lead = _mm_set1_epi8(char(0xC0));
+
+        for (; i + 16 <= size; i += 16) {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + i));
+            count += 16 - __builtin_popcount(_mm_movemask_epi8(_mm_cmplt_epi8(x, lead)));
+        }
+#endif
+
+        for (; i < size; ++i) {
+            count += ((p[i] & 0xC0) != 0x80);
+        }
+
+        return count;
     }
 
     std::vector<std::string> split_utf8_chars(std::string const &s)
     {
         std::vector<std::string> result;
-        std::string tmp;
-        for (auto &c: s) {
-            if ((c & 0xC0) == 0xC0 && !tmp.empty()) {
-                result.push_back(tmp);
-                tmp.clear();
+        result.reserve(count_utf8_starts(s.data(), s.size()));
+
+        size_t i = 0;
+        while (i < s.size()) {
+#if EBT_SSE2
+            if (i + 16 <= s.size() && _mm_movemask_epi8(_mm_loadu_si128(
+                    reinterpret_cast<__m128i const*>(s.data() + i))) == 0) {
+                for (size_t k = i; k < i + 16; ++k) {
+                    result.emplace_back(1, s[k]);
+                }
+                i += 16;
+                continue;
             }
-            tmp += c;
-        }
-        if (!tmp.empty()) {
-            result.push_back(tmp);
+#endif
+
+            size_t j = i + 1;
+            while (j < s.size() && (s[j] & 0xC0) == 0x80) {
+                ++j;
+            }
+            result.emplace_back(s, i, j - i);
+            i = j;
         }
+
         return result;
     }
 
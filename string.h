@@ -2,13 +2,167 @@
 #define EBT_STRING_H
 
 #include "ebt/range.h"
+#include "ebt/string_ref.h"
 #include <string>
 #include <ostream>
 #include <sstream>
 #include <vector>
+#include <stdexcept>
 
 namespace ebt {
 
+    // Appends the textual form of a value to buf.  Numbers are formatted
+    // as operator<< would with default stream flags, without a stream.
+    void append(std::string& buf, string_ref s);
+    void append(std::string& buf, std::string const& s);
+    void append(std::string& buf, char const* s);
+    void append(std::string& buf, char c);
+    void append(std::string& buf, int i);
+    void append(std::string& buf, long i);
+    void append(std::string& buf, long long i);
+    void append(std::string& buf, unsigned int i);
+    void append(std::string& buf, unsigned long i);
+    void append(std::string& buf, unsigned long long i);
+    void append(std::string& buf, float f);
+    void append(std::string& buf, double d);
+
+    template <class T>
+    void append(std::string& buf, T const& t)
+    {
+        std::ostringstream oss;
+        oss << t;
+        buf += oss.str();
+    }
+
+    inline void append_chars(std::string& buf, char const* s, size_t size)
+    {
+        buf.append(s, size);
+    }
+
+    inline void append_chars(std::ostream& os, char const* s, size_t size)
+    {
+        os.write(s, size);
+    }
+
+    inline void append_value(std::string& buf, char const* s)
+    {
+        append(buf, s);
+    }
+
+    template <class T>
+    void append_value(std::string& buf, T const& t)
+    {
+        append(buf, t);
+    }
+
+    template <class T>
+    void append_value(std::ostream& os, T const& t)
+    {
+        os << t;
+    }
+
+    // A growable character buffer that functions such as join, format and
+    // escapeseq append into.  Reusing one builder across calls, or using
+    // local_builder, avoids allocating in steady state.
+    class string_builder {
+    public:
+        void reserve(size_t size)
+        {
+            buf_.reserve(size);
+        }
+
+        void clear()
+        {
+            buf_.clear();
+        }
+
+        size_t size() const
+        {
+            return buf_.size();
+        }
+
+        bool empty() const
+        {
+            return buf_.empty();
+        }
+
+        char const* data() const
+        {
+            return buf_.data();
+        }
+
+        string_ref view() const
+        {
+            return string_ref(buf_);
+        }
+
+        std::string str() const
+        {
+            return buf_;
+        }
+
+        std::string& buffer()
+        {
+            return buf_;
+        }
+
+        // Grows the buffer by size characters and returns where they
+        // start, for callers that write the characters directly.
+        char* extend(size_t size)
+        {
+            size_t old = buf_.size();
+            buf_.resize(old + size);
+            return &buf_[old];
+        }
+
+        template <class T>
+        string_builder& operator<<(T const& t)
+        {
+            append_value(buf_, t);
+            return *this;
+        }
+
+    private:
+        std::string buf_;
+    };
+
+    inline void append_chars(string_builder& sb, char const* s, size_t size)
+    {
+        sb.buffer().append(s, size);
+    }
+
+    template <class T>
+    void append_value(string_builder& sb, T const& t)
+    {
+        append_value(sb.buffer(), t);
+    }
+
+    // Lends out the calling thread's scratch builder, cleared, for the
+    // lifetime of the object.  If the scratch builder is already lent
+    // further up the stack, a private builder is used instead.
+    class local_builder {
+    public:
+        local_builder();
+        ~local_builder();
+
+        local_builder(local_builder const&) = delete;
+        local_builder& operator=(local_builder const&) = delete;
+
+        string_builder& operator*()
+        {
+            return *sb_;
+        }
+
+        string_builder* operator->()
+        {
+            return sb_;
+        }
+
+    private:
+        string_builder* sb_;
+        string_builder own_;
+    };
+
     template <class range>
     typename std::enable_if<is_range<range>::value, std::ostream&>::type
     join(range r, std::string sep, std::ostream& os)
@@ -32,12 +186,98 @@ namespace ebt {
         return join(make_range(con), sep, os);
     }
 
+    template <class range>
+    typename std::enable_if<is_range<range>::value, string_builder&>::type
+    join(range r, string_ref sep, string_builder& sb)
+    {
+        while (!r.empty()) {
+            append_value(sb, r.front());
+            r.pop_front();
+
+            if (!r.empty()) {
+                append_chars(sb, sep.data(), sep.size());
+            }
+        }
+
+        return sb;
+    }
+
     template <class container>
-    std::string join(container const& con, std::string sep)
+    typename std::enable_if<std::is_convertible<
+        typename container::value_type, string_ref>::value, size_t>::type
+    joined_size(container const& con, string_ref sep)
     {
-        std::ostringstream oss;
-        join(con, sep, oss);
-        return oss.str();
+        size_t size = 0;
+
+        for (auto& e: con) {
+            size += string_ref(e).size() + sep.size();
+        }
+
+        return size == 0 ? 0 : size - sep.size();
+    }
+
+    template <class container>
+    typename std::enable_if<!std::is_convertible<
+        typename container::value_type, string_ref>::value, size_t>::type
+    joined_size(container const& con, string_ref sep)
+    {
+        return 0;
+    }
+
+    template <class container>
+    typename std::enable_if<!is_range<container>::value, string_builder&>::type
+    join(container const& con, string_ref sep, string_builder& sb)
+    {
+        sb.reserve(sb.size() + joined_size(con, sep));
+        return join(make_range(con), sep, sb);
+    }
+
+    // Writes the text of fmt before the first "{}" to out, turning "{{"
+    // and "}}" into "{" and "}".  Returns the position right after the
+    // "{}", or string_ref::npos if there is none.
+    template <class Out>
+    size_t format_literal(Out& out, string_ref fmt)
+    {
+        size_t b = 0;
+
+        for (size_t i = 0; i + 1 < fmt.size(); ++i) {
+            if (fmt[i] == '{' && fmt[i + 1] == '}') {
+                append_chars(out, fmt.data() + b, i - b);
+                return i + 2;
+            } else if ((fmt[i] == '{' || fmt[i] == '}') && fmt[i + 1] == fmt[i]) {
+                append_chars(out, fmt.data() + b, i + 1 - b);
+                ++i;
+                b = i + 1;
+            }
+        }
+
+        append_chars(out, fmt.data() + b, fmt.size() - b);
+
+        return string_ref::npos;
+    }
+
+    template <class Out>
+    void format_rest(Out& out, string_ref fmt)
+    {
+        size_t i;
+
+        while ((i = format_literal(out, fmt)) != string_ref::npos) {
+            append_chars(out, "{}", 2);
+            fmt = fmt.substr(i);
+        }
+    }
+
+    template <class Out, class T, class... Args>
+    void format_rest(Out& out, string_ref fmt, T const& t, Args const&... args)
+    {
+        size_t i = format_literal(out, fmt);
+
+        if (i == string_ref::npos) {
+            return;
+        }
+
+        append_value(out, t);
+        format_rest(out, fmt.substr(i), args...);
     }
 
     std::ostream& format(std::ostream& os, std::string fmt);
@@ -46,55 +286,225 @@ namespace ebt {
     std::ostream& format(std::ostream& os, std::string fmt,
         T const& t, Args const&... args)
     {
-        unsigned int i;
-    
-        for (i = 0; i < fmt.size(); ++i) {
-            if (fmt.at(i) == '{') {
-                if (fmt.at(i + 1) == '{') {
-                    ++i;
-                    os << '{';
-                } else if (fmt.at(i + 1) == '}') {
-                    i += 2;
-                    os << t;
-                    break;
-                }
-            } else if (fmt.at(i) == '}' && fmt.at(i + 1) == '}') {
-                ++i;
-                os << '}';
-            } else {
-                os << fmt.at(i);
-            }
-        }
-    
-        return format(os, fmt.substr(i), args...);
+        format_rest(os, string_ref(fmt), t, args...);
+        return os;
     }
     
+    template <typename... Args>
+    string_builder& format(string_builder& sb, string_ref fmt, Args const&... args)
+    {
+        format_rest(sb, fmt, args...);
+        return sb;
+    }
+
     template <typename... Args>
     std::string format(std::string fmt, Args const&... args)
     {
-        std::ostringstream oss;
-        format(oss, std::move(fmt), args...);
-        return oss.str();
+        local_builder sb;
+        format(*sb, fmt, args...);
+        return sb->str();
     }
 
+    template <class container>
+    std::string join(container const& con, std::string sep)
+    {
+        local_builder sb;
+        join(con, sep, *sb);
+        return sb->str();
+    }
+
+    // A format string parsed once, for use on hot paths:
+    //
+    //     static ebt::format_string const key("{}:{}");
+    //     key.append(buf, word, i);
+    //
+    // The number of arguments must match the number of "{}".
+    class format_string {
+    public:
+        explicit format_string(string_ref fmt);
+
+        size_t holes() const
+        {
+            return holes_.size();
+        }
+
+        template <class... Args>
+        std::string& append(std::string& buf, Args const&... args) const
+        {
+            if (sizeof...(Args) != holes_.size()) {
+                throw std::invalid_argument("format_string: wrong number of arguments");
+            }
+
+            append_from(buf, 0, args...);
+
+            return buf;
+        }
+
+        template <class... Args>
+        string_builder& append(string_builder& sb, Args const&... args) const
+        {
+            append(sb.buffer(), args...);
+            return sb;
+        }
+
+        template <class... Args>
+        std::string operator()(Args const&... args) const
+        {
+            std::string result;
+            append(result, args...);
+            return result;
+        }
+
+    private:
+        std::string text_;
+        std::vector<size_t> holes_;
+
+        void append_from(std::string& buf, size_t k) const
+        {
+            size_t b = (k == 0 ? 0 : holes_[k - 1]);
+            buf.append(text_, b, std::string::npos);
+        }
+
+        template <class T, class... Args>
+        void append_from(std::string& buf, size_t k, T const& t, Args const&... args) const
+        {
+            size_t b = (k == 0 ? 0 : holes_[k - 1]);
+            buf.append(text_, b, holes_[k] - b);
+            append_value(buf, t);
+            append_from(buf, k + 1, args...);
+        }
+    };
+
     std::vector<std::string> split(std::string const& s,
         std::string sep="");
 
+    std::vector<std::string> split(char const* s, std::string sep="");
+
+    std::vector<string_ref> split(string_ref s, string_ref sep=string_ref());
+
+    class split_iterator;
+
+    // A lazy range over the tokens of a string, with the same semantics
+    // as split.  Tokens are views into the original string.
+    class split_range {
+    public:
+        using value_type = string_ref;
+        using const_iterator = split_iterator;
+
+        split_range() = default;
+
+        explicit split_range(string_ref s, string_ref sep=string_ref());
+
+        void pop_front();
+
+        value_type const& front() const
+        {
+            return token_;
+        }
+
+        bool empty() const
+        {
+            return done_;
+        }
+
+        const_iterator begin() const;
+        const_iterator end() const;
+
+    private:
+        string_ref token_;
+        char const* next_ = nullptr;
+        char const* end_ = nullptr;
+        string_ref sep_;
+        bool done_ = true;
+    };
+
+    class split_iterator
+        : public std::iterator<std::forward_iterator_tag, string_ref> {
+    public:
+        split_iterator() = default;
+
+        explicit split_iterator(split_range const& r)
+            : r_(r)
+        {}
+
+        split_iterator& operator++()
+        {
+            r_.pop_front();
+            return *this;
+        }
+
+        string_ref const& operator*() const
+        {
+            return r_.front();
+        }
+
+        string_ref const* operator->() const
+        {
+            return &r_.front();
+        }
+
+        bool operator==(split_iterator const& that) const
+        {
+            return r_.empty() == that.r_.empty()
+                && (r_.empty() || r_.front().data() == that.r_.front().data());
+        }
+
+        bool operator!=(split_iterator const& that) const
+        {
+            return !(*this == that);
+        }
+
+    private:
+        split_range r_;
+    };
+
+    inline split_iterator split_range::begin() const
+    {
+        return split_iterator(*this);
+    }
+
+    inline split_iterator split_range::end() const
+    {
+        return split_iterator();
+    }
+
     std::string replace(std::string s, std::string pattern,
         std::string replacement);
     
     std::string strip(std::string const& str, std::string const& chars=" \t\n");
 
+    std::string strip(char const* str, std::string const& chars=" \t\n");
+
+    string_ref strip(string_ref str, string_ref chars=" \t\n");
+
     std::string escapeseq(std::string const& s);
 
+    string_builder& escapeseq(string_ref s, string_builder& sb);
+
     std::string upper(std::string const& s);
 
+    string_builder& upper(string_ref s, string_builder& sb);
+
     std::string lower(std::string const& s);
 
+    string_builder& lower(string_ref s, string_builder& sb);
+
+    void upper_inplace(std::string& s);
+
+    void lower_inplace(std::string& s);
+
     bool startswith(std::string const& s, std::string const& prefix);
 
+    bool startswith(char const* s, string_ref prefix);
+
+    bool startswith(string_ref s, string_ref prefix);
+
     bool endswith(std::string const& s, std::string const& suffix);
 
+    bool endswith(char const* s, string_ref suffix);
+
+    bool endswith(string_ref s, string_ref suffix);
+
     std::vector<std::string> split_utf8_chars(std::string const &s);
 
 }
@@ -0,0 +1,142 @@
+#ifndef EBT_STRING_REF_H
+#define EBT_STRING_REF_H
+
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include <ostream>
+#include <functional>
+#include "ebt/hash.h"
+
+namespace ebt {
+
+    // A non-owning view of a contiguous run of characters.  The viewed
+    // storage must outlive the string_ref.
+    class string_ref {
+    public:
+        using value_type = char;
+        using const_iterator = char const*;
+
+        static constexpr size_t npos = size_t(-1);
+
+        string_ref()
+            : data_(nullptr), size_(0)
+        {}
+
+        string_ref(char const* s)
+            : data_(s), size_(std::strlen(s))
+        {}
+
+        string_ref(char const* s, size_t size)
+            : data_(s), size_(size)
+        {}
+
+        string_ref(std::string const& s)
+            : data_(s.data()), size_(s.size())
+        {}
+
+        char const* data() const
+        {
+            return data_;
+        }
+
+        size_t size() const
+        {
+            return size_;
+        }
+
+        bool empty() const
+        {
+            return size_ == 0;
+        }
+
+        const_iterator begin() const
+        {
+            return data_;
+        }
+
+        const_iterator end() const
+        {
+            return data_ + size_;
+        }
+
+        char operator[](size_t i) const
+        {
+            return data_[i];
+        }
+
+        string_ref substr(size_t pos, size_t n = npos) const
+        {
+            pos = std::min(pos, size_);
+            return string_ref(data_ + pos, std::min(n, size_ - pos));
+        }
+
+        size_t find(char c, size_t pos = 0) const
+        {
+            if (pos >= size_) {
+                return npos;
+            }
+
+            void const* p = std::memchr(data_ + pos, c, size_ - pos);
+            return p == nullptr ? npos : static_cast<char const*>(p) - data_;
+        }
+
+        size_t find(string_ref s, size_t pos = 0) const;
+
+        size_t find_first_of(string_ref chars, size_t pos = 0) const;
+
+        std::string str() const
+        {
+            return std::string(data_, size_);
+        }
+
+        explicit operator std::string() const
+        {
+            return str();
+        }
+
+    private:
+        char const* data_;
+        size_t size_;
+    };
+
+    inline bool operator==(string_ref a, string_ref b)
+    {
+        return a.size() == b.size()
+            && (a.size() == 0 || std::memcmp(a.data(), b.data(), a.size()) == 0);
+    }
+
+    inline bool operator!=(string_ref a, string_ref b)
+    {
+        return !(a == b);
+    }
+
+    inline bool operator<(string_ref a, string_ref b)
+    {
+        int c = std::memcmp(a.data(), b.data(), std::min(a.size(), b.size()));
+        return c < 0 || (c == 0 && a.size() < b.size());
+    }
+
+    inline std::ostream& operator<<(std::ostream& os, string_ref s)
+    {
+        return os.write(s.data(), s.size());
+    }
+
+}
+
+namespace std {
+
+    template <>
+    struct hash<ebt::string_ref> {
+        using argument_type = ebt::string_ref;
+        using result_type = size_t;
+
+        size_t operator()(ebt::string_ref s) const noexcept
+        {
+            return ebt::hash_bytes(s.data(), s.size());
+        }
+    };
+
+}
+
+#endif
@@ -0,0 +1,148 @@
+#include "ebt/symbol_table.h"
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+namespace ebt {
+
+    constexpr uint32_t symbol_table::npos;
+
+    char const* symbol_table::shard::store(string_ref s)
+    {
+        size_t const block_size = 64 * 1024;
+
+        if (s.size() > free_size) {
+            size_t size = std::max(block_size, s.size());
+            blocks.emplace_back(new char[size]);
+            free = blocks.back().get();
+            free_size = size;
+        }
+
+        char* result = free;
+        std::memcpy(result, s.data(), s.size());
+        free += s.size();
+        free_size -= s.size();
+
+        return result;
+    }
+
+    symbol_table::symbol_table()
+        : next_(0), size_(0)
+    {
+        for (auto& sh: shards_) {
+            sh.free = nullptr;
+            sh.free_size = 0;
+        }
+
+        for (auto& seg: segments_) {
+            seg.store(nullptr);
+        }
+    }
+
+    symbol_table::~symbol_table()
+    {
+        for (auto& seg: segments_) {
+            delete[] seg.load();
+        }
+    }
+
+    string_ref& symbol_table::slot(uint32_t id)
+    {
+        uint64_t i = uint64_t(id) + (1 << segment_base);
+        int k = 63 - __builtin_clzll(i);
+        std::atomic<string_ref*>& seg = segments_[k - segment_base];
+
+        string_ref* p = seg.load(std::memory_order_acquire);
+
+        if (p == nullptr) {
+            string_ref* fresh = new string_ref[uint64_t(1) << k];
+
+            if (seg.compare_exchange_strong(p, fresh, std::memory_order_acq_rel)) {
+                p = fresh;
+            } else {
+                delete[] fresh;
+            }
+        }
+
+        return p[i - (uint64_t(1) << k)];
+    }
+
+    symbol_table::shard& symbol_table::shard_of(string_ref s)
+    {
+        return shards_[hash_bytes(s.data(), s.size(), 0x5bd1e995) & ((1 << shard_bits) - 1)];
+    }
+
+    symbol_table::shard const& symbol_table::shard_of(string_ref s) const
+    {
+        return shards_[hash_bytes(s.data(), s.size(), 0x5bd1e995) & ((1 << shard_bits) - 1)];
+    }
+
+    uint32_t symbol_table::intern(string_ref s)
+    {
+        shard& sh = shard_of(s);
+        std::lock_guard<std::mutex> lock(sh.mutex);
+
+        uint32_t const* id = sh.ids.find(s);
+
+        if (id != nullptr) {
+            return *id;
+        }
+
+        string_ref stored(sh.store(s), s.size());
+
+        // Nothing between reserving the id and publishing it may throw,
+        // since an id that is never published would stall later ones.
+        // Touching the slot allocates its segment.
+        uint32_t result = next_.load(std::memory_order_relaxed);
+
+        do {
+            if (result == npos) {
+                throw std::length_error("symbol_table: out of ids");
+            }
+            slot(result);
+        } while (!next_.compare_exchange_weak(result, result + 1));
+
+        slot(result) = stored;
+
+        // Publish the id once every smaller id is published.  Their
+        // owners hold other shards and only have their slots left to
+        // write, so the wait is short.
+        while (size_.load(std::memory_order_acquire) != result) {
+            std::this_thread::yield();
+        }
+        size_.store(result + 1, std::memory_order_release);
+
+        sh.ids[stored] = result;
+
+        return result;
+    }
+
+    uint32_t symbol_table::find(string_ref s) const
+    {
+        shard const& sh = shard_of(s);
+        std::lock_guard<std::mutex> lock(sh.mutex);
+
+        uint32_t const* id = sh.ids.find(s);
+
+        return id == nullptr ? npos : *id;
+    }
+
+    string_ref symbol_table::str(uint32_t id) const
+    {
+        if (id >= size_.load(std::memory_order_acquire)) {
+            throw std::out_of_range("symbol_table: unknown id");
+        }
+
+        uint64_t i = uint64_t(id) + (1 << segment_base);
+        int k = 63 - __builtin_clzll(i);
+
+        return segments_[k - segment_base].load(std::memory_order_acquire)
+            [i - (uint64_t(1) << k)];
+    }
+
+    uint32_t symbol_table::size() const
+    {
+        return size_.load(std::memory_order_acquire);
+    }
+
+}
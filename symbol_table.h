@@ -0,0 +1,75 @@
+#ifndef EBT_SYMBOL_TABLE_H
+#define EBT_SYMBOL_TABLE_H
+
+#include "ebt/hashmap.h"
+#include "ebt/string_ref.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ebt {
+
+    // Interns strings and maps them to dense 32-bit ids, in the order
+    // they are first seen.  Each string is copied once into an arena
+    // owned by the table, so the views returned by str() stay valid for
+    // the lifetime of the table.
+    //
+    // intern, find and str may be called concurrently.
+    class symbol_table {
+    public:
+        static constexpr uint32_t npos = uint32_t(-1);
+
+        symbol_table();
+        ~symbol_table();
+
+        symbol_table(symbol_table const&) = delete;
+        symbol_table& operator=(symbol_table const&) = delete;
+
+        uint32_t intern(string_ref s);
+
+        // Returns the id of s, or npos if s has not been interned.
+        uint32_t find(string_ref s) const;
+
+        string_ref str(uint32_t id) const;
+
+        uint32_t size() const;
+
+    private:
+        static constexpr int shard_bits = 4;
+        static constexpr int segment_base = 8;
+        static constexpr int segment_count = 32 - segment_base + 1;
+
+        struct shard {
+            mutable std::mutex mutex;
+            hashmap<string_ref, uint32_t> ids;
+
+            std::vector<std::unique_ptr<char[]>> blocks;
+            char* free;
+            size_t free_size;
+
+            char const* store(string_ref s);
+        };
+
+        shard shards_[1 << shard_bits];
+
+        // The strings, indexed by id, in segments of doubling size so
+        // that the table can grow without moving existing entries.
+        std::atomic<string_ref*> segments_[segment_count];
+
+        // Ids are reserved from next_.  size_ counts the ids whose slots
+        // have been written and is raised in id order, so str() may read
+        // any id below it.
+        std::atomic<uint32_t> next_;
+        std::atomic<uint32_t> size_;
+
+        string_ref& slot(uint32_t id);
+
+        shard& shard_of(string_ref s);
+        shard const& shard_of(string_ref s) const;
+    };
+
+}
+
+#endif
@@ -0,0 +1,127 @@
+#include "ebt/assert.h"
+#include "ebt/functional.h"
+#include <list>
+#include <string>
+#include <vector>
+
+void test_chain()
+{
+    std::vector<int> a {1, 2};
+    std::vector<int> b {};
+    std::vector<int> c {3};
+
+    std::vector<int> result;
+    for (auto& e: ebt::chain(ebt::chain(a, b), ebt::make_range(c))) {
+        result.push_back(e);
+    }
+    ebt::assert_equals(true, result == std::vector<int>{1, 2, 3});
+
+    result.clear();
+    ebt::for_each(ebt::chain(b, a), [&](int i) { result.push_back(i); });
+    ebt::assert_equals(true, result == std::vector<int>{1, 2});
+}
+
+void test_flatten()
+{
+    std::vector<std::vector<std::string>> a {{"a", "aa"}, {}, {"b"}, {}};
+
+    std::vector<std::string> result;
+    for (auto& e: ebt::chain(a)) {
+        result.push_back(e);
+    }
+    ebt::assert_equals(true, result == std::vector<std::string>{"a", "aa", "b"});
+
+    std::vector<int> n {1, 0, 2};
+    auto c = ebt::chain(ebt::map(n, [](int i) {
+        return std::vector<std::string>(i, std::to_string(i));
+    }));
+
+    result.clear();
+    for (auto& e: c) {
+        result.push_back(e);
+    }
+    ebt::assert_equals(true, result == std::vector<std::string>{"1", "2", "2"});
+
+    // A copy taken part way through a container carries on from there,
+    // though the container it walks is the copy's own.
+    auto d = ebt::chain(ebt::map(n, [](int i) {
+        std::list<int> result;
+        for (int j = 0; j <= i; ++j) {
+            result.push_back(10 * i + j);
+        }
+        return result;
+    }));
+    for (int i = 0; i < 4; ++i) {
+        d.pop_front();
+    }
+    auto d2 = d;
+    d.pop_front();
+    ebt::assert_equals(21, d2.front());
+    ebt::assert_equals(22, d.front());
+
+    std::vector<int> ints;
+    for (auto& e: d2) {
+        ints.push_back(e);
+    }
+    ebt::assert_equals(true, ints == std::vector<int>{21, 22});
+}
+
+void test_batch()
+{
+    std::vector<int> a {1, 2, 3, 4, 5};
+
+    std::vector<size_t> sizes;
+    int sum = 0;
+    for (auto& s: ebt::batch(a, 2)) {
+        sizes.push_back(s.size());
+        for (auto v: s) {
+            sum += v;
+        }
+    }
+    ebt::assert_equals(true, sizes == std::vector<size_t>{2, 2, 1});
+    ebt::assert_equals(15, sum);
+    ebt::assert_equals(a.data(), ebt::batch(a, 2).front().data());
+
+    std::list<int> l {1, 2, 3};
+    auto b = ebt::batch(ebt::map(l, [](int i) { return i * 10; }), 2);
+    ebt::assert_equals(size_t(2), b.front().size());
+    ebt::assert_equals(20, b.front()[1]);
+    b.pop_front();
+    ebt::assert_equals(30, b.front()[0]);
+    b.pop_front();
+    ebt::assert_equals(true, b.empty());
+
+    // map copies the batch range, buffer and all.
+    std::list<int> l2 {1, 2, 3, 4, 5};
+    auto sums = ebt::map(ebt::batch(l2, 2), [](ebt::span<int const> s) {
+        int sum = 0;
+        for (auto v: s) {
+            sum += v;
+        }
+        return sum;
+    });
+    ebt::assert_equals(3, sums.front());
+
+    std::vector<int> all;
+    for (auto v: sums) {
+        all.push_back(v);
+    }
+    ebt::assert_equals(true, all == std::vector<int>{3, 7, 5});
+
+    auto c = ebt::batch(l2, 2);
+    auto c2 = c;
+    c.pop_front();
+    c = c2;
+    c2.pop_front();
+    ebt::assert_equals(1, c.front()[0]);
+    ebt::assert_equals(3, c2.front()[0]);
+}
+
+int main()
+{
+    test_chain();
+    test_flatten();
+    test_batch();
+
+    return 0;
+}
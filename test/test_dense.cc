@@ -0,0 +1,161 @@
+#include "ebt/assert.h"
+#include "ebt/dense.h"
+#include "ebt/bvector.h"
+#include "ebt/simd.h"
+#include <cmath>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+template <class T>
+std::vector<T> random_vector(std::mt19937& gen, size_t n)
+{
+    std::uniform_real_distribution<T> d { -1, 1 };
+    std::vector<T> result;
+    for (size_t i = 0; i < n; ++i) {
+        result.push_back(d(gen));
+    }
+    return result;
+}
+
+// Float results are checked to float precision.
+template <class T>
+void assert_close(double expected, double actual)
+{
+    double eps = (sizeof(T) == sizeof(float) ? 1e-6 : 1e-12);
+    ebt::assert_equals(expected, actual, eps * (1 + std::fabs(expected)));
+}
+
+// Every length up to 70 covers the AVX2, SSE2 and scalar tails.
+template <class T>
+void test_kernels()
+{
+    std::mt19937 gen { 1 };
+
+    for (size_t n = 0; n < 70; ++n) {
+        std::vector<T> x = random_vector<T>(gen, n);
+        std::vector<T> y = random_vector<T>(gen, n);
+
+        double dot = 0;
+        double l1 = 0;
+        double l2 = 0;
+        for (size_t i = 0; i < n; ++i) {
+            dot += double(x[i]) * y[i];
+            l1 += std::fabs(double(x[i]));
+            l2 += double(x[i]) * x[i];
+        }
+
+        assert_close<T>(dot, ebt::dense::dot(x.data(), y.data(), n));
+        assert_close<T>(l1, ebt::dense::norm1(x.data(), n));
+        assert_close<T>(std::sqrt(l2), ebt::dense::norm2(x.data(), n));
+
+        std::vector<T> z = y;
+        ebt::dense::axpy(T(0.5), x.data(), z.data(), n);
+        for (size_t i = 0; i < n; ++i) {
+            assert_close<T>(T(y[i] + T(0.5) * x[i]), z[i]);
+        }
+
+        z = x;
+        ebt::dense::scale(T(3), z.data(), n);
+        for (size_t i = 0; i < n; ++i) {
+            ebt::assert_equals(T(3 * x[i]), z[i]);
+        }
+
+        std::vector<T> out(n);
+        ebt::dense::add(x.data(), y.data(), out.data(), n);
+        for (size_t i = 0; i < n; ++i) {
+            ebt::assert_equals(T(x[i] + y[i]), out[i]);
+        }
+
+        ebt::dense::sub(x.data(), y.data(), out.data(), n);
+        for (size_t i = 0; i < n; ++i) {
+            ebt::assert_equals(T(x[i] - y[i]), out[i]);
+        }
+
+        z = x;
+        ebt::dense::mul(z.data(), y.data(), z.data(), n);
+        for (size_t i = 0; i < n; ++i) {
+            ebt::assert_equals(T(x[i] * y[i]), z[i]);
+        }
+    }
+}
+
+void test_bvector_dot()
+{
+    std::vector<double> a { 1, 2, 3 };
+    std::vector<double> b { 4, 5 };
+    std::vector<int> c { 1, 2 };
+
+    ebt::assert_equals(14.0, ebt::dot(ebt::make_bvector(std::vector<double>(a)),
+        ebt::make_bvector(std::vector<double>(b))));
+    ebt::assert_equals(14.0, ebt::dot(ebt::bvector<std::vector<double> const&> { b },
+        ebt::bvector<std::vector<double> const&> { a }));
+    ebt::assert_equals(5.0, ebt::dot(ebt::make_bvector(std::vector<int>(c)),
+        ebt::make_bvector(std::vector<int>(c))));
+
+    std::tuple<std::vector<double>, std::vector<float>> t { a, {1, 2} };
+    ebt::assert_equals(19.0, ebt::dot(ebt::make_bvector(std::move(t)),
+        ebt::make_bvector(std::tuple<std::vector<double>, std::vector<float>> { a, {1, 2} })));
+
+    std::tuple<std::vector<double>> u { b };
+    ebt::assert_equals(41.0, ebt::dot(ebt::make_bvector(std::move(u)),
+        ebt::make_bvector(std::tuple<std::vector<double>> { b })));
+}
+
+// The smaller map drives the loop, and its keys must be in the other.
+template <class T>
+void test_bvector_map_dot()
+{
+    using map = std::unordered_map<std::string, std::vector<T>>;
+
+    map a { {"x", {1, 2, 3}}, {"y", {4}} };
+    map b { {"x", {1, 1, 1, 5}}, {"y", {2, 7}}, {"z", {9}} };
+
+    ebt::assert_equals(14.0, ebt::dot(ebt::make_bvector(map(a)), ebt::make_bvector(map(b))));
+    ebt::assert_equals(14.0, ebt::dot(ebt::make_bvector(map(b)), ebt::make_bvector(map(a))));
+    ebt::assert_equals(14.0, ebt::dot(ebt::bvector<map const&> { b },
+        ebt::bvector<map const&> { a }));
+
+    // Long enough for the vector kernels to do most of the work.
+    std::mt19937 gen { 3 };
+    std::vector<T> u;
+    std::vector<T> v;
+    for (int i = 0; i < 67; ++i) {
+        u.push_back(T(gen() % 16));
+        v.push_back(T(gen() % 16));
+    }
+
+    double expected = 0;
+    for (size_t i = 0; i < u.size(); ++i) {
+        expected += u[i] * v[i];
+    }
+
+    map c { {"u", u} };
+    map d { {"u", v}, {"x", u} };
+    ebt::assert_equals(expected, ebt::dot(ebt::bvector<map const&> { c },
+        ebt::bvector<map const&> { d }));
+    ebt::assert_equals(expected, ebt::dot(ebt::make_bvector(map(d)), ebt::make_bvector(map(c))));
+}
+
+int main()
+{
+    // Once with the widest kernels the CPU has, and once with dispatch
+    // held to SSE2.
+    ebt::simd_level const levels[] = { ebt::simd_level::avx2, ebt::simd_level::sse2 };
+
+    for (auto level: levels) {
+        ebt::set_max_simd_level(level);
+
+        test_kernels<float>();
+        test_kernels<double>();
+        test_bvector_dot();
+        test_bvector_map_dot<float>();
+        test_bvector_map_dot<double>();
+        test_bvector_map_dot<int>();
+    }
+
+    ebt::set_max_simd_level(ebt::simd_level::avx2);
+
+    return 0;
+}
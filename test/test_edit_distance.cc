@@ -0,0 +1,139 @@
+#include "ebt/assert.h"
+#include "ebt/edit_distance.h"
+#include "ebt/utf8.h"
+#include "ebt/vector.h"
+#include <random>
+#include <string>
+#include <vector>
+
+size_t naive_edit_distance(std::vector<int> const& a, std::vector<int> const& b)
+{
+    std::vector<size_t> d(b.size() + 1);
+    for (size_t j = 0; j <= b.size(); ++j) {
+        d[j] = j;
+    }
+
+    for (size_t i = 1; i <= a.size(); ++i) {
+        size_t diag = d[0];
+        d[0] = i;
+
+        for (size_t j = 1; j <= b.size(); ++j) {
+            size_t up = d[j];
+            d[j] = std::min(std::min(up, d[j - 1]) + 1,
+                diag + (a[i - 1] == b[j - 1] ? 0 : 1));
+            diag = up;
+        }
+    }
+
+    return d[b.size()];
+}
+
+std::vector<int> random_sequence(std::mt19937& gen, size_t size, int symbols)
+{
+    std::uniform_int_distribution<int> dist(0, symbols - 1);
+    std::vector<int> result;
+    for (size_t i = 0; i < size; ++i) {
+        result.push_back(dist(gen));
+    }
+    return result;
+}
+
+void test_edit_distance()
+{
+    std::vector<int> a {1, 2, 3, 4};
+    std::vector<int> b {1, 3, 4, 5};
+    ebt::assert_equals(size_t(2), ebt::edit_distance(a, b));
+    ebt::assert_equals(size_t(4), ebt::edit_distance(a, std::vector<int>{}));
+    ebt::assert_equals(size_t(0), ebt::edit_distance(a, a));
+
+    std::mt19937 gen(1);
+    for (size_t n: {1, 5, 63, 64, 65, 127, 128, 200}) {
+        for (size_t m: {0, 1, 30, 64, 70, 150}) {
+            for (int symbols: {2, 4, 50}) {
+                std::vector<int> x = random_sequence(gen, n, symbols);
+                std::vector<int> y = random_sequence(gen, m, symbols);
+                ebt::assert_equals(naive_edit_distance(x, y), ebt::edit_distance(x, y));
+                ebt::assert_equals(naive_edit_distance(x, y), ebt::edit_distance(y, x));
+            }
+        }
+    }
+}
+
+void test_codepoints()
+{
+    std::string s1 = "kitten \xe4\xb8\xad";
+    std::string s2 = "sitting \xe4\xb8\xad";
+    std::vector<char32_t> a(s1.size());
+    std::vector<char32_t> b(s2.size());
+    a.resize(ebt::decode_utf8(s1, a.data()));
+    b.resize(ebt::decode_utf8(s2, b.data()));
+    ebt::assert_equals(size_t(3), ebt::edit_distance(a, b));
+}
+
+void test_align()
+{
+    std::mt19937 gen(2);
+    for (size_t n: {0, 3, 40, 100}) {
+        for (size_t m: {0, 5, 90}) {
+            std::vector<int> x = random_sequence(gen, n, 3);
+            std::vector<int> y = random_sequence(gen, m, 3);
+            ebt::alignment r = ebt::align(x, y);
+            ebt::assert_equals(naive_edit_distance(x, y), r.distance);
+
+            std::vector<int> out;
+            size_t i = 0;
+            size_t j = 0;
+            size_t cost = 0;
+            for (auto op: r.ops) {
+                switch (op) {
+                case ebt::edit_op::match:
+                    ebt::assert_equals(x[i], y[j]);
+                    out.push_back(x[i++]);
+                    ++j;
+                    break;
+                case ebt::edit_op::substitution:
+                    out.push_back(y[j++]);
+                    ++i;
+                    ++cost;
+                    break;
+                case ebt::edit_op::insertion:
+                    out.push_back(y[j++]);
+                    ++cost;
+                    break;
+                case ebt::edit_op::deletion:
+                    ++i;
+                    ++cost;
+                    break;
+                }
+            }
+            ebt::assert_equals(n, i);
+            ebt::assert_equals(y, out);
+            ebt::assert_equals(r.distance, cost);
+        }
+    }
+}
+
+void test_batch()
+{
+    std::mt19937 gen(3);
+    std::vector<std::pair<std::vector<int>, std::vector<int>>> pairs;
+    for (int i = 0; i < 50; ++i) {
+        pairs.emplace_back(random_sequence(gen, i * 3, 5),
+            random_sequence(gen, 100 - i, 5));
+    }
+
+    std::vector<size_t> d = ebt::edit_distance(pairs, 4);
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        ebt::assert_equals(naive_edit_distance(pairs[i].first, pairs[i].second), d[i]);
+    }
+}
+
+int main()
+{
+    test_edit_distance();
+    test_codepoints();
+    test_align();
+    test_batch();
+
+    return 0;
+}
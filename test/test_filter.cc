@@ -0,0 +1,83 @@
+#include "ebt/assert.h"
+#include "ebt/functional.h"
+#include <string>
+#include <vector>
+
+void test_filter()
+{
+    std::vector<int> a {0, 1, 2, 3, 4, 5};
+
+    std::vector<int> result;
+    for (auto& e: ebt::filter(a, [](int i) { return i % 2 == 0; })) {
+        result.push_back(e);
+    }
+
+    ebt::assert_equals(true, result == std::vector<int>{0, 2, 4});
+    ebt::assert_equals(true, ebt::filter(a, [](int i) { return i > 5; }).empty());
+}
+
+void test_filter_map()
+{
+    std::vector<std::string> a {"a", "aa", "aaa", "aaaa"};
+
+    std::vector<size_t> result;
+    for (auto e: ebt::filter(ebt::map(a,
+            [](std::string const& s) { return s.size(); }),
+            [](size_t i) { return i % 2 == 0; })) {
+        result.push_back(e);
+    }
+
+    ebt::assert_equals(true, result == std::vector<size_t>{2, 4});
+}
+
+void test_map_reference()
+{
+    std::vector<std::pair<int, std::string>> a {{1, "a"}, {2, "b"}};
+
+    auto r = ebt::map(a, [](std::pair<int, std::string> const& p)
+        -> std::string const& { return p.second; });
+
+    ebt::assert_equals(&a[0].second, &r.front());
+    r.pop_front();
+    ebt::assert_equals(std::string("b"), r.front());
+}
+
+void test_for_each()
+{
+    std::vector<double> x {1, 2, 3, 4};
+    std::vector<double> y {10, 20, 30, 40};
+
+    auto pipeline = ebt::map(
+        ebt::filter(ebt::zip(x, y),
+            [](std::tuple<double const&, double const&> const& t) {
+                return std::get<0>(t) != 2;
+            }),
+        [](std::tuple<double const&, double const&> const& t) {
+            return std::get<0>(t) * std::get<1>(t);
+        });
+
+    double pushed = 0;
+    ebt::for_each(pipeline, [&](double v) { pushed += v; });
+
+    double pulled = 0;
+    for (auto v: pipeline) {
+        pulled += v;
+    }
+
+    ebt::assert_equals(260.0, pushed);
+    ebt::assert_equals(pushed, pulled);
+
+    int count = 0;
+    ebt::for_each(ebt::make_range(x), [&](double) { ++count; });
+    ebt::assert_equals(4, count);
+}
+
+int main()
+{
+    test_filter();
+    test_filter_map();
+    test_map_reference();
+    test_for_each();
+
+    return 0;
+}
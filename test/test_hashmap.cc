@@ -62,10 +62,59 @@ void test_insert_and_search()
     }
 }
 
+void test_erase_and_iterate()
+{
+    ebt::hashmap<int, int> map;
+
+    for (int i = 0; i < 1000; ++i) {
+        map[i] = i * 2;
+    }
+
+    for (int i = 0; i < 1000; i += 2) {
+        map.erase(i);
+    }
+
+    if (map.size() != 500) {
+        std::cout << "size should be 500" << std::endl;
+        exit(1);
+    }
+
+    long sum = 0;
+    for (auto& p: map) {
+        if (p.first % 2 != 1 || p.second != p.first * 2) {
+            std::cout << "unexpected entry " << p.first << std::endl;
+            exit(1);
+        }
+        sum += p.first;
+    }
+
+    if (sum != 250000) {
+        std::cout << "iteration missed entries" << std::endl;
+        exit(1);
+    }
+
+    for (int i = 0; i < 1000; ++i) {
+        if (map.in(i) != (i % 2 == 1)) {
+            std::cout << "search after erase failed at " << i << std::endl;
+            exit(1);
+        }
+    }
+
+    for (int i = 1; i < 1000; i += 2) {
+        map.erase(i);
+    }
+
+    if (map.size() != 0 || map.begin() != map.end()) {
+        std::cout << "map should be empty" << std::endl;
+        exit(1);
+    }
+}
+
 int main()
 {
     test_simple();
     test_insert_and_search();
+    test_erase_and_iterate();
 
     return 0;
 }
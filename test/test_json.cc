@@ -1,6 +1,14 @@
 #include <sstream>
 #include "ebt/ebt.h"
 
+struct point {
+    int x;
+    double y;
+    std::vector<std::string> labels;
+};
+
+EBT_FIELDS(point, x, y, labels)
+
 void test_parse_empty_string()
 {
     std::string s = "\"\"";
@@ -92,6 +100,108 @@ void test_dump_vector_of_int()
     ebt::assert_equals(std::string("[1, 2, 3]"), oss.str());
 }
 
+void test_try_load_vector_of_int()
+{
+    std::string s = "[1, 2, 3]";
+    std::istringstream iss(s);
+    std::vector<int> result;
+    ebt::json::parse_status status = ebt::json::try_load(iss, result);
+    ebt::assert_equals(true, bool(status));
+    ebt::assert_equals(std::vector<int>{1, 2, 3}, result);
+}
+
+void test_try_load_error_offset()
+{
+    std::string s = "[1, 2; 3]";
+    std::istringstream iss(s);
+    std::vector<int> result;
+    ebt::json::parse_status status = ebt::json::try_load(iss, result);
+    ebt::assert_equals(false, bool(status));
+    ebt::assert_equals(int(ebt::json::parse_error::unexpected_char), int(status.error));
+    ebt::assert_equals(5, int(status.offset));
+    ebt::assert_equals(int(']'), status.expected);
+    ebt::assert_equals(int(';'), status.actual);
+}
+
+void test_try_load_invalid_number()
+{
+    std::string s = "[1, x]";
+    std::istringstream iss(s);
+    std::vector<double> result;
+    ebt::json::parse_status status = ebt::json::try_load(iss, result);
+    ebt::assert_equals(int(ebt::json::parse_error::invalid_number), int(status.error));
+    ebt::assert_equals(4, int(status.offset));
+}
+
+void test_try_load_unterminated_string()
+{
+    std::string s = "\"abc";
+    std::istringstream iss(s);
+    std::string result;
+    ebt::json::parse_status status = ebt::json::try_load(iss, result);
+    ebt::assert_equals(int(ebt::json::parse_error::unexpected_char), int(status.error));
+}
+
+void test_try_load_string_replaces()
+{
+    std::string s = "\"abc\"";
+    std::istringstream iss(s);
+    std::string result = "xyz";
+    ebt::json::parse_status status = ebt::json::try_load(iss, result);
+    ebt::assert_equals(true, bool(status));
+    ebt::assert_equals(std::string("abc"), result);
+}
+
+void test_load_throws()
+{
+    std::string s = "{\"a\" 1}";
+    std::istringstream iss(s);
+    bool thrown = false;
+    try {
+        ebt::json::load<std::unordered_map<std::string, int>>(iss);
+    } catch (ebt::parser_exception const& e) {
+        thrown = true;
+    }
+    ebt::assert_equals(true, thrown);
+}
+
+void test_parse_tuple()
+{
+    std::string s = "(1, \"a\", 2.5)";
+    std::istringstream iss(s);
+    auto result = ebt::json::load<std::tuple<int, std::string, double>>(iss);
+    ebt::assert_equals(1, std::get<0>(result));
+    ebt::assert_equals(std::string("a"), std::get<1>(result));
+    ebt::assert_equals(2.5, std::get<2>(result));
+}
+
+void test_dump_fields()
+{
+    std::ostringstream oss;
+    point p { 1, 2.5, {"a"} };
+    ebt::json::dump(p, oss);
+    ebt::assert_equals(std::string("{\"x\": 1, \"y\": 2.5, \"labels\": [\"a\"]}"), oss.str());
+}
+
+void test_parse_fields()
+{
+    std::string s = "{\"labels\": [\"a\", \"b\"], \"y\": 2.5 , \"x\": 1}";
+    std::istringstream iss(s);
+    point p = ebt::json::load<point>(iss);
+    ebt::assert_equals(1, p.x);
+    ebt::assert_equals(2.5, p.y);
+    ebt::assert_equals(std::vector<std::string>{"a", "b"}, p.labels);
+}
+
+void test_parse_unknown_field()
+{
+    std::string s = "{\"x\": 1, \"z\": 2}";
+    std::istringstream iss(s);
+    point p;
+    ebt::json::parse_status status = ebt::json::try_load(iss, p);
+    ebt::assert_equals(int(ebt::json::parse_error::unknown_field), int(status.error));
+}
+
 int main()
 {
     test_parse_empty_string();
@@ -105,5 +215,17 @@ int main()
 
     test_dump_vector_of_int();
 
+    test_try_load_vector_of_int();
+    test_try_load_error_offset();
+    test_try_load_invalid_number();
+    test_try_load_unterminated_string();
+    test_try_load_string_replaces();
+    test_load_throws();
+    test_parse_tuple();
+
+    test_dump_fields();
+    test_parse_fields();
+    test_parse_unknown_field();
+
     return 0;
 }
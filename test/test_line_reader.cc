@@ -0,0 +1,191 @@
+#include "ebt/assert.h"
+#include "ebt/line_reader.h"
+#include "ebt/vector.h"
+#include <atomic>
+#include <cstdio>
+#include <unistd.h>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+std::string write_temp(std::string const& contents)
+{
+    char path[] = "/tmp/test_line_reader.XXXXXX";
+    int fd = mkstemp(path);
+    close(fd);
+
+    std::ofstream ofs(path);
+    ofs << contents;
+
+    return path;
+}
+
+void test_lines()
+{
+    std::string path = write_temp("a b\n\nc d e\nf");
+    ebt::line_reader reader(path);
+
+    std::vector<std::string> lines;
+    for (auto& line: reader.lines()) {
+        lines.push_back(line.str());
+    }
+    ebt::assert_equals(std::vector<std::string>{"a b", "", "c d e", "f"}, lines);
+
+    std::vector<std::string> tokens;
+    for (auto& t: reader.tokens()) {
+        tokens.push_back(t.str());
+    }
+    ebt::assert_equals(std::vector<std::string>{"a", "b", "c", "d", "e", "f"}, tokens);
+
+    std::remove(path.c_str());
+}
+
+void test_empty_file()
+{
+    std::string path = write_temp("");
+    ebt::line_reader reader(path);
+
+    // An empty file has nothing to map and is streamed.
+    ebt::assert_equals(true, reader.lines().empty());
+
+    int chunks = 0;
+    reader.for_each_chunk(4, [&](ebt::string_ref) { ++chunks; });
+    ebt::assert_equals(0, chunks);
+
+    std::remove(path.c_str());
+}
+
+void test_chunks()
+{
+    std::string contents;
+    for (int i = 0; i < 1000; ++i) {
+        contents += std::to_string(i) + "\n";
+    }
+    std::string path = write_temp(contents);
+    ebt::line_reader reader(path);
+
+    auto chunks = reader.chunks(7);
+    ebt::assert_equals(7, int(chunks.size()));
+
+    std::string joined;
+    for (auto& c: chunks) {
+        ebt::assert_equals('\n', c[c.size() - 1]);
+        joined += c.str();
+    }
+    ebt::assert_equals(contents, joined);
+
+    std::atomic<int> sum(0);
+    reader.for_each_line(4, [&](ebt::string_ref line) {
+        sum += std::stoi(line.str());
+    });
+    ebt::assert_equals(999 * 1000 / 2, sum.load());
+
+    std::remove(path.c_str());
+}
+
+// Writes contents into a pipe from another thread.  The reader opens the
+// read end as /dev/fd/n, which cannot be mapped.
+struct pipe_input {
+    int fds[2];
+    std::string path;
+    std::thread writer;
+
+    explicit pipe_input(std::string const& contents)
+    {
+        ebt::assert_equals(0, pipe(fds));
+        path = "/dev/fd/" + std::to_string(fds[0]);
+
+        int out = fds[1];
+        writer = std::thread([=]() {
+            size_t i = 0;
+            while (i < contents.size()) {
+                ssize_t n = write(out, contents.data() + i,
+                    std::min<size_t>(contents.size() - i, 1000));
+                i += (n > 0 ? n : 0);
+            }
+            close(out);
+        });
+    }
+
+    ~pipe_input()
+    {
+        writer.join();
+        close(fds[0]);
+    }
+};
+
+void test_streamed_lines()
+{
+    std::string contents;
+    std::vector<std::string> expected;
+    for (int i = 0; i < 2000; ++i) {
+        expected.push_back(std::string(i % 300, 'a' + i % 26) + " " + std::to_string(i));
+        contents += expected.back() + "\n";
+    }
+    contents += "last";
+    expected.push_back("last");
+
+    pipe_input input { contents };
+    ebt::line_reader reader { input.path, 64 };
+    ebt::assert_equals(false, reader.mapped());
+
+    bool thrown = false;
+    try {
+        reader.contents();
+    } catch (std::logic_error const& e) {
+        thrown = true;
+    }
+    ebt::assert_equals(true, thrown);
+
+    std::vector<std::string> lines;
+    for (auto& line: reader.lines()) {
+        lines.push_back(line.str());
+    }
+    ebt::assert_equals(expected, lines);
+}
+
+void test_streamed_tokens()
+{
+    pipe_input input { "a bb\n\nccc d\n  e" };
+    ebt::line_reader reader { input.path, 4 };
+
+    std::vector<std::string> tokens;
+    for (auto& t: reader.tokens()) {
+        tokens.push_back(t.str());
+    }
+    ebt::assert_equals(std::vector<std::string>{"a", "bb", "ccc", "d", "e"}, tokens);
+}
+
+void test_streamed_for_each_line()
+{
+    std::string contents;
+    for (int i = 0; i < 100000; ++i) {
+        contents += std::to_string(i) + "\n";
+    }
+
+    pipe_input input { contents };
+    ebt::line_reader reader { input.path, 4096 };
+
+    std::atomic<long> sum(0);
+    std::atomic<int> count(0);
+    reader.for_each_line(4, [&](ebt::string_ref line) {
+        sum += std::stol(line.str());
+        ++count;
+    });
+    ebt::assert_equals(100000, count.load());
+    ebt::assert_equals(99999L * 100000 / 2, sum.load());
+}
+
+int main()
+{
+    test_lines();
+    test_empty_file();
+    test_chunks();
+    test_streamed_lines();
+    test_streamed_tokens();
+    test_streamed_for_each_line();
+
+    return 0;
+}
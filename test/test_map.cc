@@ -26,10 +26,48 @@ void test_map_iterator()
     }
 }
 
+void test_map_random_access()
+{
+    std::vector<std::string> vec = {"a", "aa", "aaa"};
+    auto r = ebt::map(vec, [](std::string const& s) { return s.size(); });
+    static_assert(ebt::is_random_access_range<decltype(r)>::value, "");
+
+    ebt::assert_equals(3, r.size());
+    ebt::assert_equals(3, r[2]);
+    ebt::assert_equals(1, r.front());
+
+    r.pop_front();
+    ebt::assert_equals(2, r.size());
+    ebt::assert_equals(3, r[1]);
+    ebt::assert_equals(2, r.front());
+
+    auto z = ebt::zip(vec, vec);
+    static_assert(ebt::is_random_access_range<decltype(z)>::value, "");
+    auto m = ebt::map(z, [](std::tuple<std::string const&, std::string const&> const& t) {
+        return std::get<0>(t) + std::get<1>(t);
+    });
+    ebt::assert_equals(std::string("aaaa"), m[1]);
+
+    std::string const& m0 = m[0];
+    std::string const& m2 = m[2];
+    ebt::assert_equals(std::string("aa"), m0);
+    ebt::assert_equals(std::string("aaaaaa"), m2);
+
+    int count = 0;
+    for (auto c: ebt::chunk(m, 2)) {
+        for (auto& s: c) {
+            ebt::assert_equals(vec[count] + vec[count], s);
+            ++count;
+        }
+    }
+    ebt::assert_equals(3, count);
+}
+
 int main()
 {
     test_map();
     test_map_iterator();
+    test_map_random_access();
 
     return 0;
 }
@@ -0,0 +1,200 @@
+#include "ebt/assert.h"
+#include "ebt/math_util.h"
+#include "ebt/simd.h"
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+double const inf = std::numeric_limits<double>::infinity();
+
+void test_fast_exp()
+{
+    for (double x = -708; x < 709.7; x += 0.01) {
+        double e = std::exp(x);
+        ebt::assert_equals(e, ebt::fast_exp(x), 5e-16 * e);
+    }
+
+    ebt::assert_equals(1.0, ebt::fast_exp(0));
+    ebt::assert_equals(0.0, ebt::fast_exp(-inf));
+    ebt::assert_equals(0.0, ebt::fast_exp(-710));
+    ebt::assert_equals(inf, ebt::fast_exp(710));
+    ebt::assert_equals(inf, ebt::fast_exp(inf));
+}
+
+void test_fast_log()
+{
+    for (double x = 1e-300; x < 1e300; x *= 1.01) {
+        double e = std::log(x);
+        ebt::assert_equals(e, ebt::fast_log(x), 2e-15 * std::fabs(e));
+    }
+
+    for (double x = 0.5; x < 2; x += 1e-4) {
+        double e = std::log(x);
+        ebt::assert_equals(e, ebt::fast_log(x), 2e-15 * std::fabs(e));
+    }
+
+    ebt::assert_equals(0.0, ebt::fast_log(1));
+    ebt::assert_equals(-inf, ebt::fast_log(0));
+    ebt::assert_equals(inf, ebt::fast_log(inf));
+    ebt::assert_equals(std::log(4e-320), ebt::fast_log(4e-320), 1e-12);
+    ebt::assert_equals(true, std::isnan(ebt::fast_log(-1)));
+}
+
+void test_fast_exp_span()
+{
+    std::vector<double> x;
+    for (double v = -720; v < 720; v += 0.37) {
+        x.push_back(v);
+    }
+    x.push_back(-inf);
+    x.push_back(inf);
+
+    std::vector<double> out(x.size());
+    ebt::fast_exp(x, out);
+
+    for (size_t i = 0; i < x.size(); ++i) {
+        ebt::assert_equals(ebt::fast_exp(x[i]), out[i], 5e-16 * out[i]);
+    }
+
+    ebt::fast_exp(x, x);
+    ebt::assert_equals(out[100], x[100]);
+}
+
+// Every length up to 40 covers the AVX2, SSE2 and scalar tails.
+void test_log_sum_exp()
+{
+    std::mt19937 gen { 1 };
+    std::uniform_real_distribution<double> d { -50, 50 };
+
+    for (size_t n = 0; n < 40; ++n) {
+        std::vector<double> x;
+        for (size_t i = 0; i < n; ++i) {
+            x.push_back(i % 7 == 3 ? -inf : d(gen));
+        }
+
+        double m = -inf;
+        for (auto v: x) {
+            m = std::max(m, v);
+        }
+        double sum = 0;
+        for (auto v: x) {
+            sum += std::exp(v - m);
+        }
+        double expected = (m == -inf ? -inf : m + std::log(sum));
+
+        ebt::assert_equals(expected, ebt::log_sum_exp(x), 1e-13);
+
+        if (m == -inf) {
+            continue;
+        }
+
+        std::vector<double> p(n);
+        ebt::softmax(x, p);
+        std::vector<double> lp(n);
+        ebt::log_softmax(x, lp);
+
+        double total = 0;
+        for (size_t i = 0; i < n; ++i) {
+            total += p[i];
+            ebt::assert_equals(std::exp(x[i] - expected), p[i], 1e-13);
+            if (x[i] != -inf) {
+                ebt::assert_equals(x[i] - expected, lp[i], 1e-13);
+            }
+        }
+        ebt::assert_equals(1.0, total, 1e-14);
+    }
+
+    std::vector<double> all { -inf, -inf };
+    ebt::assert_equals(-inf, ebt::log_sum_exp(all));
+}
+
+void test_log_add()
+{
+    std::mt19937 gen { 2 };
+    std::uniform_real_distribution<double> d { -800, 50 };
+
+    std::vector<double> x;
+    std::vector<double> y;
+    for (int i = 0; i < 1000; ++i) {
+        x.push_back(d(gen));
+        y.push_back(i % 3 == 0 ? x.back() + d(gen) / 100 : d(gen));
+    }
+
+    double const special[] = { -inf, inf, 0, -inf, -inf, 5, inf, inf };
+    for (int i = 0; i < 4; ++i) {
+        x.push_back(special[2 * i]);
+        y.push_back(special[2 * i + 1]);
+    }
+
+    std::vector<double> out(x.size());
+    ebt::log_add(x, y, out);
+
+    for (size_t i = 0; i < x.size(); ++i) {
+        double m = std::max(x[i], y[i]);
+        double expected = (std::min(x[i], y[i]) == -inf || m == inf)
+            ? m : ebt::log_add(x[i], y[i]);
+        ebt::assert_equals(expected, out[i], 1e-13 * std::max(1.0, std::fabs(expected)));
+    }
+
+    ebt::log_add(x, y, x);
+    ebt::assert_equals(out[7], x[7]);
+}
+
+// A NaN at any position of any length, so that it lands in each of the
+// vector kernels and the scalar tail, on either path.
+void test_nan()
+{
+    double const nan = std::numeric_limits<double>::quiet_NaN();
+
+    ebt::simd_level const levels[] = { ebt::simd_level::avx2, ebt::simd_level::sse2 };
+
+    for (auto level: levels) {
+        ebt::set_max_simd_level(level);
+
+        for (size_t n = 1; n < 40; ++n) {
+            for (size_t k = 0; k < n; ++k) {
+                std::vector<double> x(n);
+                std::vector<double> y(n);
+                for (size_t i = 0; i < n; ++i) {
+                    x[i] = double(i % 5) - 2;
+                    y[i] = -double(i % 3);
+                }
+                x[k] = nan;
+
+                double z = ebt::log_sum_exp(x);
+                ebt::assert_equals(true, z != z);
+
+                std::vector<double> out(n);
+                ebt::fast_exp(x, out);
+                for (size_t i = 0; i < n; ++i) {
+                    ebt::assert_equals(i == k, out[i] != out[i]);
+                }
+
+                ebt::log_add(x, y, out);
+                for (size_t i = 0; i < n; ++i) {
+                    ebt::assert_equals(i == k, out[i] != out[i]);
+                }
+
+                ebt::log_add(y, x, out);
+                for (size_t i = 0; i < n; ++i) {
+                    ebt::assert_equals(i == k, out[i] != out[i]);
+                }
+            }
+        }
+    }
+
+    ebt::set_max_simd_level(ebt::simd_level::avx2);
+}
+
+int main()
+{
+    test_fast_exp();
+    test_fast_log();
+    test_fast_exp_span();
+    test_log_sum_exp();
+    test_log_add();
+    test_nan();
+
+    return 0;
+}
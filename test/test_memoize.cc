@@ -0,0 +1,134 @@
+#include "ebt/assert.h"
+#include "ebt/memoize.h"
+#include "ebt/thread_pool.h"
+#include <string>
+#include <thread>
+#include <vector>
+
+void test_clock_cache()
+{
+    ebt::clock_cache<int, std::string> cache { 2 };
+
+    cache.insert(1, "a");
+    cache.insert(2, "b");
+    ebt::assert_equals(std::string("a"), *cache.find(1));
+
+    // 1 was looked up, so 2 goes first.
+    cache.insert(3, "c");
+    ebt::assert_equals(true, cache.find(2) == nullptr);
+    ebt::assert_equals(std::string("a"), *cache.find(1));
+    ebt::assert_equals(std::string("c"), *cache.find(3));
+    ebt::assert_equals(size_t(2), cache.size());
+
+    for (int i = 10; i < 1000; ++i) {
+        cache.insert(i, std::to_string(i));
+        ebt::assert_equals(std::to_string(i), *cache.find(i));
+    }
+    ebt::assert_equals(size_t(2), cache.size());
+}
+
+void test_memoize()
+{
+    int calls = 0;
+    auto f = ebt::memoize([&](int i) { ++calls; return i * i; }, 4);
+
+    for (int k = 0; k < 3; ++k) {
+        for (int i = 0; i < 4; ++i) {
+            ebt::assert_equals(i * i, f(i));
+        }
+    }
+
+    ebt::assert_equals(4, calls);
+    ebt::assert_equals(uint64_t(8), f.hits());
+    ebt::assert_equals(uint64_t(4), f.misses());
+
+    for (int i = 100; i < 200; ++i) {
+        f(i);
+    }
+    ebt::assert_equals(size_t(4), f.size());
+    ebt::assert_equals(199 * 199, f(199));
+}
+
+void test_memoize_result_outlives_eviction()
+{
+    auto f = ebt::memoize([](int i) { return std::string(100, 'a' + i); }, 1);
+
+    std::string const& a = f(0);
+    std::string const& b = f(1);
+
+    ebt::assert_equals(std::string(100, 'a'), a);
+    ebt::assert_equals(std::string(100, 'b'), b);
+}
+
+void test_cached_map()
+{
+    std::vector<std::string> words {"a", "bb", "a", "bb", "ccc", "a"};
+
+    int calls = 0;
+    auto r = ebt::cached_map(words, [&](std::string const& s) {
+        ++calls;
+        return s + s;
+    }, 8, 1);
+
+    std::vector<std::string> result;
+    for (auto& e: r) {
+        result.push_back(e);
+    }
+
+    ebt::assert_equals(3, calls);
+    ebt::assert_equals(std::string("aa"), result[2]);
+    ebt::assert_equals(std::string("cccccc"), result[4]);
+}
+
+void test_parallel_cached_map()
+{
+    std::vector<int> v;
+    for (int i = 0; i < 10000; ++i) {
+        v.push_back(i % 50);
+    }
+
+    ebt::thread_pool pool { 4 };
+    std::vector<int> result = ebt::parallel_map(pool,
+        ebt::cached_map(v, [](int i) { return i * i; }, 16),
+        [](int i) { return i + 1; }, 1);
+
+    for (int i = 0; i < 10000; ++i) {
+        ebt::assert_equals((i % 50) * (i % 50) + 1, result[i]);
+    }
+}
+
+void test_sharded_memoize()
+{
+    std::atomic<int> calls { 0 };
+    auto f = ebt::sharded_memoize([&](int i) { ++calls; return i + 1; }, 1024);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&]() {
+            for (int k = 0; k < 10; ++k) {
+                for (int i = 0; i < 100; ++i) {
+                    ebt::assert_equals(i + 1, f(i));
+                }
+            }
+        });
+    }
+
+    for (auto& t: threads) {
+        t.join();
+    }
+
+    ebt::assert_equals(uint64_t(4000), f.hits() + f.misses());
+    ebt::assert_equals(true, calls.load() >= 100 && calls.load() <= 400);
+}
+
+int main()
+{
+    test_clock_cache();
+    test_memoize();
+    test_memoize_result_outlives_eviction();
+    test_cached_map();
+    test_parallel_cached_map();
+    test_sharded_memoize();
+
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include "ebt/assert.h"
+#include "ebt/ngram.h"
+#include "ebt/hashmap.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+void test_ngram_view()
+{
+    std::vector<int> seq {1, 2, 3, 4};
+
+    std::vector<std::vector<int>> grams;
+    for (auto& g: ebt::ngram_view(seq, 2)) {
+        grams.push_back(std::vector<int>(g.begin(), g.end()));
+    }
+    ebt::assert_equals(size_t(3), grams.size());
+    ebt::assert_equals(2, grams[0][1]);
+    ebt::assert_equals(4, grams[2][1]);
+
+    ebt::assert_equals(true, ebt::ngram_view(seq, 5).empty());
+    ebt::assert_equals(true, ebt::ngram_view(seq, 0).empty());
+
+    auto r = ebt::ngram_view(seq, 4);
+    ebt::assert_equals(seq.data(), r.front().data());
+    r.pop_front();
+    ebt::assert_equals(true, r.empty());
+}
+
+void test_same_as_ngram()
+{
+    std::vector<std::string> seq {"a", "b", "c", "d", "e"};
+
+    std::vector<std::vector<std::string>> expected;
+    for (auto& g: ebt::ngram(seq, 3)) {
+        expected.push_back(std::vector<std::string>(g.begin(), g.end()));
+    }
+
+    std::vector<std::vector<std::string>> result;
+    for (auto& g: ebt::ngram_view(seq, 3)) {
+        result.push_back(std::vector<std::string>(g.begin(), g.end()));
+    }
+
+    ebt::assert_equals(expected.size(), result.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        ebt::assert_equals(true, expected[i] == result[i]);
+    }
+}
+
+void test_hashed_ngram_view()
+{
+    std::vector<int> seq {1, 2, 3, 1, 2, 3, 1, 2};
+
+    std::vector<ebt::hashed_ngram<int>> grams;
+    for (auto& g: ebt::hashed_ngram_view(seq, 3)) {
+        grams.push_back(g);
+    }
+    ebt::assert_equals(size_t(6), grams.size());
+
+    std::vector<int> fresh {3, 1, 2};
+    auto rolled = grams[2];
+    auto direct = ebt::hashed_ngram_view(fresh, 3).front();
+    ebt::assert_equals(direct.hash, rolled.hash);
+    ebt::assert_equals(true, direct == rolled);
+    ebt::assert_equals(true, grams[0] == grams[3]);
+    ebt::assert_equals(true, grams[0] != grams[1]);
+
+    std::unordered_map<ebt::hashed_ngram<int>, int> counts;
+    for (auto& g: ebt::hashed_ngram_view(seq, 3)) {
+        ++counts[g];
+    }
+    ebt::assert_equals(3u, unsigned(counts.size()));
+    ebt::assert_equals(2, counts.at(direct));
+
+    ebt::hashmap<ebt::hashed_ngram<int>, int> map;
+    for (auto& g: ebt::hashed_ngram_view(seq, 2)) {
+        map[g] += 1;
+    }
+    ebt::assert_equals(3, map.at(ebt::hashed_ngram_view(seq, 2).front()));
+}
+
+int main()
+{
+    test_ngram_view();
+    test_same_as_ngram();
+    test_hashed_ngram_view();
+
+    return 0;
+}
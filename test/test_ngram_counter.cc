@@ -0,0 +1,159 @@
+#include "ebt/assert.h"
+#include "ebt/ngram_counter.h"
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+std::string write_corpus(std::vector<std::vector<std::string>>& lines)
+{
+    std::mt19937 gen(1);
+    std::uniform_int_distribution<int> word(0, 30);
+    std::uniform_int_distribution<int> length(0, 12);
+
+    char path[] = "/tmp/test_ngram_counter.XXXXXX";
+    int fd = mkstemp(path);
+    close(fd);
+
+    std::ofstream ofs(path);
+    for (int i = 0; i < 2000; ++i) {
+        std::vector<std::string> line;
+        int n = length(gen);
+        for (int j = 0; j < n; ++j) {
+            line.push_back("w" + std::to_string(word(gen)));
+            ofs << (j == 0 ? "" : " ") << line.back();
+        }
+        ofs << "\n";
+        lines.push_back(line);
+    }
+
+    return path;
+}
+
+std::map<std::vector<std::string>, uint64_t> naive_counts(
+    std::vector<std::vector<std::string>> const& lines, int order)
+{
+    std::map<std::vector<std::string>, uint64_t> result;
+
+    for (auto& line: lines) {
+        for (size_t i = 0; i < line.size(); ++i) {
+            for (size_t k = 1; k <= size_t(order) && i + k <= line.size(); ++k) {
+                ++result[std::vector<std::string>(line.begin() + i, line.begin() + i + k)];
+            }
+        }
+    }
+
+    return result;
+}
+
+std::map<std::vector<std::string>, uint64_t> collect(ebt::ngram_counter const& counter)
+{
+    std::map<std::vector<std::string>, uint64_t> result;
+
+    counter.for_each([&](ebt::span<uint32_t const> ids, uint64_t count) {
+        std::vector<std::string> g;
+        for (auto id: ids) {
+            g.push_back(counter.symbols().str(id).str());
+        }
+        ebt::assert_equals(true, result.count(g) == 0);
+        result[g] = count;
+    });
+
+    return result;
+}
+
+void test_count(size_t max_entries, uint64_t min_count)
+{
+    std::vector<std::vector<std::string>> lines;
+    std::string path = write_corpus(lines);
+
+    ebt::ngram_counter::options opt;
+    opt.order = 3;
+    opt.min_count = min_count;
+    opt.max_entries = max_entries;
+
+    {
+        ebt::ngram_counter counter { opt };
+        ebt::line_reader reader { path };
+        counter.add(reader, 4);
+
+        if (max_entries != 0) {
+            ebt::assert_equals(true, counter.runs() > 0);
+        }
+
+        auto expected = naive_counts(lines, opt.order);
+        for (auto it = expected.begin(); it != expected.end();) {
+            it = (it->second < min_count ? expected.erase(it) : std::next(it));
+        }
+
+        auto result = collect(counter);
+        ebt::assert_equals(expected.size(), result.size());
+        ebt::assert_equals(true, expected == result);
+    }
+
+    std::remove(path.c_str());
+}
+
+void test_add_line()
+{
+    ebt::ngram_counter::options opt;
+    opt.order = 2;
+
+    ebt::ngram_counter counter { opt };
+    counter.add("a b a b");
+
+    auto result = collect(counter);
+    ebt::assert_equals(uint64_t(2), result.at({"a"}));
+    ebt::assert_equals(uint64_t(2), result.at({"a", "b"}));
+    ebt::assert_equals(uint64_t(1), result.at({"b", "a"}));
+    ebt::assert_equals(size_t(4), result.size());
+}
+
+// A budget below the shard count still lets each shard hold an entry.
+void test_small_budget()
+{
+    ebt::ngram_counter::options opt;
+    opt.order = 1;
+    opt.max_entries = 1;
+
+    ebt::ngram_counter counter { opt };
+    counter.add("a");
+    ebt::assert_equals(size_t(0), counter.runs());
+
+    counter.add("b c d e f g h i j k l m n o p");
+    auto result = collect(counter);
+    ebt::assert_equals(size_t(16), result.size());
+}
+
+void test_add_in_for_each()
+{
+    ebt::ngram_counter::options opt;
+    opt.order = 1;
+
+    ebt::ngram_counter counter { opt };
+    counter.add("a b");
+
+    int visited = 0;
+    counter.for_each([&](ebt::span<uint32_t const>, uint64_t) {
+        counter.add("a");
+        ++visited;
+    });
+    ebt::assert_equals(2, visited);
+    ebt::assert_equals(uint64_t(3), collect(counter).at({"a"}));
+}
+
+int main()
+{
+    test_add_line();
+    test_small_budget();
+    test_add_in_for_each();
+    test_count(0, 1);
+    test_count(0, 3);
+    test_count(2000, 1);
+    test_count(2000, 5);
+
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include "ebt/assert.h"
+#include "ebt/param_store.h"
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+void test_blocks()
+{
+    ebt::param_store<double> p;
+
+    auto w = p.add("w", 3);
+    w[0] = 1;
+    w[2] = 3;
+    p.add("b", 10)[9] = 2;
+
+    ebt::assert_equals(0, int(uintptr_t(p.data()) % 64));
+    ebt::assert_equals(0, int(uintptr_t(p["b"].data()) % 64));
+    ebt::assert_equals(size_t(3), p["w"].size());
+    ebt::assert_equals(3.0, p["w"][2]);
+    ebt::assert_equals(2.0, p["b"][9]);
+    ebt::assert_equals(true, p.has("b"));
+    ebt::assert_equals(false, p.has("c"));
+
+    bool thrown = false;
+    try {
+        p.add("w", 1);
+    } catch (std::invalid_argument const& e) {
+        thrown = true;
+    }
+    ebt::assert_equals(true, thrown);
+
+    auto m = p.to_map();
+    ebt::assert_equals(size_t(2), m.size());
+    ebt::assert_equals(3.0, m.at("w")[2]);
+}
+
+void test_flat_ops()
+{
+    std::unordered_map<std::string, std::vector<float>> m {
+        {"a", {1, 2, 3}},
+        {"b", {4, 5}},
+    };
+
+    ebt::param_store<float> x { m };
+    ebt::param_store<float> y { m };
+
+    ebt::assert_equals(true, x.same_layout(y));
+    ebt::assert_equals(55.0, ebt::dot(x, y));
+    ebt::assert_equals(15.0, ebt::norm1(x));
+
+    ebt::axpy(2.0f, x, y);
+    ebt::assert_equals(12.0f, y["b"][0]);
+
+    ebt::scale(0.5f, y);
+    ebt::assert_equals(7.5f, y["b"][1]);
+
+    ebt::param_store<float> z;
+    z.add("a", 3);
+    bool thrown = false;
+    try {
+        ebt::dot(x, z);
+    } catch (std::invalid_argument const& e) {
+        thrown = true;
+    }
+    ebt::assert_equals(true, thrown);
+}
+
+void test_save_load()
+{
+    ebt::param_store<double> p;
+    p.add("w", 1000)[999] = 4;
+    p.add("b", 2)[0] = -1;
+
+    char path[] = "/tmp/test_param_store_XXXXXX";
+    int fd = mkstemp(path);
+    close(fd);
+
+    p.save(path);
+
+    ebt::param_store<double> q = ebt::param_store<double>::load(path);
+    ebt::assert_equals(true, p.same_layout(q));
+    ebt::assert_equals(4.0, q["w"][999]);
+    ebt::assert_equals(-1.0, q["b"][0]);
+    ebt::assert_equals(17.0, ebt::dot(p, q));
+
+    // Writes to a loaded store stay private, and adding a block moves it
+    // off the file.
+    q["b"][1] = 5;
+    q.add("c", 1)[0] = 6;
+    ebt::assert_equals(5.0, q["b"][1]);
+    ebt::assert_equals(4.0, q["w"][999]);
+
+    ebt::param_store<double> r = ebt::param_store<double>::load(path);
+    ebt::assert_equals(0.0, r["b"][1]);
+
+    ebt::param_store<double> s = r;
+    s["b"][1] = 1;
+    ebt::assert_equals(0.0, r["b"][1]);
+
+    {
+        bool thrown = false;
+        try {
+            ebt::param_store<float>::load(path);
+        } catch (std::runtime_error const& e) {
+            thrown = true;
+        }
+        ebt::assert_equals(true, thrown);
+    }
+
+    std::remove(path);
+}
+
+int main()
+{
+    test_blocks();
+    test_flat_ops();
+    test_save_load();
+
+    return 0;
+}
@@ -0,0 +1,147 @@
+#include "ebt/assert.h"
+#include "ebt/pipeline.h"
+#include <atomic>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+void test_spsc_queue()
+{
+    ebt::spsc_queue<int> q { 5 };
+    ebt::assert_equals(size_t(8), q.capacity());
+
+    int n = 100000;
+    std::thread producer([&]() {
+        for (int i = 0; i < n; ++i) {
+            int v = i;
+            while (!q.try_push(v)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    for (int i = 0; i < n; ++i) {
+        int v;
+        while (!q.try_pop(v)) {
+            std::this_thread::yield();
+        }
+        ebt::assert_equals(i, v);
+    }
+
+    producer.join();
+
+    int v;
+    ebt::assert_equals(false, q.try_pop(v));
+}
+
+void test_mpmc_queue()
+{
+    ebt::mpmc_queue<long> q { 16 };
+    int const n = 20000;
+    std::atomic<long> sum { 0 };
+    std::atomic<int> taken { 0 };
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 3; ++t) {
+        threads.emplace_back([&, t]() {
+            for (long i = t * n; i < (t + 1) * n; ++i) {
+                long v = i;
+                while (!q.try_push(v)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        threads.emplace_back([&]() {
+            long v;
+            while (taken < 3 * n) {
+                if (q.try_pop(v)) {
+                    sum += v;
+                    ++taken;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    for (auto& t: threads) {
+        t.join();
+    }
+
+    long total = 3L * n * (3L * n - 1) / 2;
+    ebt::assert_equals(total, sum.load());
+}
+
+void test_pipeline()
+{
+    ebt::pipeline_options opt;
+    opt.batch_size = 7;
+    opt.queue_capacity = 4;
+
+    int next = 0;
+    long sum = 0;
+    size_t chars = 0;
+
+    auto p = ebt::pipeline_source<int>("read", [&](int& v) {
+            if (next == 10000) {
+                return false;
+            }
+            v = next++;
+            return true;
+        }, opt)
+        .then("double", 3, [](int& v) { return long(v) * 2; })
+        .then("format", 2, [](long& v) { return std::to_string(v); })
+        .sink("accumulate", 1, [&](std::string& s) {
+            sum += std::stol(s);
+            chars += s.size();
+        });
+
+    p.run();
+
+    ebt::assert_equals(9999L * 10000, sum);
+    ebt::assert_equals(size_t(4), p.stages());
+    ebt::assert_equals(uint64_t(10000), p.stats(0).items.load());
+    ebt::assert_equals(uint64_t(10000), p.stats(3).items.load());
+
+    std::ostringstream oss;
+    p.report(oss);
+    ebt::assert_equals(true, oss.str().find("format: threads 2") != std::string::npos);
+}
+
+void test_pipeline_error()
+{
+    int next = 0;
+
+    auto p = ebt::pipeline_source<int>("read", [&](int& v) {
+            v = next++;
+            return true;
+        })
+        .then("check", 2, [](int& v) {
+            if (v == 5000) {
+                throw std::runtime_error("bad item");
+            }
+            return v;
+        })
+        .sink("drop", 1, [](int&) {});
+
+    bool thrown = false;
+    try {
+        p.run();
+    } catch (std::runtime_error const& e) {
+        thrown = true;
+    }
+
+    ebt::assert_equals(true, thrown);
+}
+
+int main()
+{
+    test_spsc_queue();
+    test_mpmc_queue();
+    test_pipeline();
+    test_pipeline_error();
+
+    return 0;
+}
@@ -1,4 +1,6 @@
+#include "ebt/assert.h"
 #include "ebt/range.h"
+#include <list>
 #include <vector>
 #include <string>
 
@@ -8,9 +10,66 @@ void test_is_range()
     static_assert(ebt::is_range<ebt::range<std::vector<std::string>>>::value, "");
 }
 
+void test_random_access()
+{
+    static_assert(ebt::is_random_access_range<ebt::range<std::vector<int>>>::value, "");
+    static_assert(!ebt::is_sized_range<ebt::range<std::list<int>>>::value, "");
+
+    std::vector<int> vec {1, 2, 3, 4, 5};
+    auto r = ebt::make_range(vec);
+    ebt::assert_equals(size_t(5), r.size());
+    ebt::assert_equals(3, r[2]);
+
+    r.pop_front();
+    ebt::assert_equals(size_t(4), r.size());
+    ebt::assert_equals(4, r[2]);
+}
+
+void test_range_iterator()
+{
+    std::vector<int> vec {1, 2};
+    auto r = ebt::make_range(vec);
+
+    ebt::assert_equals(true, r.begin() == r.begin());
+    ebt::assert_equals(true, r.begin() != r.end());
+
+    std::vector<int> empty;
+    auto e = ebt::make_range(empty);
+    ebt::assert_equals(true, e.begin() == e.end());
+}
+
+void test_slice_and_chunk()
+{
+    std::vector<int> vec {1, 2, 3, 4, 5};
+
+    auto s = ebt::slice(vec, 1, 4);
+    ebt::assert_equals(size_t(3), s.size());
+    ebt::assert_equals(2, s.front());
+    ebt::assert_equals(4, s[2]);
+    ebt::assert_equals(size_t(0), ebt::slice(vec, 7, 9).size());
+
+    auto c = ebt::chunk(vec, 2);
+    ebt::assert_equals(size_t(3), c.size());
+    ebt::assert_equals(size_t(1), c[2].size());
+    ebt::assert_equals(5, c[2][0]);
+    ebt::assert_equals(size_t(2), c.front().size());
+    ebt::assert_equals(1, c.front()[0]);
+
+    std::vector<int> flat;
+    for (auto piece: c) {
+        for (auto& v: piece) {
+            flat.push_back(v);
+        }
+    }
+    ebt::assert_equals(true, flat == vec);
+}
+
 int main()
 {
     test_is_range();
+    test_random_access();
+    test_range_iterator();
+    test_slice_and_chunk();
 
     return 0;
 }
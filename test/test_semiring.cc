@@ -0,0 +1,221 @@
+#include "ebt/assert.h"
+#include "ebt/semiring.h"
+#include "ebt/simd.h"
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+double const inf = std::numeric_limits<double>::infinity();
+
+// Random entries, with some set to zero to stand for missing arcs.  The
+// sizes below are larger than the blocks in semiring.cc and not multiples
+// of the vector width.
+std::vector<double> random_matrix(size_t size, double lo, double hi, double zero, unsigned seed)
+{
+    std::mt19937 gen { seed };
+    std::uniform_real_distribution<double> d { lo, hi };
+
+    std::vector<double> result;
+    for (size_t i = 0; i < size; ++i) {
+        double v = d(gen);
+        result.push_back(i % 11 == 5 ? zero : v);
+    }
+
+    return result;
+}
+
+template <class S>
+std::vector<double> naive_matmul(std::vector<double> const& a,
+    std::vector<double> const& b, size_t n, size_t k, size_t m)
+{
+    std::vector<double> c(n * m, S::zero());
+
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < m; ++j) {
+            for (size_t l = 0; l < k; ++l) {
+                c[i * m + j] = S::plus(c[i * m + j], S::times(a[i * k + l], b[l * m + j]));
+            }
+        }
+    }
+
+    return c;
+}
+
+std::vector<double> transpose(std::vector<double> const& a, size_t rows, size_t cols)
+{
+    std::vector<double> result(rows * cols);
+
+    for (size_t i = 0; i < rows; ++i) {
+        for (size_t j = 0; j < cols; ++j) {
+            result[j * rows + i] = a[i * cols + j];
+        }
+    }
+
+    return result;
+}
+
+void assert_args(std::vector<uint32_t> const& expected, std::vector<uint32_t> const& actual)
+{
+    for (size_t i = 0; i < expected.size(); ++i) {
+        ebt::assert_equals(expected[i], actual[i]);
+    }
+}
+
+void assert_all_close(std::vector<double> const& expected,
+    std::vector<double> const& actual, double eps)
+{
+    ebt::assert_equals(expected.size(), actual.size());
+
+    for (size_t i = 0; i < expected.size(); ++i) {
+        if (expected[i] == -inf) {
+            ebt::assert_equals(-inf, actual[i]);
+        } else {
+            ebt::assert_equals(expected[i], actual[i],
+                eps * std::max(1.0, std::fabs(expected[i])));
+        }
+    }
+}
+
+template <class S>
+void test_kernels(double lo, double hi, double eps)
+{
+    size_t n = 5;
+    size_t k = 300;
+    size_t m = 601;
+
+    std::vector<double> a = random_matrix(n * k, lo, hi, S::zero(), 1);
+    std::vector<double> b = random_matrix(k * m, lo, hi, S::zero(), 2);
+
+    std::vector<double> expected = naive_matmul<S>(a, b, n, k, m);
+
+    std::vector<double> c(n * m);
+    ebt::matmul<S>(a.data(), b.data(), n, k, m, c.data());
+    assert_all_close(expected, c, eps);
+
+    std::vector<double> y(m);
+    ebt::vecmat<S>(a.data(), b.data(), k, m, y.data());
+    assert_all_close(std::vector<double>(expected.begin(), expected.begin() + m), y, eps);
+
+    // A x[s] for x[s] the rows of A, against (B^T A^T)^T.
+    std::vector<double> bt = transpose(b, k, m);
+    std::vector<double> batch(n * m);
+    ebt::matvec_batch<S>(bt.data(), m, k, a.data(), n, batch.data());
+    assert_all_close(expected, batch, eps);
+
+    ebt::matvec<S>(bt.data(), m, k, a.data(), y.data());
+    assert_all_close(std::vector<double>(expected.begin(), expected.begin() + m), y, eps);
+}
+
+void test_all_zero()
+{
+    size_t k = 7;
+    size_t m = 9;
+
+    std::vector<double> a(k, -inf);
+    std::vector<double> b(k * m, 0.0);
+    std::vector<double> y(m);
+
+    ebt::vecmat<ebt::log_semiring>(a.data(), b.data(), k, m, y.data());
+    assert_all_close(std::vector<double>(m, -inf), y, 0);
+
+    std::vector<uint32_t> arg(m);
+    ebt::vecmat_argmax(a.data(), b.data(), k, m, y.data(), arg.data());
+    assert_all_close(std::vector<double>(m, -inf), y, 0);
+    ebt::assert_equals(ebt::argmax_npos, arg[0]);
+    ebt::assert_equals(ebt::argmax_npos, arg[m - 1]);
+}
+
+void test_argmax()
+{
+    size_t n = 3;
+    size_t k = 300;
+    size_t m = 301;
+
+    // Integer weights make ties common, so the first index must win.
+    std::vector<double> a = random_matrix(n * k, -5, 5, -inf, 3);
+    std::vector<double> b = random_matrix(k * m, -5, 5, -inf, 4);
+    for (auto& v: a) {
+        v = std::floor(v);
+    }
+    for (auto& v: b) {
+        v = std::floor(v);
+    }
+
+    std::vector<double> c(n * m);
+    std::vector<uint32_t> arg(n * m);
+    ebt::matmul_argmax(a.data(), b.data(), n, k, m, c.data(), arg.data());
+
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < m; ++j) {
+            double best = -inf;
+            uint32_t best_arg = ebt::argmax_npos;
+
+            for (size_t l = 0; l < k; ++l) {
+                if (a[i * k + l] + b[l * m + j] > best) {
+                    best = a[i * k + l] + b[l * m + j];
+                    best_arg = l;
+                }
+            }
+
+            ebt::assert_equals(best, c[i * m + j]);
+            ebt::assert_equals(best_arg, arg[i * m + j]);
+        }
+    }
+
+    std::vector<double> y(m);
+    std::vector<uint32_t> yarg(m);
+    ebt::vecmat_argmax(a.data(), b.data(), k, m, y.data(), yarg.data());
+    assert_args(std::vector<uint32_t>(arg.begin(), arg.begin() + m), yarg);
+
+    std::vector<double> bt = transpose(b, k, m);
+    ebt::matvec_argmax(bt.data(), m, k, a.data(), y.data(), yarg.data());
+    assert_all_close(std::vector<double>(c.begin(), c.begin() + m), y, 0);
+    assert_args(std::vector<uint32_t>(arg.begin(), arg.begin() + m), yarg);
+}
+
+// Outputs large enough that the per-thread scratch buffer is released
+// after each call, followed by a small product that grows it again.
+void test_large()
+{
+    size_t n = 300;
+    size_t k = 3;
+    size_t m = 300;
+
+    std::vector<double> a = random_matrix(n * k, -20, 0, -inf, 5);
+    std::vector<double> b = random_matrix(k * m, -20, 0, -inf, 6);
+
+    std::vector<double> c(n * m);
+    ebt::matmul<ebt::log_semiring>(a.data(), b.data(), n, k, m, c.data());
+    assert_all_close(naive_matmul<ebt::log_semiring>(a, b, n, k, m), c, 1e-12);
+
+    std::vector<uint32_t> arg(n * m);
+    ebt::matmul_argmax(a.data(), b.data(), n, k, m, c.data(), arg.data());
+    assert_all_close(naive_matmul<ebt::tropical_semiring>(a, b, n, k, m), c, 0);
+
+    std::vector<double> small(2 * 2);
+    ebt::matmul<ebt::log_semiring>(a.data(), b.data(), 2, k, 2, small.data());
+    assert_all_close(naive_matmul<ebt::log_semiring>(a, b, 2, k, 2), small, 1e-12);
+}
+
+int main()
+{
+    // Once with the widest kernels the CPU has, and once with dispatch
+    // held to SSE2.
+    ebt::simd_level const levels[] = { ebt::simd_level::avx2, ebt::simd_level::sse2 };
+
+    for (auto level: levels) {
+        ebt::set_max_simd_level(level);
+
+        test_kernels<ebt::real_semiring>(-1, 1, 1e-12);
+        test_kernels<ebt::tropical_semiring>(-20, 0, 0);
+        test_kernels<ebt::log_semiring>(-20, 0, 1e-12);
+        test_all_zero();
+        test_argmax();
+        test_large();
+    }
+
+    ebt::set_max_simd_level(ebt::simd_level::avx2);
+
+    return 0;
+}
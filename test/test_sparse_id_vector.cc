@@ -0,0 +1,103 @@
+#include "ebt/assert.h"
+#include "ebt/sparse_id_vector.h"
+#include <random>
+#include <vector>
+
+void test_construct()
+{
+    ebt::sparse_id_vector v { {5, 1}, {2, 2}, {5, 3} };
+
+    ebt::assert_equals(size_t(2), v.size());
+    ebt::assert_equals(2u, v.ids()[0]);
+    ebt::assert_equals(5u, v.ids()[1]);
+    ebt::assert_equals(4.0, v(5));
+    ebt::assert_equals(0.0, v(3));
+
+    bool thrown = false;
+    try {
+        v.push_back(4, 1);
+    } catch (std::invalid_argument const& e) {
+        thrown = true;
+    }
+    ebt::assert_equals(true, thrown);
+}
+
+void test_dot()
+{
+    std::mt19937 gen { 1 };
+    std::uniform_int_distribution<uint32_t> id { 0, 999 };
+
+    // The second pair is lopsided enough to take the galloping path.
+    for (int sizes: {0, 1}) {
+        ebt::sparse_id_vector a;
+        ebt::sparse_id_vector b;
+        std::vector<double> da(1000);
+        std::vector<double> db(1000);
+
+        for (int i = 0; i < (sizes == 0 ? 200 : 10); ++i) {
+            uint32_t k = id(gen);
+            da[k] += i + 1;
+            a += ebt::sparse_id_vector { {k, double(i + 1)} };
+        }
+        for (int i = 0; i < 400; ++i) {
+            uint32_t k = id(gen);
+            db[k] += 1;
+            b += ebt::sparse_id_vector { {k, 1} };
+        }
+
+        double expected = 0;
+        for (int k = 0; k < 1000; ++k) {
+            expected += da[k] * db[k];
+        }
+
+        ebt::assert_equals(expected, ebt::dot(a, b));
+        ebt::assert_equals(expected, ebt::dot(b, a));
+        ebt::assert_equals(expected, ebt::dot(a, ebt::make_span(db)));
+    }
+}
+
+void test_axpy()
+{
+    ebt::sparse_id_vector y { {1, 1}, {3, 1}, {7, 1} };
+
+    ebt::axpy(2, ebt::sparse_id_vector { {3, 1}, {7, 2} }, y);
+    ebt::assert_equals(size_t(3), y.size());
+    ebt::assert_equals(3.0, y(3));
+    ebt::assert_equals(5.0, y(7));
+
+    ebt::axpy(-1, ebt::sparse_id_vector { {0, 1}, {3, 3}, {9, 1} }, y);
+    ebt::assert_equals(true, ebt::sparse_id_vector { {0, -1}, {1, 1}, {3, 0}, {7, 5}, {9, -1} } == y);
+
+    std::vector<double> dense(10);
+    ebt::axpy(2, y, ebt::make_span(dense));
+    ebt::assert_equals(-2.0, dense[0]);
+    ebt::assert_equals(10.0, dense[7]);
+}
+
+void test_convert()
+{
+    ebt::symbol_table symbols;
+    symbols.intern("b");
+
+    ebt::SparseVector v { {"a", 1}, {"b", 2} };
+    ebt::sparse_id_vector u = ebt::to_sparse_id_vector(v, symbols);
+
+    ebt::assert_equals(2.0, u(symbols.find("b")));
+    ebt::assert_equals(1.0, u(symbols.find("a")));
+    ebt::assert_equals(0u, u.ids()[0]);
+
+    ebt::SparseVector w = ebt::to_sparse_vector(u, symbols);
+    ebt::assert_equals(1.0, w("a"));
+    ebt::assert_equals(2.0, w("b"));
+    ebt::assert_equals(size_t(2), w.size());
+}
+
+int main()
+{
+    test_construct();
+    test_dot();
+    test_axpy();
+    test_convert();
+
+    return 0;
+}
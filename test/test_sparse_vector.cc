@@ -0,0 +1,112 @@
+#include "ebt/assert.h"
+#include "ebt/sparse_vector.h"
+#include <cmath>
+
+void test_axpy()
+{
+    ebt::SparseVector w { {"a", 1}, {"b", 2} };
+    ebt::SparseVector g { {"b", 1}, {"c", 4} };
+
+    w.axpy(0.5, g);
+    ebt::assert_equals(1.0, w("a"));
+    ebt::assert_equals(2.5, w("b"));
+    ebt::assert_equals(2.0, w("c"));
+
+    w.axpy(-1, w);
+    ebt::assert_equals(0.0, w("b"));
+    ebt::assert_equals(3, w.size());
+}
+
+void test_lazy_scale()
+{
+    ebt::SparseVector w { {"a", 1}, {"b", 2} };
+    ebt::SparseVector g { {"a", 1} };
+
+    w *= 0.5;
+    ebt::assert_equals(1.0, w("b"));
+
+    w.axpy(2, g);
+    ebt::assert_equals(2.5, w("a"));
+
+    w /= 0.5;
+    ebt::assert_equals(5.0, w("a"));
+    ebt::assert_equals(5.0, ebt::dot(w, g));
+    ebt::assert_equals(5.0, ebt::get(w, "a", 0));
+    ebt::assert_equals(7.0, ebt::norm(w, 1));
+
+    double sum = 0;
+    for (auto& p: w) {
+        sum += p.second;
+    }
+    ebt::assert_equals(7.0, sum);
+
+    w("b") += 1;
+    w *= 2;
+    ebt::assert_equals(6.0, w("b"));
+
+    for (int i = 0; i < 1000; ++i) {
+        w *= 0.5;
+    }
+    w *= std::pow(2.0, 1000);
+    ebt::assert_equals(6.0, w("b"));
+
+    w *= 0;
+    ebt::assert_equals(0, w.size());
+}
+
+void test_write_after_scale()
+{
+    ebt::SparseVector w { {"a", 1}, {"b", 2}, {"c", 3} };
+
+    w *= 0.1;
+    w("a") += 1;
+    w("b") -= 0.2;
+    w("d") = 4;
+    w("c") *= 10;
+    ebt::assert_equals(1.1, w("a"), 1e-15);
+    ebt::assert_equals(0.0, w("b"), 1e-15);
+    ebt::assert_equals(3.0, w("c"), 1e-15);
+    ebt::assert_equals(4.0, w("d"), 1e-15);
+
+    w("e") = w("d");
+    ebt::assert_equals(4.0, w("e"), 1e-15);
+    ebt::assert_equals(4.0, w("d"), 1e-15);
+
+    // Reading through a const reference sees the scaled values and leaves
+    // the vector alone.
+    ebt::SparseVector const& cw = w;
+    double sum = 0;
+    for (auto& p: cw) {
+        sum += p.second;
+    }
+    ebt::assert_equals(12.1, sum, 1e-14);
+
+    w *= 2;
+    ebt::assert_equals(2.2, w("a"), 1e-15);
+    ebt::assert_equals(8.0, cw("e"), 1e-15);
+}
+
+void test_compact()
+{
+    ebt::SparseVector w { {"a", 1}, {"b", 2} };
+    w -= ebt::SparseVector { {"a", 1} };
+    ebt::assert_equals(2, w.size());
+
+    w.compact();
+    ebt::assert_equals(1, w.size());
+    ebt::assert_equals(false, ebt::in("a", w));
+
+    w *= 3;
+    w.compact(7);
+    ebt::assert_equals(0, w.size());
+}
+
+int main()
+{
+    test_axpy();
+    test_lazy_scale();
+    test_write_after_scale();
+    test_compact();
+
+    return 0;
+}
@@ -0,0 +1,414 @@
+#include "ebt/assert.h"
+#include "ebt/string.h"
+#include "ebt/replacer.h"
+#include "ebt/utf8.h"
+#include "ebt/functional.h"
+#include "ebt/ngram.h"
+#include "ebt/vector.h"
+#include "ebt/simd.h"
+#include <random>
+#include <vector>
+#include <string>
+#include <limits>
+#include <cctype>
+#include <sstream>
+
+void test_split_range()
+{
+    std::string s = " a  bb\tccc \n";
+    std::vector<std::string> exp = {"a", "bb", "ccc"};
+
+    static_assert(ebt::is_range<ebt::split_range>::value, "");
+
+    ebt::split_range r(s);
+    for (auto& e: exp) {
+        ebt::assert_equals(false, r.empty());
+        ebt::assert_equals(e, r.front().str());
+        r.pop_front();
+    }
+    ebt::assert_equals(true, r.empty());
+}
+
+void test_split_range_sep()
+{
+    std::string s = "a,,b,";
+    std::vector<std::string> result;
+
+    for (auto& t: ebt::split_range(s, ",")) {
+        result.push_back(t.str());
+    }
+
+    ebt::assert_equals(std::vector<std::string>{"a", "", "b", ""}, result);
+}
+
+void test_split_ref()
+{
+    std::string s = "a b c";
+    std::vector<ebt::string_ref> result = ebt::split(ebt::string_ref(s));
+
+    ebt::assert_equals(3, int(result.size()));
+    ebt::assert_equals(s.data() + 2, result[1].data());
+    ebt::assert_equals(std::string("c"), result[2].str());
+}
+
+void test_strip_ref()
+{
+    std::string s = "  abc \n";
+    ebt::string_ref r = ebt::strip(ebt::string_ref(s));
+    ebt::assert_equals(std::string("abc"), r.str());
+    ebt::assert_equals(std::string("abc"), ebt::strip(s));
+}
+
+void test_startswith_endswith()
+{
+    ebt::assert_equals(true, ebt::startswith("--help", "--"));
+    ebt::assert_equals(false, ebt::startswith(ebt::string_ref("-"), "--"));
+    ebt::assert_equals(true, ebt::endswith(std::string("abab"), std::string("ab")));
+    ebt::assert_equals(false, ebt::endswith(ebt::string_ref("b"), "ab"));
+}
+
+void test_map_split_range()
+{
+    std::string s = "a bb ccc";
+    auto r = ebt::map(ebt::split_range(s),
+        [](ebt::string_ref const& t) { return int(t.size()); });
+
+    std::vector<int> result;
+    for (auto& e: r) {
+        result.push_back(e);
+    }
+
+    ebt::assert_equals(std::vector<int>{1, 2, 3}, result);
+}
+
+void test_ngram_split_range()
+{
+    std::string s = "a b c";
+    std::vector<std::string> result;
+
+    for (auto& g: ebt::ngram(ebt::split_range(s), 2)) {
+        result.push_back(g.front().str() + g.back().str());
+    }
+
+    ebt::assert_equals(std::vector<std::string>{"ab", "bc"}, result);
+}
+
+void test_format()
+{
+    ebt::assert_equals(std::string("a 1 -2 {b} 0.5"),
+        ebt::format("a {} {} {{b}} {}", 1, -2L, 0.5));
+    ebt::assert_equals(std::string("x y"), ebt::format("{} {}", 'x', "y"));
+    ebt::assert_equals(std::string("1 {}"), ebt::format("{} {}", 1));
+
+    std::ostringstream oss;
+    ebt::format(oss, "{}-{}", std::string("a"), 3u);
+    ebt::assert_equals(std::string("a-3"), oss.str());
+}
+
+void test_append_number()
+{
+    std::vector<double> ds = {0, 1.5, -3.25e-10, 1e100, 123456789.0, 1.0 / 3};
+
+    for (auto d: ds) {
+        std::ostringstream oss;
+        oss << d;
+        std::string buf;
+        ebt::append(buf, d);
+        ebt::assert_equals(oss.str(), buf);
+    }
+
+    std::string buf;
+    ebt::append(buf, std::numeric_limits<long long>::min());
+    ebt::assert_equals(std::to_string(std::numeric_limits<long long>::min()), buf);
+}
+
+void test_format_string()
+{
+    static ebt::format_string const f("{}:{} {{}}");
+    std::string buf = ">";
+    f.append(buf, "w", 7);
+    ebt::assert_equals(std::string(">w:7 {}"), buf);
+    ebt::assert_equals(std::string("a:1.5 {}"), f("a", 1.5));
+
+    bool thrown = false;
+    try {
+        f(1);
+    } catch (std::invalid_argument const& e) {
+        thrown = true;
+    }
+    ebt::assert_equals(true, thrown);
+}
+
+void test_upper_lower()
+{
+    std::string s;
+    for (int i = 0; i < 3; ++i) {
+        for (int c = 1; c < 256; ++c) {
+            s += char(c);
+        }
+    }
+
+    std::string up;
+    std::string low;
+    for (auto c: s) {
+        up += ((unsigned char) c < 128 ? std::toupper(c) : c);
+        low += ((unsigned char) c < 128 ? std::tolower(c) : c);
+    }
+
+    ebt::assert_equals(up, ebt::upper(s));
+    ebt::assert_equals(low, ebt::lower(s));
+
+    ebt::lower_inplace(s);
+    ebt::assert_equals(low, s);
+    ebt::upper_inplace(s);
+    ebt::assert_equals(up, s);
+}
+
+void test_escapeseq()
+{
+    ebt::assert_equals(std::string(""), ebt::escapeseq(""));
+    ebt::assert_equals(std::string("a\\\\\\\"b"), ebt::escapeseq("a\\\"b"));
+
+    std::string s = "0123456789abcdef\"0123456789abcdef\\";
+    ebt::assert_equals(std::string("0123456789abcdef\\\"0123456789abcdef\\\\"),
+        ebt::escapeseq(s));
+}
+
+void test_string_builder()
+{
+    ebt::string_builder sb;
+    ebt::join(std::vector<std::string>{"a", "bc", "d"}, ", ", sb);
+    ebt::assert_equals(std::string("a, bc, d"), sb.str());
+
+    sb.clear();
+    ebt::join(std::vector<int>{1, 2, 3}, "-", sb) << ';';
+    ebt::format(sb, "{}={}", "x", 1.5);
+    ebt::escapeseq("\"q\"", sb);
+    ebt::upper("ab", sb);
+    ebt::lower("CD", sb);
+    static ebt::format_string const f("<{}>");
+    f.append(sb, 7);
+    ebt::assert_equals(std::string("1-2-3;x=1.5\\\"q\\\"ABcd<7>"), sb.str());
+
+    ebt::assert_equals(std::string("a b"),
+        ebt::join(std::vector<std::string>{"a", "b"}, " "));
+    ebt::assert_equals(std::string(""), ebt::join(std::vector<std::string>{}, " "));
+    ebt::assert_equals(std::string("1 2"), ebt::join(std::vector<double>{1, 2}, " "));
+}
+
+struct nested {
+    int i;
+};
+
+std::ostream& operator<<(std::ostream& os, nested const& n)
+{
+    return os << ebt::format("[{}]", n.i);
+}
+
+void test_local_builder()
+{
+    ebt::assert_equals(std::string("([1], [2])"),
+        ebt::format("({})", ebt::join(std::vector<nested>{{1}, {2}}, ", ")));
+    ebt::assert_equals(std::string("<[3]>"), ebt::format("<{}>", nested{3}));
+
+    ebt::local_builder outer;
+    *outer << "a";
+    {
+        ebt::local_builder inner;
+        *inner << "b";
+        ebt::assert_equals(std::string("b"), inner->str());
+    }
+    ebt::assert_equals(std::string("a"), outer->str());
+}
+
+void test_split_utf8_chars()
+{
+    std::string s = "ab\xc3\xa9" "0123456789abcdef" "\xe4\xb8\xad";
+    std::vector<std::string> result = ebt::split_utf8_chars(s);
+
+    ebt::assert_equals(20, int(result.size()));
+    ebt::assert_equals(std::string("a"), result[0]);
+    ebt::assert_equals(std::string("\xc3\xa9"), result[2]);
+    ebt::assert_equals(std::string("f"), result[18]);
+    ebt::assert_equals(std::string("\xe4\xb8\xad"), result[19]);
+}
+
+void test_replace()
+{
+    ebt::assert_equals(std::string("x--y--"), ebt::replace("x.y.", ".", "--"));
+    ebt::assert_equals(std::string("abc"), ebt::replace("abc", "d", "e"));
+    ebt::assert_equals(std::string("\\\"a\\\""), ebt::replace("\"a\"", "\"", "\\\""));
+    ebt::assert_equals(std::string("a_b"), ebt::replace(" a  b ", "", "_"));
+}
+
+void test_replacer()
+{
+    ebt::replacer r({{"he", "1"}, {"she", "2"}, {"hers", "3"}});
+    std::string out = "garbage";
+
+    r.apply("ushers", out);
+    ebt::assert_equals(std::string("u2rs"), out);
+
+    r.apply("", out);
+    ebt::assert_equals(std::string(""), out);
+
+    ebt::assert_equals(std::string("x3"), r("xhers"));
+    ebt::assert_equals(std::string("1x2"), r("hexshe"));
+
+    ebt::replacer overlap({{"bc", "1"}, {"abcd", "2"}, {"abcx", "3"}});
+    ebt::assert_equals(std::string("2a1y"), overlap("abcdabcy"));
+
+    ebt::replacer seq({{"&amp;", "&"}, {"&lt;", "<"}, {"&gt;", ">"}});
+    ebt::assert_equals(std::string("<a & b>"), seq("&lt;a &amp; b&gt;"));
+}
+
+void test_valid_utf8()
+{
+    ebt::assert_equals(true, ebt::is_valid_utf8(""));
+    ebt::assert_equals(true, ebt::is_valid_utf8("0123456789abcdef0123456789abcdef0123"));
+    ebt::assert_equals(true, ebt::is_valid_utf8("a\xc3\xa9\xe4\xb8\xad\xf0\x9f\x98\x80"));
+
+    // overlong, surrogate, too large, truncated, stray continuation
+    ebt::assert_equals(size_t(1), ebt::find_invalid_utf8("a\xc0\xaf"));
+    ebt::assert_equals(size_t(0), ebt::find_invalid_utf8("\xed\xa0\x80"));
+    ebt::assert_equals(size_t(0), ebt::find_invalid_utf8("\xf4\x90\x80\x80"));
+    ebt::assert_equals(size_t(2), ebt::find_invalid_utf8("ab\xe4\xb8"));
+    ebt::assert_equals(size_t(40),
+        ebt::find_invalid_utf8("0123456789abcdef0123456789abcdef01234567\x80"));
+}
+
+std::string encode_utf8(char32_t c)
+{
+    std::string result;
+
+    if (c < 0x80) {
+        result += char(c);
+    } else if (c < 0x800) {
+        result += char(0xC0 | (c >> 6));
+        result += char(0x80 | (c & 0x3F));
+    } else if (c < 0x10000) {
+        result += char(0xE0 | (c >> 12));
+        result += char(0x80 | ((c >> 6) & 0x3F));
+        result += char(0x80 | (c & 0x3F));
+    } else {
+        result += char(0xF0 | (c >> 18));
+        result += char(0x80 | ((c >> 12) & 0x3F));
+        result += char(0x80 | ((c >> 6) & 0x3F));
+        result += char(0x80 | (c & 0x3F));
+    }
+
+    return result;
+}
+
+size_t scalar_find_invalid_utf8(std::string const& s)
+{
+    size_t i = 0;
+
+    while (i < s.size()) {
+        int n = ebt::utf8_char_length(s.data() + i, s.size() - i);
+
+        if (n == 0) {
+            return i;
+        }
+
+        i += n;
+    }
+
+    return ebt::string_ref::npos;
+}
+
+// Mostly non-ASCII text with single corrupted bytes, checked against the
+// scalar decoder with each set of kernels.
+void test_valid_utf8_multibyte()
+{
+    std::mt19937 gen { 1 };
+    std::uniform_int_distribution<int> width { 1, 4 };
+    char32_t const lo[] = { 0, 0x80, 0x800, 0x10000 };
+    char32_t const hi[] = { 0x7F, 0x7FF, 0xFFFF, 0x10FFFF };
+
+    std::string text;
+    while (text.size() < 4000) {
+        int w = width(gen) - 1;
+        char32_t c = std::uniform_int_distribution<char32_t> { lo[w], hi[w] }(gen);
+        if (0xD800 <= c && c <= 0xDFFF) {
+            continue;
+        }
+        text += encode_utf8(c);
+    }
+
+    std::uniform_int_distribution<size_t> pos { 0, text.size() - 1 };
+    std::uniform_int_distribution<int> byte { 0x80, 0xFF };
+
+    ebt::simd_level const levels[] = { ebt::simd_level::sse2,
+        ebt::simd_level::ssse3, ebt::simd_level::avx2 };
+
+    for (auto level: levels) {
+        ebt::set_max_simd_level(level);
+
+        ebt::assert_equals(size_t(ebt::string_ref::npos), ebt::find_invalid_utf8(text));
+
+        for (size_t n = 0; n < 100; ++n) {
+            std::string prefix = text.substr(0, n * 37);
+            ebt::assert_equals(scalar_find_invalid_utf8(prefix), ebt::find_invalid_utf8(prefix));
+        }
+
+        for (int k = 0; k < 2000; ++k) {
+            std::string s = text;
+            s[pos(gen)] = char(k % 2 == 0 ? byte(gen) : byte(gen) - 0x80);
+            ebt::assert_equals(scalar_find_invalid_utf8(s), ebt::find_invalid_utf8(s));
+        }
+    }
+
+    ebt::set_max_simd_level(ebt::simd_level::avx2);
+}
+
+void test_utf8_ranges()
+{
+    std::string s = "a\xc3\xa9\xff\xe4\xb8\xad";
+
+    std::vector<std::string> chars;
+    for (auto& c: ebt::utf8_char_range(s)) {
+        chars.push_back(c.str());
+    }
+    ebt::assert_equals(std::vector<std::string>{"a", "\xc3\xa9", "\xff", "\xe4\xb8\xad"}, chars);
+
+    std::vector<int> codepoints;
+    for (auto& c: ebt::codepoint_range(s)) {
+        codepoints.push_back(c);
+    }
+    ebt::assert_equals(std::vector<int>{0x61, 0xE9, 0xFFFD, 0x4E2D}, codepoints);
+
+    std::vector<uint32_t> offsets(s.size());
+    offsets.resize(ebt::utf8_offsets(s, offsets.data()));
+    ebt::assert_equals(std::vector<uint32_t>{0, 1, 3, 4}, offsets);
+
+    std::vector<char32_t> decoded(s.size());
+    ebt::assert_equals(size_t(4), ebt::decode_utf8(s, decoded.data()));
+    ebt::assert_equals(int(0x4E2D), int(decoded[3]));
+}
+
+int main()
+{
+    test_split_range();
+    test_split_range_sep();
+    test_split_ref();
+    test_strip_ref();
+    test_startswith_endswith();
+    test_map_split_range();
+    test_ngram_split_range();
+    test_format();
+    test_append_number();
+    test_format_string();
+    test_upper_lower();
+    test_escapeseq();
+    test_string_builder();
+    test_local_builder();
+    test_split_utf8_chars();
+    test_replace();
+    test_replacer();
+    test_valid_utf8();
+    test_valid_utf8_multibyte();
+    test_utf8_ranges();
+
+    return 0;
+}
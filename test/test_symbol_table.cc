@@ -0,0 +1,108 @@
+#include "ebt/assert.h"
+#include "ebt/symbol_table.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+void test_intern()
+{
+    ebt::symbol_table table;
+
+    ebt::assert_equals(0u, table.intern("a"));
+    ebt::assert_equals(1u, table.intern("bb"));
+    ebt::assert_equals(0u, table.intern(std::string("a")));
+    ebt::assert_equals(2u, table.intern(""));
+
+    ebt::assert_equals(3u, table.size());
+    ebt::assert_equals(1u, table.find("bb"));
+    ebt::assert_equals(ebt::symbol_table::npos, table.find("c"));
+    ebt::assert_equals(std::string("bb"), table.str(1).str());
+}
+
+void test_many()
+{
+    ebt::symbol_table table;
+
+    for (int i = 0; i < 100000; ++i) {
+        ebt::assert_equals(uint32_t(i), table.intern(std::to_string(i)));
+    }
+
+    for (int i = 0; i < 100000; ++i) {
+        ebt::assert_equals(std::to_string(i), table.str(i).str());
+    }
+}
+
+void test_concurrent_intern()
+{
+    ebt::symbol_table table;
+    int const n = 20000;
+    std::vector<std::vector<uint32_t>> ids(4, std::vector<uint32_t>(n));
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < n; ++i) {
+                ids[t][i] = table.intern(std::to_string((i * (t + 1)) % n));
+            }
+        });
+    }
+
+    for (auto& t: threads) {
+        t.join();
+    }
+
+    ebt::assert_equals(uint32_t(n), table.size());
+
+    for (int t = 0; t < 4; ++t) {
+        for (int i = 0; i < n; ++i) {
+            ebt::assert_equals(std::to_string((i * (t + 1)) % n), table.str(ids[t][i]).str());
+        }
+    }
+}
+
+// Every id below size() must be readable while other threads intern.
+void test_str_while_interning()
+{
+    ebt::symbol_table table;
+    int const n = 100000;
+    std::atomic<int> done { 0 };
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < 2; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = t; i < n; i += 2) {
+                table.intern(std::to_string(i));
+            }
+            ++done;
+        });
+    }
+
+    bool ok = true;
+
+    while (done < 2) {
+        uint32_t size = table.size();
+
+        for (uint32_t id = 0; id < size; ++id) {
+            ebt::string_ref s = table.str(id);
+            ok = ok && s.size() > 0 && table.find(s) == id;
+        }
+    }
+
+    for (auto& t: threads) {
+        t.join();
+    }
+
+    ebt::assert_equals(true, ok);
+    ebt::assert_equals(uint32_t(n), table.size());
+}
+
+int main()
+{
+    test_intern();
+    test_many();
+    test_concurrent_intern();
+    test_str_while_interning();
+
+    return 0;
+}
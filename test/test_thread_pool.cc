@@ -0,0 +1,149 @@
+#include "ebt/assert.h"
+#include "ebt/functional.h"
+#include "ebt/thread_pool.h"
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+void test_parallel_for()
+{
+    ebt::thread_pool pool { 4 };
+
+    std::vector<int> seen(10000);
+    ebt::parallel_for(pool, seen.size(), 0, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) {
+            seen[i] += 1;
+        }
+    });
+
+    for (auto s: seen) {
+        ebt::assert_equals(1, s);
+    }
+
+    std::atomic<long> sum { 0 };
+    std::vector<int> vec(1000);
+    std::iota(vec.begin(), vec.end(), 0);
+    ebt::parallel_for(pool, vec, [&](int i) { sum += i; });
+    ebt::assert_equals(499500L, sum.load());
+}
+
+void test_parallel_map()
+{
+    ebt::thread_pool pool { 3 };
+
+    std::vector<std::string> words;
+    for (int i = 0; i < 5000; ++i) {
+        words.push_back(std::string(i % 7, 'a'));
+    }
+
+    std::vector<size_t> sizes = ebt::parallel_map(pool, words,
+        [](std::string const& s) { return s.size(); });
+
+    ebt::assert_equals(words.size(), sizes.size());
+    for (size_t i = 0; i < words.size(); ++i) {
+        ebt::assert_equals(i % 7, sizes[i]);
+    }
+
+    auto doubled = ebt::map(words, [](std::string const& s) { return s + s; });
+    std::vector<size_t> sizes2 = ebt::parallel_map(pool, doubled,
+        [](std::string const& s) { return s.size(); }, 10);
+    for (size_t i = 0; i < words.size(); ++i) {
+        ebt::assert_equals(2 * (i % 7), sizes2[i]);
+    }
+}
+
+// Results of type bool are written from neighbouring tasks, which must
+// not share the words of a std::vector<bool>.
+void test_parallel_bool()
+{
+    ebt::thread_pool pool { 4 };
+
+    std::vector<int> v(1000);
+    std::iota(v.begin(), v.end(), 0);
+
+    std::vector<bool> div = ebt::parallel_map(pool, v, [](int i) { return i % 3 == 0; }, 1);
+    ebt::assert_equals(v.size(), div.size());
+    for (size_t i = 0; i < v.size(); ++i) {
+        ebt::assert_equals(i % 3 == 0, bool(div[i]));
+    }
+
+    bool any = ebt::parallel_reduce(pool, v, false,
+        [](bool acc, int i) { return acc || i == 997; },
+        [](bool x, bool y) { return x || y; }, 1);
+    ebt::assert_equals(true, any);
+
+    bool all = ebt::parallel_reduce(pool, v, true,
+        [](bool acc, int i) { return acc && i < 999; },
+        [](bool x, bool y) { return x && y; }, 1);
+    ebt::assert_equals(false, all);
+}
+
+void test_parallel_reduce()
+{
+    ebt::thread_pool pool { 4 };
+
+    std::vector<double> a(100000);
+    std::vector<double> b(100000);
+    for (size_t i = 0; i < a.size(); ++i) {
+        a[i] = i % 10;
+        b[i] = 0.5;
+    }
+
+    double dot = ebt::parallel_reduce(pool, ebt::zip(a, b), 0.0,
+        [](double acc, std::tuple<double const&, double const&> const& t) {
+            return acc + std::get<0>(t) * std::get<1>(t);
+        },
+        [](double x, double y) { return x + y; });
+    ebt::assert_equals(225000.0, dot);
+
+    std::vector<std::string> parts {"a", "b", "c", "d", "e"};
+    std::string joined = ebt::parallel_reduce(pool, parts, std::string(),
+        [](std::string const& x, std::string const& y) { return x + y; });
+    ebt::assert_equals(std::string("abcde"), joined);
+}
+
+void test_nested()
+{
+    ebt::thread_pool pool { 2 };
+
+    std::atomic<int> count { 0 };
+    ebt::parallel_for(pool, 8, 1, [&](size_t, size_t) {
+        ebt::parallel_for(pool, 100, 1, [&](size_t b, size_t e) {
+            count += e - b;
+        });
+    });
+
+    ebt::assert_equals(800, count.load());
+}
+
+void test_exception()
+{
+    ebt::thread_pool pool { 2 };
+
+    bool thrown = false;
+    try {
+        ebt::parallel_for(pool, 100, 1, [](size_t b, size_t) {
+            if (b == 50) {
+                throw std::runtime_error("fail");
+            }
+        });
+    } catch (std::runtime_error const& e) {
+        thrown = true;
+    }
+
+    ebt::assert_equals(true, thrown);
+}
+
+int main()
+{
+    test_parallel_for();
+    test_parallel_map();
+    test_parallel_reduce();
+    test_parallel_bool();
+    test_nested();
+    test_exception();
+
+    return 0;
+}
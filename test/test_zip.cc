@@ -19,12 +19,156 @@ void test_zip()
     ebt::assert_equals(3, std::get<0>(r.front()));
     ebt::assert_equals(std::string("aaa"), std::get<1>(r.front()));
     r.pop_front();
-    ebt::assert(r.empty(), "r should be empty");
+    ebt::assert_equals(true, r.empty());
+}
+
+void test_zip_three()
+{
+    std::vector<int> a {1, 2, 3};
+    std::vector<std::string> b {"a", "aa"};
+    std::vector<double> const c {0.5, 1.5, 2.5};
+
+    double sum = 0;
+    int count = 0;
+    for (auto& t: ebt::zip(a, b, c)) {
+        ebt::assert_equals(&a[count], &std::get<0>(t));
+        sum += std::get<0>(t) * std::get<2>(t) + std::get<1>(t).size();
+        ++count;
+    }
+
+    ebt::assert_equals(2, count);
+    ebt::assert_equals(6.5, sum);
+
+    auto r = ebt::zip(a, b, c);
+    auto r2 = r;
+    r.pop_front();
+    ebt::assert_equals(1, std::get<0>(r2.front()));
+    ebt::assert_equals(2, std::get<0>(r.front()));
+}
+
+// An indexable view of a vector, for checking random-access zips.
+struct indexed {
+    using value_type = int;
+
+    std::vector<int> const* v;
+    size_t pos;
+
+    void pop_front()
+    {
+        ++pos;
+    }
+
+    int const& front() const
+    {
+        return (*v)[pos];
+    }
+
+    bool empty() const
+    {
+        return pos == v->size();
+    }
+
+    size_t size() const
+    {
+        return v->size() - pos;
+    }
+
+    int const& operator[](size_t i) const
+    {
+        return (*v)[pos + i];
+    }
+};
+
+void test_zip_random_access()
+{
+    std::vector<int> a {1, 2, 3, 4};
+    std::vector<int> b {10, 20, 30};
+
+    auto r = ebt::zip(indexed { &a, 0 }, indexed { &b, 0 });
+    static_assert(ebt::is_random_access_range<decltype(r)>::value, "");
+
+    ebt::assert_equals(size_t(3), r.size());
+    ebt::assert_equals(30, std::get<1>(r[2]));
+    ebt::assert_equals(1, std::get<0>(r.front()));
+
+    r.pop_front();
+    ebt::assert_equals(size_t(2), r.size());
+    ebt::assert_equals(3, std::get<0>(r[1]));
+    ebt::assert_equals(20, std::get<1>(r.front()));
+}
+
+// Squares of the indices, built on the fly by operator[].
+struct squares {
+    using value_type = int;
+
+    int pos;
+    int end;
+    int cache;
+
+    void pop_front()
+    {
+        ++pos;
+    }
+
+    int const& front() const
+    {
+        const_cast<int&>(cache) = pos * pos;
+        return cache;
+    }
+
+    bool empty() const
+    {
+        return pos == end;
+    }
+
+    size_t size() const
+    {
+        return end - pos;
+    }
+
+    int operator[](size_t i) const
+    {
+        return (pos + i) * (pos + i);
+    }
+};
+
+void test_zip_index_by_value()
+{
+    std::vector<int> a {1, 2, 3, 4};
+
+    auto r = ebt::zip(indexed { &a, 0 }, squares { 0, 5, 0 });
+    static_assert(ebt::is_random_access_range<decltype(r)>::value, "");
+
+    // Each call builds its own tuple, so earlier results stay intact.
+    auto const& t0 = r[0];
+    auto const& t3 = r[3];
+    ebt::assert_equals(1, std::get<0>(t0));
+    ebt::assert_equals(0, std::get<1>(t0));
+    ebt::assert_equals(4, std::get<0>(t3));
+    ebt::assert_equals(9, std::get<1>(t3));
+    ebt::assert_equals(&a[0], &std::get<0>(t0));
+
+    r.pop_front();
+    ebt::assert_equals(2, std::get<0>(r.front()));
+    ebt::assert_equals(1, std::get<1>(r.front()));
+
+    int count = 0;
+    for (auto c: ebt::chunk(r, 2)) {
+        for (auto& t: c) {
+            ++count;
+            ebt::assert_equals(a[count], std::get<0>(t));
+            ebt::assert_equals(count * count, std::get<1>(t));
+        }
+    }
+    ebt::assert_equals(3, count);
 }
 
 int main()
 {
     test_zip();
+    test_zip_three();
+    test_zip_random_access();
+    test_zip_index_by_value();
 
     return 0;
 }
@@ -0,0 +1,265 @@
+#include "ebt/thread_pool.h"
+
+namespace ebt {
+
+    namespace {
+
+        // The pool and index of the worker running on this thread.
+        thread_local thread_pool const* current_pool = nullptr;
+        thread_local int current_worker = -1;
+
+    }
+
+    thread_pool::thread_pool(int threads)
+        : pending_(0), next_(0), helpers_(0), stop_(false)
+    {
+        threads = std::max(threads, 1);
+
+        for (int i = 0; i < threads; ++i) {
+            workers_.emplace_back(new worker);
+        }
+
+        for (int i = 0; i < threads; ++i) {
+            threads_.emplace_back([this, i]() { work(i); });
+        }
+    }
+
+    thread_pool::~thread_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock { mutex_ };
+            stop_ = true;
+        }
+
+        wake_.notify_all();
+
+        for (auto& t: threads_) {
+            t.join();
+        }
+    }
+
+    int thread_pool::size() const
+    {
+        return workers_.size();
+    }
+
+    int thread_pool::self() const
+    {
+        return current_pool == this ? current_worker : -1;
+    }
+
+    void thread_pool::submit(std::function<void()> task)
+    {
+        int i = self();
+
+        if (i == -1) {
+            i = next_++ % workers_.size();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock { workers_[i]->mutex };
+            workers_[i]->tasks.push_back(std::move(task));
+        }
+
+        bool helpers;
+
+        {
+            std::lock_guard<std::mutex> lock { mutex_ };
+            ++pending_;
+            helpers = helpers_ > 0;
+        }
+
+        wake_.notify_one();
+
+        if (helpers) {
+            help_.notify_one();
+        }
+    }
+
+    bool thread_pool::take(int self, std::function<void()>& task)
+    {
+        if (pending_ == 0) {
+            return false;
+        }
+
+        if (self != -1) {
+            worker& w = *workers_[self];
+            std::lock_guard<std::mutex> lock { w.mutex };
+
+            if (!w.tasks.empty()) {
+                task = std::move(w.tasks.back());
+                w.tasks.pop_back();
+                --pending_;
+                return true;
+            }
+        }
+
+        int n = workers_.size();
+        int start = (self == -1 ? 0 : self + 1);
+
+        for (int k = 0; k < n; ++k) {
+            worker& w = *workers_[(start + k) % n];
+            std::lock_guard<std::mutex> lock { w.mutex };
+
+            if (!w.tasks.empty()) {
+                task = std::move(w.tasks.front());
+                w.tasks.pop_front();
+                --pending_;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool thread_pool::run_one()
+    {
+        std::function<void()> task;
+
+        if (!take(self(), task)) {
+            return false;
+        }
+
+        task();
+
+        return true;
+    }
+
+    void thread_pool::work(int self)
+    {
+        current_pool = this;
+        current_worker = self;
+
+        std::function<void()> task;
+
+        while (true) {
+            if (take(self, task)) {
+                task();
+                task = nullptr;
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock { mutex_ };
+            wake_.wait(lock, [&]() { return stop_ || pending_ > 0; });
+
+            if (stop_ && pending_ == 0) {
+                break;
+            }
+        }
+    }
+
+    void thread_pool::wait_for_work(std::atomic<size_t> const& count)
+    {
+        std::unique_lock<std::mutex> lock { mutex_ };
+        ++helpers_;
+        help_.wait(lock, [&]() { return pending_ > 0 || count == 0; });
+        --helpers_;
+    }
+
+    void thread_pool::notify_helpers()
+    {
+        // Taking the lock makes sure a helper that saw the old count is
+        // already asleep, and so gets the notification.
+        {
+            std::lock_guard<std::mutex> lock { mutex_ };
+        }
+
+        help_.notify_all();
+    }
+
+    task_group::task_group(thread_pool& pool)
+        : pool_(pool), count_(0)
+    {}
+
+    task_group::~task_group()
+    {
+        try {
+            wait();
+        } catch (...) {
+        }
+    }
+
+    void task_group::run(std::function<void()> task)
+    {
+        ++count_;
+
+        pool_.submit([this, task]() {
+            try {
+                task();
+            } catch (...) {
+                std::lock_guard<std::mutex> lock { mutex_ };
+                if (!error_) {
+                    error_ = std::current_exception();
+                }
+            }
+
+            // The group may be gone as soon as the count reaches zero, so
+            // only the pool is touched after the decrement.
+            thread_pool& pool = pool_;
+            if (--count_ == 0) {
+                pool.notify_helpers();
+            }
+        });
+    }
+
+    void task_group::wait()
+    {
+        // Help with queued work, and sleep when there is none until either
+        // more is queued, possibly by the tasks waited for, or the last of
+        // them finishes.
+        while (count_ != 0) {
+            if (!pool_.run_one()) {
+                pool_.wait_for_work(count_);
+            }
+        }
+
+        std::exception_ptr error;
+
+        {
+            std::lock_guard<std::mutex> lock { mutex_ };
+            std::swap(error, error_);
+        }
+
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    size_t auto_grain(thread_pool const& pool, size_t n)
+    {
+        return std::max<size_t>(1, n / (8 * size_t(pool.size())));
+    }
+
+    void parallel_for(thread_pool& pool, size_t n, size_t grain,
+        std::function<void(size_t, size_t)> f)
+    {
+        if (grain == 0) {
+            grain = auto_grain(pool, n);
+        }
+
+        if (n <= grain) {
+            if (n > 0) {
+                f(0, n);
+            }
+            return;
+        }
+
+        task_group group { pool };
+
+        for (size_t b = grain; b < n; b += grain) {
+            size_t e = std::min(b + grain, n);
+            group.run([&f, b, e]() { f(b, e); });
+        }
+
+        // The calling thread takes the first piece itself.
+        try {
+            f(0, grain);
+        } catch (...) {
+            group.wait();
+            throw;
+        }
+
+        group.wait();
+    }
+
+}
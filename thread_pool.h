@@ -0,0 +1,223 @@
+#ifndef EBT_THREAD_POOL_H
+#define EBT_THREAD_POOL_H
+
+#include "ebt/range.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace ebt {
+
+    // A fixed set of worker threads, each with a deque of tasks.  A worker
+    // takes its newest task first and, when it runs out, steals the
+    // oldest task of another worker.  Tasks submitted from a worker go to
+    // its own deque, so nested parallelism stays local.
+    class thread_pool {
+    public:
+        explicit thread_pool(int threads = std::thread::hardware_concurrency());
+        ~thread_pool();
+
+        thread_pool(thread_pool const&) = delete;
+        thread_pool& operator=(thread_pool const&) = delete;
+
+        int size() const;
+
+        void submit(std::function<void()> task);
+
+        // Runs one queued task on the calling thread, if there is any.
+        bool run_one();
+
+    private:
+        friend class task_group;
+
+        struct worker {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        std::vector<std::unique_ptr<worker>> workers_;
+        std::vector<std::thread> threads_;
+
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        std::condition_variable help_;
+        std::atomic<size_t> pending_;
+        std::atomic<size_t> next_;
+        size_t helpers_;
+        bool stop_;
+
+        int self() const;
+        bool take(int self, std::function<void()>& task);
+        void work(int self);
+
+        // Sleeps until a task is queued or count drops to zero.  Whoever
+        // brings count to zero calls notify_helpers afterwards.
+        void wait_for_work(std::atomic<size_t> const& count);
+        void notify_helpers();
+    };
+
+    // Tasks that can be waited for together.  The waiting thread runs
+    // queued tasks while it waits, so waiting from inside a task does not
+    // starve the pool.  The first exception thrown by a task is rethrown
+    // by wait.
+    class task_group {
+    public:
+        explicit task_group(thread_pool& pool);
+        ~task_group();
+
+        task_group(task_group const&) = delete;
+        task_group& operator=(task_group const&) = delete;
+
+        void run(std::function<void()> task);
+
+        void wait();
+
+    private:
+        thread_pool& pool_;
+        std::atomic<size_t> count_;
+
+        std::mutex mutex_;
+        std::exception_ptr error_;
+    };
+
+    // A piece size that gives every thread of the pool several pieces of
+    // [0, n), so that stealing can even out uneven pieces.
+    size_t auto_grain(thread_pool const& pool, size_t n);
+
+    // Calls f(b, e) on the pieces [k * grain, (k + 1) * grain) of [0, n),
+    // on the pool, and returns when all are done.  A grain of 0 means
+    // auto_grain.
+    void parallel_for(thread_pool& pool, size_t n, size_t grain,
+        std::function<void(size_t, size_t)> f);
+
+    template <class range, class func>
+    typename std::enable_if<is_random_access_range<range>::value>::type
+    parallel_for(thread_pool& pool, range const& r, func f, size_t grain = 0)
+    {
+        // operator[] of a random-access range leaves the range alone, so
+        // all the pieces index r itself.
+        parallel_for(pool, r.size(), grain, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) {
+                f(r[i]);
+            }
+        });
+    }
+
+    template <class container, class func,
+        class = typename std::enable_if<!is_range<container>::value>::type>
+    void parallel_for(thread_pool& pool, container const& con, func f, size_t grain = 0)
+    {
+        parallel_for(pool, make_range(con), f, grain);
+    }
+
+    // Storage for results written by concurrent tasks, one slot per task
+    // or element.  std::vector<bool> packs its elements into shared words,
+    // so bools are kept as chars until all the tasks are done.
+    template <class T>
+    struct parallel_buffer {
+        using type = std::vector<T>;
+
+        static std::vector<T> finish(type& buf)
+        {
+            return std::move(buf);
+        }
+    };
+
+    template <>
+    struct parallel_buffer<bool> {
+        using type = std::vector<char>;
+
+        static std::vector<bool> finish(type& buf)
+        {
+            return std::vector<bool>(buf.begin(), buf.end());
+        }
+    };
+
+    // Returns f applied to every element, in order.
+    template <class range, class func>
+    typename std::enable_if<is_random_access_range<range>::value,
+        std::vector<typename std::decay<typename std::result_of<
+            func(typename range::value_type const&)>::type>::type>>::type
+    parallel_map(thread_pool& pool, range const& r, func f, size_t grain = 0)
+    {
+        using buffer = parallel_buffer<typename std::decay<typename std::result_of<
+            func(typename range::value_type const&)>::type>::type>;
+
+        typename buffer::type result(r.size());
+
+        parallel_for(pool, r.size(), grain, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) {
+                result[i] = f(r[i]);
+            }
+        });
+
+        return buffer::finish(result);
+    }
+
+    template <class container, class func,
+        class = typename std::enable_if<!is_range<container>::value>::type>
+    std::vector<typename std::decay<typename std::result_of<
+        func(typename container::value_type const&)>::type>::type>
+    parallel_map(thread_pool& pool, container const& con, func f, size_t grain = 0)
+    {
+        return parallel_map(pool, make_range(con), f, grain);
+    }
+
+    // Folds every piece with acc = reduce(acc, element), starting from
+    // init, and then folds the pieces in order with combine.  init should
+    // be an identity of combine.
+    template <class range, class T, class reduce_func, class combine_func>
+    typename std::enable_if<is_random_access_range<range>::value, T>::type
+    parallel_reduce(thread_pool& pool, range const& r, T init,
+        reduce_func reduce, combine_func combine, size_t grain = 0)
+    {
+        if (grain == 0) {
+            grain = auto_grain(pool, r.size());
+        }
+
+        size_t pieces = (r.size() + grain - 1) / grain;
+        typename parallel_buffer<T>::type partial(pieces, init);
+
+        parallel_for(pool, r.size(), grain, [&](size_t b, size_t e) {
+            T acc = init;
+
+            for (size_t i = b; i < e; ++i) {
+                acc = reduce(acc, r[i]);
+            }
+
+            partial[b / grain] = std::move(acc);
+        });
+
+        T result = init;
+        for (auto& p: partial) {
+            result = combine(result, p);
+        }
+
+        return result;
+    }
+
+    template <class range, class T, class func>
+    typename std::enable_if<is_random_access_range<range>::value, T>::type
+    parallel_reduce(thread_pool& pool, range const& r, T init, func op)
+    {
+        return parallel_reduce(pool, r, init, op, op);
+    }
+
+    template <class container, class T, class... funcs,
+        class = typename std::enable_if<!is_range<container>::value>::type>
+    T parallel_reduce(thread_pool& pool, container const& con, T init, funcs... fs)
+    {
+        return parallel_reduce(pool, make_range(con), init, fs...);
+    }
+
+}
+
+#endif
@@ -0,0 +1,417 @@
+#include "ebt/utf8.h"
+#include "ebt/simd.h"
+
+#if EBT_SSE2
+#include <emmintrin.h>
+#endif
+
+#if EBT_AVX2_DISPATCH
+#include <tmmintrin.h>
+#include <immintrin.h>
+#endif
+
+namespace ebt {
+
+#if EBT_AVX2_DISPATCH
+    // Validation after Keiser and Lemire, "Validating UTF-8 in less than
+    // one instruction per byte".  Every pair of adjacent bytes is looked
+    // up in three tables, by the high and the low nibble of the first
+    // byte and the high nibble of the second, and an error bit that is
+    // set in all three lookups marks an ill-formed pair.  The pairs leave
+    // out the third and fourth bytes of longer sequences, which are
+    // checked by comparing where continuations must be with where the
+    // tables found them.
+
+    namespace {
+
+        unsigned char const too_short = 1 << 0;       // 11______ 0_______, 11______ 11______
+        unsigned char const too_long = 1 << 1;        // 0_______ 10______
+        unsigned char const overlong_3 = 1 << 2;      // 11100000 100_____
+        unsigned char const too_large = 1 << 3;       // 11110100 1001____, 11110100 101_____
+        unsigned char const surrogate = 1 << 4;       // 11101101 101_____
+        unsigned char const overlong_2 = 1 << 5;      // 1100000_ 10______
+        unsigned char const too_large_1000 = 1 << 6;  // 11110101 1000____ and above
+        unsigned char const overlong_4 = 1 << 6;      // 11110000 1000____
+        unsigned char const two_conts = 1 << 7;       // 10______ 10______
+
+        unsigned char const carry = too_short | too_long | two_conts;
+
+        unsigned char const byte_1_high[16] = {
+            too_long, too_long, too_long, too_long,
+            too_long, too_long, too_long, too_long,
+            two_conts, two_conts, two_conts, two_conts,
+            too_short | overlong_2,
+            too_short,
+            too_short | overlong_3 | surrogate,
+            too_short | too_large | too_large_1000 | overlong_4
+        };
+
+        unsigned char const byte_1_low[16] = {
+            carry | overlong_3 | overlong_2 | overlong_4,
+            carry | overlong_2,
+            carry,
+            carry,
+            carry | too_large,
+            carry | too_large | too_large_1000,
+            carry | too_large | too_large_1000,
+            carry | too_large | too_large_1000,
+            carry | too_large | too_large_1000,
+            carry | too_large | too_large_1000,
+            carry | too_large | too_large_1000,
+            carry | too_large | too_large_1000,
+            carry | too_large | too_large_1000,
+            carry | too_large | too_large_1000 | surrogate,
+            carry | too_large | too_large_1000,
+            carry | too_large | too_large_1000
+        };
+
+        unsigned char const byte_2_high[16] = {
+            too_short, too_short, too_short, too_short,
+            too_short, too_short, too_short, too_short,
+            too_long | overlong_2 | two_conts | overlong_3 | too_large_1000 | overlong_4,
+            too_long | overlong_2 | two_conts | overlong_3 | too_large,
+            too_long | overlong_2 | two_conts | surrogate | too_large,
+            too_long | overlong_2 | two_conts | surrogate | too_large,
+            too_short, too_short, too_short, too_short
+        };
+
+        // A block whose last bytes are these or above ends inside a
+        // character.
+        unsigned char const incomplete[32] = {
+            0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+            0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+            0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+            0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1
+        };
+
+        // Backs the end i of a checked prefix up to the start of a
+        // character that runs past it.
+        size_t char_boundary(unsigned char const* p, size_t i)
+        {
+            if (i >= 1 && p[i - 1] >= 0xC0) {
+                return i - 1;
+            } else if (i >= 2 && p[i - 2] >= 0xE0) {
+                return i - 2;
+            } else if (i >= 3 && p[i - 3] >= 0xF0) {
+                return i - 3;
+            }
+
+            return i;
+        }
+
+    }
+
+    // Each kernel returns the length of a prefix of p that is valid and
+    // ends at a character boundary.  It stops at the first block with an
+    // error, and the scalar loop finds the exact offset from there.
+
+    EBT_TARGET_SSSE3
+    size_t valid_utf8_prefix_ssse3(unsigned char const* p, size_t size)
+    {
+        __m128i const b1h = _mm_loadu_si128(reinterpret_cast<__m128i const*>(byte_1_high));
+        __m128i const b1l = _mm_loadu_si128(reinterpret_cast<__m128i const*>(byte_1_low));
+        __m128i const b2h = _mm_loadu_si128(reinterpret_cast<__m128i const*>(byte_2_high));
+        __m128i const max_value = _mm_loadu_si128(
+            reinterpret_cast<__m128i const*>(incomplete + 16));
+        __m128i const nibble = _mm_set1_epi8(0x0F);
+        __m128i const third = _mm_set1_epi8(0xE0 - 0x80);
+        __m128i const fourth = _mm_set1_epi8(0xF0 - 0x80);
+        __m128i const high_bit = _mm_set1_epi8(char(0x80));
+        __m128i const zero = _mm_setzero_si128();
+
+        __m128i prev = zero;
+        __m128i prev_incomplete = zero;
+
+        size_t i = 0;
+        for (; i + 16 <= size; i += 16) {
+            __m128i in = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + i));
+            __m128i error = prev_incomplete;
+
+            if (_mm_movemask_epi8(in) != 0) {
+                __m128i prev1 = _mm_alignr_epi8(in, prev, 15);
+                __m128i prev2 = _mm_alignr_epi8(in, prev, 14);
+                __m128i prev3 = _mm_alignr_epi8(in, prev, 13);
+
+                __m128i special = _mm_and_si128(_mm_and_si128(
+                    _mm_shuffle_epi8(b1h, _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)),
+                    _mm_shuffle_epi8(b1l, _mm_and_si128(prev1, nibble))),
+                    _mm_shuffle_epi8(b2h, _mm_and_si128(_mm_srli_epi16(in, 4), nibble)));
+
+                __m128i must23 = _mm_or_si128(_mm_subs_epu8(prev2, third),
+                    _mm_subs_epu8(prev3, fourth));
+
+                error = _mm_xor_si128(_mm_and_si128(must23, high_bit), special);
+                prev_incomplete = _mm_subs_epu8(in, max_value);
+            } else {
+                prev_incomplete = zero;
+            }
+
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(error, zero)) != 0xFFFF) {
+                break;
+            }
+
+            prev = in;
+        }
+
+        return char_boundary(p, i);
+    }
+
+    EBT_TARGET_AVX2
+    size_t valid_utf8_prefix_avx2(unsigned char const* p, size_t size)
+    {
+        __m256i const b1h = _mm256_broadcastsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<__m128i const*>(byte_1_high)));
+        __m256i const b1l = _mm256_broadcastsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<__m128i const*>(byte_1_low)));
+        __m256i const b2h = _mm256_broadcastsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<__m128i const*>(byte_2_high)));
+        __m256i const max_value = _mm256_loadu_si256(
+            reinterpret_cast<__m256i const*>(incomplete));
+        __m256i const nibble = _mm256_set1_epi8(0x0F);
+        __m256i const third = _mm256_set1_epi8(0xE0 - 0x80);
+        __m256i const fourth = _mm256_set1_epi8(0xF0 - 0x80);
+        __m256i const high_bit = _mm256_set1_epi8(char(0x80));
+        __m256i const zero = _mm256_setzero_si256();
+
+        __m256i prev = zero;
+        __m256i prev_incomplete = zero;
+
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32) {
+            __m256i in = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p + i));
+            __m256i error = prev_incomplete;
+
+            if (_mm256_movemask_epi8(in) != 0) {
+                // The last bytes of prev, then the first of in, so that
+                // alignr can shift across the two lanes.
+                __m256i carried = _mm256_permute2x128_si256(prev, in, 0x21);
+                __m256i prev1 = _mm256_alignr_epi8(in, carried, 15);
+                __m256i prev2 = _mm256_alignr_epi8(in, carried, 14);
+                __m256i prev3 = _mm256_alignr_epi8(in, carried, 13);
+
+                __m256i special = _mm256_and_si256(_mm256_and_si256(
+                    _mm256_shuffle_epi8(b1h, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble)),
+                    _mm256_shuffle_epi8(b1l, _mm256_and_si256(prev1, nibble))),
+                    _mm256_shuffle_epi8(b2h, _mm256_and_si256(_mm256_srli_epi16(in, 4), nibble)));
+
+                __m256i must23 = _mm256_or_si256(_mm256_subs_epu8(prev2, third),
+                    _mm256_subs_epu8(prev3, fourth));
+
+                error = _mm256_xor_si256(_mm256_and_si256(must23, high_bit), special);
+                prev_incomplete = _mm256_subs_epu8(in, max_value);
+            } else {
+                prev_incomplete = zero;
+            }
+
+            if (!_mm256_testz_si256(error, error)) {
+                break;
+            }
+
+            prev = in;
+        }
+
+        return char_boundary(p, i);
+    }
+#endif
+
+#if EBT_AVX2_DISPATCH
+    EBT_TARGET_AVX2
+    size_t ascii_prefix_avx2(char const* p, size_t size)
+    {
+        size_t i = 0;
+
+        for (; i + 32 <= size; i += 32) {
+            int mask = _mm256_movemask_epi8(_mm256_loadu_si256(
+                reinterpret_cast<__m256i const*>(p + i)));
+
+            if (mask != 0) {
+                return i + __builtin_ctz(mask);
+            }
+        }
+
+        return i;
+    }
+#endif
+
+    // Returns the length of the longest prefix of p that is all ASCII.
+    size_t ascii_prefix(char const* p, size_t size)
+    {
+        size_t i = 0;
+
+#if EBT_AVX2_DISPATCH
+        if (cpu_has_avx2()) {
+            i = ascii_prefix_avx2(p, size);
+
+            if (i + 32 <= size) {
+                return i;
+            }
+        }
+#endif
+
+#if EBT_SSE2
+        for (; i + 16 <= size; i += 16) {
+            int mask = _mm_movemask_epi8(_mm_loadu_si128(
+                reinterpret_cast<__m128i const*>(p + i)));
+
+            if (mask != 0) {
+                return i + __builtin_ctz(mask);
+            }
+        }
+#endif
+
+        while (i < size && (unsigned char) p[i] < 0x80) {
+            ++i;
+        }
+
+        return i;
+    }
+
+    int utf8_char_length(char const* s, size_t size)
+    {
+        unsigned char const* p = reinterpret_cast<unsigned char const*>(s);
+
+        auto cont = [&](size_t i, unsigned char lo, unsigned char hi) {
+            return i < size && lo <= p[i] && p[i] <= hi;
+        };
+
+        unsigned char c = p[0];
+
+        if (c < 0x80) {
+            return 1;
+        } else if (c < 0xC2) {
+            return 0;
+        } else if (c < 0xE0) {
+            return cont(1, 0x80, 0xBF) ? 2 : 0;
+        } else if (c < 0xF0) {
+            unsigned char lo = (c == 0xE0 ? 0xA0 : 0x80);
+            unsigned char hi = (c == 0xED ? 0x9F : 0xBF);
+            return cont(1, lo, hi) && cont(2, 0x80, 0xBF) ? 3 : 0;
+        } else if (c < 0xF5) {
+            unsigned char lo = (c == 0xF0 ? 0x90 : 0x80);
+            unsigned char hi = (c == 0xF4 ? 0x8F : 0xBF);
+            return cont(1, lo, hi) && cont(2, 0x80, 0xBF) && cont(3, 0x80, 0xBF) ? 4 : 0;
+        } else {
+            return 0;
+        }
+    }
+
+    size_t find_invalid_utf8(string_ref s)
+    {
+        size_t i = 0;
+
+#if EBT_AVX2_DISPATCH
+        unsigned char const* p = reinterpret_cast<unsigned char const*>(s.data());
+
+        if (cpu_has_avx2()) {
+            i = valid_utf8_prefix_avx2(p, s.size());
+        }
+
+        if (cpu_has_ssse3()) {
+            i += valid_utf8_prefix_ssse3(p + i, s.size() - i);
+        }
+#endif
+
+        while (i < s.size()) {
+            i += ascii_prefix(s.data() + i, s.size() - i);
+
+            while (i < s.size() && (unsigned char) s[i] >= 0x80) {
+                int n = utf8_char_length(s.data() + i, s.size() - i);
+
+                if (n == 0) {
+                    return i;
+                }
+
+                i += n;
+            }
+        }
+
+        return string_ref::npos;
+    }
+
+    bool is_valid_utf8(string_ref s)
+    {
+        return find_invalid_utf8(s) == string_ref::npos;
+    }
+
+    size_t utf8_offsets(string_ref s, uint32_t* offsets)
+    {
+        size_t count = 0;
+        size_t i = 0;
+
+        while (i < s.size()) {
+            size_t n = ascii_prefix(s.data() + i, s.size() - i);
+
+            for (size_t k = 0; k < n; ++k) {
+                offsets[count++] = i + k;
+            }
+            i += n;
+
+            while (i < s.size() && (unsigned char) s[i] >= 0x80) {
+                offsets[count++] = i;
+                int len = utf8_char_length(s.data() + i, s.size() - i);
+                i += (len == 0 ? 1 : len);
+            }
+        }
+
+        return count;
+    }
+
+    char32_t decode_utf8_char(char const* s, int size)
+    {
+        unsigned char const* p = reinterpret_cast<unsigned char const*>(s);
+
+        switch (size) {
+        case 1:
+            return p[0];
+        case 2:
+            return (char32_t(p[0] & 0x1F) << 6) | (p[1] & 0x3F);
+        case 3:
+            return (char32_t(p[0] & 0x0F) << 12) | (char32_t(p[1] & 0x3F) << 6)
+                | (p[2] & 0x3F);
+        case 4:
+            return (char32_t(p[0] & 0x07) << 18) | (char32_t(p[1] & 0x3F) << 12)
+                | (char32_t(p[2] & 0x3F) << 6) | (p[3] & 0x3F);
+        default:
+            return 0xFFFD;
+        }
+    }
+
+    size_t decode_utf8(string_ref s, char32_t* codepoints)
+    {
+        size_t count = 0;
+        size_t i = 0;
+
+        while (i < s.size()) {
+            size_t n = ascii_prefix(s.data() + i, s.size() - i);
+
+            for (size_t k = 0; k < n; ++k) {
+                codepoints[count++] = (unsigned char) s[i + k];
+            }
+            i += n;
+
+            while (i < s.size() && (unsigned char) s[i] >= 0x80) {
+                int len = utf8_char_length(s.data() + i, s.size() - i);
+                codepoints[count++] = decode_utf8_char(s.data() + i, len);
+                i += (len == 0 ? 1 : len);
+            }
+        }
+
+        return count;
+    }
+
+    void codepoint_range::decode()
+    {
+        if (chars_.empty()) {
+            return;
+        }
+
+        string_ref c = chars_.front();
+
+        if (c.size() == 1 && (unsigned char) c[0] >= 0x80) {
+            front_ = 0xFFFD;
+        } else {
+            front_ = decode_utf8_char(c.data(), c.size());
+        }
+    }
+
+}
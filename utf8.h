@@ -0,0 +1,132 @@
+#ifndef EBT_UTF8_H
+#define EBT_UTF8_H
+
+#include "ebt/range.h"
+#include "ebt/string_ref.h"
+#include <cstdint>
+
+namespace ebt {
+
+    // Returns the byte offset of the first ill-formed sequence in s, or
+    // string_ref::npos if s is valid UTF-8.  Overlong forms, surrogates
+    // and code points above U+10FFFF are ill-formed.
+    size_t find_invalid_utf8(string_ref s);
+
+    bool is_valid_utf8(string_ref s);
+
+    // Returns the length of the well-formed character at the start of p,
+    // or 0 if it is ill-formed.  size must be at least 1.
+    int utf8_char_length(char const* p, size_t size);
+
+    // Writes the byte offset of every character of s into offsets and
+    // returns the number of characters.  offsets must have room for
+    // s.size() entries.  An ill-formed byte counts as one character.
+    size_t utf8_offsets(string_ref s, uint32_t* offsets);
+
+    // Decodes s into codepoints, which must have room for s.size()
+    // entries, and returns the number of code points.  Ill-formed bytes
+    // decode to U+FFFD.
+    size_t decode_utf8(string_ref s, char32_t* codepoints);
+
+    // A range over the characters of a string as views, without
+    // allocating.  An ill-formed byte is a character on its own.
+    class utf8_char_range {
+    public:
+        using value_type = string_ref;
+
+        explicit utf8_char_range(string_ref s)
+            : end_(s.data() + s.size())
+        {
+            next(s.data());
+        }
+
+        void pop_front()
+        {
+            next(front_.data() + front_.size());
+        }
+
+        value_type const& front() const
+        {
+            return front_;
+        }
+
+        bool empty() const
+        {
+            return front_.data() == end_;
+        }
+
+        range_iterator<utf8_char_range> begin()
+        {
+            return range_iterator<utf8_char_range>(*this);
+        }
+
+        range_iterator<utf8_char_range> end()
+        {
+            return range_iterator<utf8_char_range>();
+        }
+
+    private:
+        char const* end_;
+        string_ref front_;
+
+        void next(char const* p)
+        {
+            if (p == end_) {
+                front_ = string_ref(p, 0);
+            } else if ((unsigned char) *p < 0x80) {
+                front_ = string_ref(p, 1);
+            } else {
+                int n = utf8_char_length(p, end_ - p);
+                front_ = string_ref(p, n == 0 ? 1 : n);
+            }
+        }
+    };
+
+    // A range over the code points of a string.  Ill-formed bytes
+    // decode to U+FFFD.
+    class codepoint_range {
+    public:
+        using value_type = char32_t;
+
+        explicit codepoint_range(string_ref s)
+            : chars_(s)
+        {
+            decode();
+        }
+
+        void pop_front()
+        {
+            chars_.pop_front();
+            decode();
+        }
+
+        value_type const& front() const
+        {
+            return front_;
+        }
+
+        bool empty() const
+        {
+            return chars_.empty();
+        }
+
+        range_iterator<codepoint_range> begin()
+        {
+            return range_iterator<codepoint_range>(*this);
+        }
+
+        range_iterator<codepoint_range> end()
+        {
+            return range_iterator<codepoint_range>();
+        }
+
+    private:
+        utf8_char_range chars_;
+        char32_t front_;
+
+        void decode();
+    };
+
+}
+
+#endif